@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "analysisservice.h"
+
+// cache size in kilobytes, a probability takes four bytes per cell
+static const int CACHE_SIZE = 64*1024;
+
+AnalysisService::AnalysisService(QObject* parent)
+    : QObject(parent), m_cache(CACHE_SIZE)
+{
+    // one position at a time, a new move makes the running one useless
+    m_pool.setMaxThreadCount(1);
+}
+
+AnalysisService::~AnalysisService()
+{
+    m_generation.ref();
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void AnalysisService::setTopology(const BoardTopology& topology)
+{
+    // same cells mean another position on another topology
+    m_generation.ref();
+    m_pool.clear();
+    m_cache.clear();
+    m_view = BoardView();
+    m_topology = topology;
+}
+
+void AnalysisService::analyse(const BoardView& view)
+{
+    const bool samePosition = view.hash() == m_view.hash();
+    m_view = view;
+    if(samePosition)
+        return;
+
+    // whatever is running is about an older position
+    const int generation = m_generation.fetchAndAddOrdered(1) + 1;
+    m_pool.clear();
+
+    if(m_cache.contains(view.hash()))
+    {
+        Q_EMIT analysisReady();
+        return;
+    }
+
+    const BoardTopology topology = m_topology;
+    m_pool.start([this, generation, view, topology]() {
+        const BoardAnalysis analysis = Solver::analyse(topology, view.numMines(),
+                                                       view.cells(), [this, generation]() {
+            return m_generation.loadAcquire() != generation;
+        });
+        if(!analysis.isValid())
+            return;
+        QMetaObject::invokeMethod(this, [this, view, analysis]() {
+            onAnalysed(view.hash(), analysis);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AnalysisService::onAnalysed(quint64 hash, const BoardAnalysis& analysis)
+{
+    m_cache.insert(hash, new BoardAnalysis(analysis), 1 + analysis.mineProbability.size()*sizeof(float)/1024);
+    if(hash == m_view.hash())
+        Q_EMIT analysisReady();
+}
+
+const BoardAnalysis* AnalysisService::analysis() const
+{
+    return m_cache.object(m_view.hash());
+}
+
+int AnalysisService::hintCell() const
+{
+    const BoardAnalysis* current = analysis();
+    if(!current)
+        return -1;
+
+    // the player may have flagged a safe cell, prefer the other ones
+    for(int idx : current->safeCells)
+    {
+        if(m_view.cell(idx) == BoardView::Covered)
+            return idx;
+    }
+
+    int best = -1;
+    const int numCells = m_view.numRows()*m_view.numCols();
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(m_view.cell(idx) != BoardView::Covered)
+            continue;
+        if(best == -1 || current->mineProbability.at(idx) < current->mineProbability.at(best))
+            best = idx;
+    }
+    return best;
+}
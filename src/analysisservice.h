@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef ANALYSISSERVICE_H
+#define ANALYSISSERVICE_H
+
+// own
+#include "boardtopology.h"
+#include "boardview.h"
+#include "solver.h"
+// Qt
+#include <QAtomicInt>
+#include <QCache>
+#include <QObject>
+#include <QThreadPool>
+
+/**
+ * Analyses the board in the background while the player thinks.
+ *
+ * Every published version of the board is analysed on a worker
+ * thread, stale work is dropped as soon as a newer version arrives.
+ * Results are cached by the hash of the position, so asking for
+ * a hint never waits for the solver.
+ */
+class AnalysisService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnalysisService(QObject* parent = nullptr);
+    ~AnalysisService() override;
+    /**
+     * Sets which cells are neighbours on the boards analysed from now on
+     */
+    void setTopology(const BoardTopology& topology);
+    /**
+     * Starts analysing a new version of the board,
+     * unless the position is cached already
+     */
+    void analyse(const BoardView& view);
+    /**
+     * @return analysis of the current position, null if not ready yet
+     */
+    const BoardAnalysis* analysis() const;
+    /**
+     * @return covered cell the player should open next, the least
+     * likely to hold a mine, or -1 if the analysis is not ready
+     */
+    int hintCell() const;
+Q_SIGNALS:
+    /**
+     * Emitted when analysis of the current position becomes available
+     */
+    void analysisReady();
+private:
+    void onAnalysed(quint64 hash, const BoardAnalysis& analysis);
+
+    /**
+     * Latest version passed to analyse()
+     */
+    BoardView m_view;
+    BoardTopology m_topology;
+    QCache<quint64, BoardAnalysis> m_cache;
+    /**
+     * Incremented with every request, workers give up
+     * as soon as it doesn't match the value they started with
+     */
+    QAtomicInt m_generation;
+    QThreadPool m_pool;
+};
+
+#endif
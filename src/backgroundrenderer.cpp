@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "backgroundrenderer.h"
+
+// KDEGames
+#include <KGameRenderer>
+#include <KgThemeProvider>
+// Std
+#include <cmath>
+
+// render sizes are rounded up to multiples of this
+static const int BACKGROUND_BUCKET = 128;
+// backgrounds kept for recently used sizes, a 4K one takes about 32 MiB
+static const int MAX_CACHED_BACKGROUNDS = 3;
+
+BackgroundRenderer::BackgroundRenderer(KGameRenderer* renderer, QObject* parent)
+    : QObject(parent), KGameRendererClient(renderer, QStringLiteral( "mainWidget" ))
+{
+    connect(renderer->themeProvider(), &KgThemeProvider::currentThemeChanged, this, &BackgroundRenderer::clear);
+}
+
+void BackgroundRenderer::clear()
+{
+    // the current pixmap is stretched until the new theme is rendered
+    m_pixmaps.clear();
+}
+
+void BackgroundRenderer::setTargetSize(const QSize& size)
+{
+    if(size.isEmpty())
+        return;
+
+    auto bucket = [](int length) {
+        return qMax(1, static_cast<int>(std::ceil(qreal(length) / BACKGROUND_BUCKET))) * BACKGROUND_BUCKET;
+    };
+    const QSize bucketSize(bucket(size.width()), bucket(size.height()));
+    if(bucketSize == renderSize())
+        return;
+
+    for(int i=0; i<m_pixmaps.size(); ++i)
+    {
+        if(m_pixmaps.at(i).first == bucketSize)
+        {
+            m_pixmaps.move(i, 0);
+            m_pixmap = m_pixmaps.first().second;
+            Q_EMIT pixmapChanged();
+            break;
+        }
+    }
+    // still requested on a hit, so that theme changes render the shown size;
+    // the renderer takes it from its own cache then. The SVG is rendered by
+    // the worker threads of the renderer, full resolution doesn't block the GUI
+    setRenderSize(bucketSize);
+}
+
+void BackgroundRenderer::receivePixmap(const QPixmap& pixmap)
+{
+    m_pixmap = pixmap;
+    const QSize size = renderSize();
+    for(int i=0; i<m_pixmaps.size(); ++i)
+    {
+        if(m_pixmaps.at(i).first == size)
+        {
+            m_pixmaps.remove(i);
+            break;
+        }
+    }
+    if(m_pixmaps.size() == MAX_CACHED_BACKGROUNDS)
+        m_pixmaps.removeLast();
+    m_pixmaps.prepend(qMakePair(size, pixmap));
+    Q_EMIT pixmapChanged();
+}
+
+qint64 BackgroundRenderer::memoryUsage() const
+{
+    auto bytes = [](const QPixmap& pixmap) {
+        return qint64(pixmap.width())*pixmap.height()*pixmap.depth()/8;
+    };
+    // the current pixmap is shared with its entry, unless the theme just changed
+    qint64 total = 0;
+    bool current = false;
+    for(const auto& entry : m_pixmaps)
+    {
+        total += bytes(entry.second);
+        current = current || entry.second.cacheKey() == m_pixmap.cacheKey();
+    }
+    return current ? total : total + bytes(m_pixmap);
+}
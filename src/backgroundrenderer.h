@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BACKGROUNDRENDERER_H
+#define BACKGROUNDRENDERER_H
+
+// KDEGames
+#include <KGameRendererClient>
+// Qt
+#include <QObject>
+#include <QPair>
+#include <QPixmap>
+#include <QVector>
+
+/**
+ * Renders the scene background asynchronously.
+ *
+ * The background is rendered at full resolution, rounded up to a bucketed
+ * size, so resize steps within the same bucket need no rendering at all.
+ * Backgrounds of the few most recently used buckets are kept, so that
+ * going back to one of them shows it at once. The scene stretches the
+ * last rendered pixmap over the exposed area while a new one is being
+ * rendered.
+ */
+class BackgroundRenderer : public QObject, public KGameRendererClient
+{
+    Q_OBJECT
+public:
+    explicit BackgroundRenderer(KGameRenderer* renderer, QObject* parent = nullptr);
+    /**
+     * Requests a background for given scene size
+     */
+    void setTargetSize(const QSize& size);
+    /**
+     * @return last rendered background, may be null or of a different size
+     */
+    QPixmap pixmap() const { return m_pixmap; }
+    /**
+     * @return approximate number of bytes used by kept backgrounds
+     */
+    qint64 memoryUsage() const;
+Q_SIGNALS:
+    void pixmapChanged();
+protected:
+    void receivePixmap(const QPixmap& pixmap) override;
+private Q_SLOTS:
+    /**
+     * Drops backgrounds rendered for the previous theme
+     */
+    void clear();
+private:
+    QPixmap m_pixmap;
+    /**
+     * Backgrounds per bucketed size, most recently used size first
+     */
+    QVector<QPair<QSize, QPixmap>> m_pixmaps;
+};
+
+#endif
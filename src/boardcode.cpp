@@ -0,0 +1,275 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardcode.h"
+
+// own
+#include "fieldgenerator.h"
+// Qt
+#include <QByteArray>
+#include <QtAlgorithms>
+
+namespace
+{
+
+enum { FormatVersion = 1 };
+// number of cells coded together, C(64,k) always fits in 64 bits
+enum { BlockSize = 64 };
+
+const QByteArray::Base64Options BASE64_OPTIONS =
+    QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+
+/**
+ * Binomial coefficients C(n,k) for n,k <= BlockSize
+ */
+struct Binomials
+{
+    Binomials()
+    {
+        for(int n=0; n<=BlockSize; ++n)
+        {
+            c[n][0] = 1;
+            for(int k=1; k<=BlockSize; ++k)
+                c[n][k] = n == 0 ? 0 : c[n-1][k-1] + c[n-1][k];
+        }
+    }
+    quint64 c[BlockSize+1][BlockSize+1];
+};
+
+const Binomials& binomials()
+{
+    static const Binomials table;
+    return table;
+}
+
+// number of bits needed to write any value in [0, maxValue]
+int bitsFor(quint64 maxValue)
+{
+    return maxValue == 0 ? 0 : 64 - qCountLeadingZeroBits(maxValue);
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray* data) : m_data(data) {}
+    void write(quint64 value, int bits)
+    {
+        for(int i=bits-1; i>=0; --i)
+        {
+            if(m_used == 0)
+                m_data->append('\0');
+            if(value >> i & 1)
+                (*m_data)[m_data->size()-1] |= char(0x80 >> m_used);
+            m_used = (m_used + 1) % 8;
+        }
+    }
+private:
+    QByteArray* m_data;
+    int m_used = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const QByteArray& data, int offset) : m_data(data), m_pos(qint64(offset)*8) {}
+    bool read(int bits, quint64* value)
+    {
+        if(m_pos + bits > qint64(m_data.size())*8)
+            return false;
+        quint64 result = 0;
+        for(int i=0; i<bits; ++i, ++m_pos)
+            result = result << 1 | (uchar(m_data.at(m_pos / 8)) >> (7 - m_pos % 8) & 1);
+        *value = result;
+        return true;
+    }
+private:
+    const QByteArray& m_data;
+    qint64 m_pos;
+};
+
+void writeVarint(QByteArray* data, quint32 value)
+{
+    while(value >= 0x80)
+    {
+        data->append(char(value & 0x7f | 0x80));
+        value >>= 7;
+    }
+    data->append(char(value));
+}
+
+bool readVarint(const QByteArray& data, int* pos, quint32* value)
+{
+    quint32 result = 0;
+    for(int shift=0; shift<35; shift+=7)
+    {
+        if(*pos >= data.size())
+            return false;
+        const uchar byte = data.at((*pos)++);
+        result |= quint32(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+BoardCode BoardCode::fromSeed(int numRows, int numCols, int numMines, int clickedIdx, quint32 seed)
+{
+    BoardCode code;
+    code.m_kind = Seeded;
+    code.m_numRows = numRows;
+    code.m_numCols = numCols;
+    code.m_numMines = numMines;
+    code.m_clickedIdx = clickedIdx;
+    code.m_seed = seed;
+    return code;
+}
+
+BoardCode BoardCode::fromField(int numRows, int numCols, const QVector<qint8>& field, int clickedIdx)
+{
+    Q_ASSERT(field.size() == numRows*numCols);
+
+    BoardCode code;
+    code.m_kind = Layout;
+    code.m_numRows = numRows;
+    code.m_numCols = numCols;
+    code.m_clickedIdx = clickedIdx;
+    code.m_mines.resize(field.size());
+    for(int i=0; i<field.size(); ++i)
+    {
+        code.m_mines[i] = field.at(i) == FieldGenerator::Mine;
+        if(code.m_mines.at(i))
+            code.m_numMines++;
+    }
+    return code;
+}
+
+QVector<qint8> BoardCode::field() const
+{
+    switch(m_kind)
+    {
+        case Seeded:
+            return FieldGenerator::generate(m_numRows, m_numCols, m_numMines, m_clickedIdx, m_seed);
+        case Layout:
+        {
+            QVector<qint8> field(m_mines.size(), 0);
+            for(int i=0; i<m_mines.size(); ++i)
+                if(m_mines.at(i))
+                    field[i] = FieldGenerator::Mine;
+            FieldGenerator::computeDigits(m_numRows, m_numCols, field);
+            return field;
+        }
+        case Invalid:
+            break;
+    }
+    return QVector<qint8>();
+}
+
+QString BoardCode::toString() const
+{
+    if(m_kind == Invalid)
+        return QString();
+
+    QByteArray data;
+    data.append(char(FormatVersion << 4 | m_kind));
+    writeVarint(&data, m_numRows);
+    writeVarint(&data, m_numCols);
+    writeVarint(&data, m_numMines);
+    writeVarint(&data, m_clickedIdx + 1);
+
+    if(m_kind == Seeded)
+        writeVarint(&data, m_seed);
+    else
+    {
+        const Binomials& binom = binomials();
+        BitWriter writer(&data);
+        const int size = m_mines.size();
+        for(int start=0; start<size; start+=BlockSize)
+        {
+            const int n = qMin(int(BlockSize), size - start);
+            int k = 0;
+            quint64 rank = 0;
+            for(int p=0; p<n; ++p)
+                if(m_mines.at(start + p))
+                    rank += binom.c[p][++k];
+            writer.write(k, bitsFor(n));
+            writer.write(rank, bitsFor(binom.c[n][k] - 1));
+        }
+    }
+
+    return QString::fromLatin1(data.toBase64(BASE64_OPTIONS));
+}
+
+BoardCode BoardCode::fromString(const QString& string)
+{
+    const QByteArray::FromBase64Result decoded =
+        QByteArray::fromBase64Encoding(string.trimmed().toLatin1(), BASE64_OPTIONS | QByteArray::AbortOnBase64DecodingErrors);
+    if(!decoded || decoded.decoded.isEmpty())
+        return BoardCode();
+
+    const QByteArray& data = decoded.decoded;
+    const int version = uchar(data.at(0)) >> 4;
+    const int kind = data.at(0) & 0x0f;
+    if(version != FormatVersion || (kind != Seeded && kind != Layout))
+        return BoardCode();
+
+    int pos = 1;
+    quint32 numRows, numCols, numMines, clicked;
+    if(!readVarint(data, &pos, &numRows) || !readVarint(data, &pos, &numCols)
+       || !readVarint(data, &pos, &numMines) || !readVarint(data, &pos, &clicked))
+        return BoardCode();
+    if(numRows == 0 || numCols == 0 || quint64(numRows)*numCols > MAXIMAL_CELLS)
+        return BoardCode();
+    const int size = numRows*numCols;
+    if(int(numMines) >= size || int(clicked) > size)
+        return BoardCode();
+
+    BoardCode code;
+    code.m_kind = static_cast<Kind>(kind);
+    code.m_numRows = numRows;
+    code.m_numCols = numCols;
+    code.m_numMines = numMines;
+    code.m_clickedIdx = int(clicked) - 1;
+
+    if(code.m_kind == Seeded)
+    {
+        // generator needs the first click and room for mines around it
+        if(code.m_clickedIdx < 0 || int(numMines) > size - 9 || !readVarint(data, &pos, &code.m_seed))
+            return BoardCode();
+        return code;
+    }
+
+    const Binomials& binom = binomials();
+    BitReader reader(data, pos);
+    code.m_mines.fill(false, size);
+    int minesFound = 0;
+    for(int start=0; start<size; start+=BlockSize)
+    {
+        const int n = qMin(int(BlockSize), size - start);
+        quint64 k, rank;
+        if(!reader.read(bitsFor(n), &k) || int(k) > n
+           || !reader.read(bitsFor(binom.c[n][k] - 1), &rank) || rank >= binom.c[n][k])
+            return BoardCode();
+
+        // greedy unranking, positions come out in descending order
+        int p = n - 1;
+        for(int i=int(k); i>0; --i, --p)
+        {
+            while(binom.c[p][i] > rank)
+                --p;
+            rank -= binom.c[p][i];
+            code.m_mines[start + p] = true;
+        }
+        minesFound += int(k);
+    }
+    if(minesFound != int(numMines))
+        return BoardCode();
+    return code;
+}
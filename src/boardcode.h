@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDCODE_H
+#define BOARDCODE_H
+
+// Qt
+#include <QString>
+#include <QVector>
+
+/**
+ * Short textual code describing a board: its size, mine layout
+ * and the first click, so that players can share puzzles and
+ * race on identical boards.
+ *
+ * Randomly generated boards are described by the seed given to
+ * FieldGenerator. Arbitrary layouts are stored as mine positions
+ * using enumerative coding: the field is split in blocks of 64 cells
+ * and each block is written as its mine count followed by the rank
+ * of its mine combination in the combinatorial number system.
+ * Both encoding and decoding are linear in the number of cells.
+ */
+class BoardCode
+{
+public:
+    enum Kind { Invalid, Seeded, Layout };
+
+    /**
+     * Constructs an invalid code
+     */
+    BoardCode() = default;
+    /**
+     * @return code of a field produced by FieldGenerator::generate()
+     */
+    static BoardCode fromSeed(int numRows, int numCols, int numMines, int clickedIdx, quint32 seed);
+    /**
+     * @param field row-major cells, FieldGenerator::Mine for mines
+     * @param clickedIdx cell the player should start with or -1
+     */
+    static BoardCode fromField(int numRows, int numCols, const QVector<qint8>& field, int clickedIdx = -1);
+    /**
+     * Parses a code produced by toString(). Returns an invalid code
+     * if the string is malformed.
+     */
+    static BoardCode fromString(const QString& code);
+    QString toString() const;
+
+    Kind kind() const { return m_kind; }
+    bool isValid() const { return m_kind != Invalid; }
+    int numRows() const { return m_numRows; }
+    int numCols() const { return m_numCols; }
+    int numMines() const { return m_numMines; }
+    /**
+     * @return row-major index of the first click, -1 if not known
+     */
+    int clickedIdx() const { return m_clickedIdx; }
+    /**
+     * @return cells with digits computed, FieldGenerator::Mine for mines
+     */
+    QVector<qint8> field() const;
+
+    /**
+     * Fields larger than this are never decoded
+     */
+    static const int MAXIMAL_CELLS = 1 << 20;
+private:
+    Kind m_kind = Invalid;
+    int m_numRows = 0;
+    int m_numCols = 0;
+    int m_numMines = 0;
+    int m_clickedIdx = -1;
+    quint32 m_seed = 0;
+    /**
+     * Mine flags of a Layout code, one per cell
+     */
+    QVector<bool> m_mines;
+};
+
+#endif
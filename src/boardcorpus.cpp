@@ -0,0 +1,323 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardcorpus.h"
+
+// own
+#include "boardrating.h"
+#include "fieldgenerator.h"
+#include "kmines_debug.h"
+// Qt
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+// Std
+#include <algorithm>
+#include <tuple>
+
+// File layout, all values little endian:
+//   header:  magic, version, number of classes, RatingLevels (4 x quint32)
+//   classes: rows, cols (quint16), mines, record size, record count (quint32),
+//            offset of records, offset of buckets (quint64)
+//   buckets: for each cell and rating, first record and record count (2 x quint32),
+//            only cells which are the smallest of their orbit are used
+//   records: first click (quint32), 3BV (quint16), rating (quint8), unused byte,
+//            then one bit per cell for mines, padded to 8 bytes
+namespace
+{
+
+enum { Magic = 0x434d424b }; // "KBMC"
+// version 2 stores BoardRating::level() as rating
+enum { FormatVersion = 2 };
+enum { HeaderSize = 16, ClassSize = 32, BucketSize = 8, RecordHeaderSize = 8 };
+
+static_assert(int(BoardCorpus::RatingLevels) == int(BoardRating::LevelCount), "one bucket per rating level");
+
+int recordSizeFor(int numCells)
+{
+    return (RecordHeaderSize + (numCells + 7) / 8 + 7) / 8 * 8;
+}
+
+quint32 read32(const uchar* data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+}
+
+quint64 BoardCorpus::classKey(int numRows, int numCols, int numMines)
+{
+    return quint64(quint16(numRows)) << 48 | quint64(quint16(numCols)) << 32 | quint32(numMines);
+}
+
+bool BoardCorpus::open(const QString& fileName)
+{
+    m_file.setFileName(fileName);
+    if(!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    const uchar* data = size >= HeaderSize ? m_file.map(0, size) : nullptr;
+    if(!data || read32(data) != Magic || read32(data + 4) != FormatVersion
+        || read32(data + 12) != RatingLevels)
+    {
+        qCWarning(KMINES_LOG) << "Ignoring invalid board corpus" << fileName;
+        m_file.close();
+        return false;
+    }
+
+    const quint32 classCount = read32(data + 8);
+    if(HeaderSize + qint64(classCount)*ClassSize > size)
+    {
+        m_file.close();
+        return false;
+    }
+    for(quint32 i=0; i<classCount; ++i)
+    {
+        const uchar* entry = data + HeaderSize + i*ClassSize;
+        Class cls;
+        cls.numRows = qFromLittleEndian<quint16>(entry);
+        cls.numCols = qFromLittleEndian<quint16>(entry + 2);
+        cls.numMines = read32(entry + 4);
+        cls.recordSize = read32(entry + 8);
+        cls.recordCount = read32(entry + 12);
+        const quint64 recordsOffset = qFromLittleEndian<quint64>(entry + 16);
+        const quint64 bucketsOffset = qFromLittleEndian<quint64>(entry + 24);
+
+        // everything must lie within the file, so that lookups need no checks
+        const qint64 numCells = qint64(cls.numRows)*cls.numCols;
+        if(numCells == 0 || cls.recordSize != recordSizeFor(numCells)
+            || recordsOffset + quint64(cls.recordCount)*cls.recordSize > quint64(size)
+            || bucketsOffset + quint64(numCells)*RatingLevels*BucketSize > quint64(size))
+        {
+            qCWarning(KMINES_LOG) << "Ignoring invalid board corpus" << fileName;
+            m_classes.clear();
+            m_file.close();
+            return false;
+        }
+        cls.records = data + recordsOffset;
+        cls.buckets = data + bucketsOffset;
+        m_classes.insert(classKey(cls.numRows, cls.numCols, cls.numMines), cls);
+    }
+    m_data = data;
+    return true;
+}
+
+const BoardCorpus* BoardCorpus::installed()
+{
+    static BoardCorpus* corpus = []() -> BoardCorpus* {
+        const QString fileName = QStandardPaths::locate(QStandardPaths::AppDataLocation,
+                                                        QStringLiteral("boards.kmc"));
+        if(fileName.isEmpty())
+            return nullptr;
+        BoardCorpus* result = new BoardCorpus;
+        if(result->open(fileName))
+            return result;
+        delete result;
+        return nullptr;
+    }();
+    return corpus;
+}
+
+int BoardCorpus::count(int numRows, int numCols, int numMines) const
+{
+    const auto it = m_classes.constFind(classKey(numRows, numCols, numMines));
+    return it == m_classes.constEnd() ? 0 : it->recordCount;
+}
+
+int BoardCorpus::symmetryCount(int numRows, int numCols)
+{
+    return numRows == numCols ? 8 : 4;
+}
+
+int BoardCorpus::transformed(int numRows, int numCols, int symmetry, int idx)
+{
+    int row = idx / numCols;
+    int col = idx % numCols;
+    // transposing only happens on square boards
+    if(symmetry & 4)
+        std::swap(row, col);
+    if(symmetry & 1)
+        row = numRows - 1 - row;
+    if(symmetry & 2)
+        col = numCols - 1 - col;
+    return row*numCols + col;
+}
+
+int BoardCorpus::orbitOf(int numRows, int numCols, int idx)
+{
+    int orbit = idx;
+    for(int symmetry=1; symmetry<symmetryCount(numRows, numCols); ++symmetry)
+        orbit = qMin(orbit, transformed(numRows, numCols, symmetry, idx));
+    return orbit;
+}
+
+QVector<qint8> BoardCorpus::pick(int numRows, int numCols, int numMines, int clickedIdx,
+                                 int minRating, int maxRating, QRandomGenerator* random,
+                                 int* rating) const
+{
+    const auto it = m_classes.constFind(classKey(numRows, numCols, numMines));
+    if(it == m_classes.constEnd())
+        return QVector<qint8>();
+    const Class& cls = it.value();
+
+    // buckets of the orbit are consecutive by rating
+    const int orbit = orbitOf(numRows, numCols, clickedIdx);
+    const uchar* buckets = cls.buckets + qint64(orbit)*RatingLevels*BucketSize;
+    const int lowest = qMax(0, minRating);
+    const int highest = qMin(maxRating, RatingLevels - 1);
+    if(lowest > highest)
+        return QVector<qint8>();
+    const quint32 first = read32(buckets + lowest*BucketSize);
+    const quint32 last = read32(buckets + highest*BucketSize) + read32(buckets + highest*BucketSize + 4);
+    if(last <= first || last > quint32(cls.recordCount))
+        return QVector<qint8>();
+
+    const uchar* record = cls.records + qint64(random->bounded(first, last))*cls.recordSize;
+    const int recordClick = read32(record);
+
+    // any symmetry which moves the first click of the record to the clicked cell
+    int symmetries[8];
+    int symmetryCount = 0;
+    for(int symmetry=0; symmetry<BoardCorpus::symmetryCount(numRows, numCols); ++symmetry)
+        if(transformed(numRows, numCols, symmetry, recordClick) == clickedIdx)
+            symmetries[symmetryCount++] = symmetry;
+    if(symmetryCount == 0)
+        return QVector<qint8>();
+    const int symmetry = symmetries[random->bounded(symmetryCount)];
+
+    const int numCells = numRows*numCols;
+    QVector<qint8> field(numCells, 0);
+    const uchar* bits = record + RecordHeaderSize;
+    for(int idx=0; idx<numCells; ++idx)
+        if(bits[idx / 8] & (1 << idx % 8))
+            field[transformed(numRows, numCols, symmetry, idx)] = FieldGenerator::Mine;
+    FieldGenerator::computeDigits(numRows, numCols, field);
+    if(rating)
+        *rating = record[6];
+    return field;
+}
+
+void BoardCorpusWriter::addBoard(int numRows, int numCols, const QVector<qint8>& field,
+                                 int clickedIdx, int bbbv, int rating)
+{
+    const int numCells = numRows*numCols;
+    Q_ASSERT(field.size() == numCells);
+
+    QByteArray record(recordSizeFor(numCells), '\0');
+    uchar* data = reinterpret_cast<uchar*>(record.data());
+    qToLittleEndian<quint32>(clickedIdx, data);
+    qToLittleEndian<quint16>(qBound(0, bbbv, 0xffff), data + 4);
+    data[6] = qBound(0, rating, BoardCorpus::RatingLevels - 1);
+    int numMines = 0;
+    for(int idx=0; idx<numCells; ++idx)
+        if(field.at(idx) == FieldGenerator::Mine)
+        {
+            data[RecordHeaderSize + idx / 8] |= 1 << idx % 8;
+            numMines++;
+        }
+    m_records[BoardCorpus::classKey(numRows, numCols, numMines)].append(record);
+}
+
+void BoardCorpusWriter::addCorpus(const BoardCorpus& corpus)
+{
+    for(const BoardCorpus::Class& cls : corpus.m_classes)
+    {
+        QVector<QByteArray>& records = m_records[BoardCorpus::classKey(cls.numRows, cls.numCols, cls.numMines)];
+        for(int i=0; i<cls.recordCount; ++i)
+            records.append(QByteArray(reinterpret_cast<const char*>(cls.records) + qint64(i)*cls.recordSize,
+                                      cls.recordSize));
+    }
+}
+
+int BoardCorpusWriter::count() const
+{
+    int total = 0;
+    for(const QVector<QByteArray>& records : m_records)
+        total += records.size();
+    return total;
+}
+
+bool BoardCorpusWriter::save(const QString& fileName) const
+{
+    QList<quint64> keys = m_records.keys();
+    std::sort(keys.begin(), keys.end());
+
+    QByteArray header(HeaderSize + keys.size()*ClassSize, '\0');
+    QByteArray body;
+    for(int i=0; i<keys.size(); ++i)
+    {
+        const quint64 key = keys.at(i);
+        const int numRows = quint16(key >> 48);
+        const int numCols = quint16(key >> 32);
+        const int numCells = numRows*numCols;
+        const int recordSize = recordSizeFor(numCells);
+
+        // sort by orbit of the first click, rating and 3BV
+        struct Entry { int orbit; int rating; int bbbv; const QByteArray* record; };
+        const QVector<QByteArray> records = m_records.value(key);
+        QVector<Entry> entries;
+        for(const QByteArray& record : records)
+        {
+            const uchar* data = reinterpret_cast<const uchar*>(record.constData());
+            entries.append({BoardCorpus::orbitOf(numRows, numCols, read32(data)), data[6],
+                            qFromLittleEndian<quint16>(data + 4), &record});
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return std::tie(a.orbit, a.rating, a.bbbv) < std::tie(b.orbit, b.rating, b.bbbv);
+        });
+
+        // a bucket starts where the previous one of the orbit ended, so that
+        // records rated up to some level are always one contiguous range
+        QByteArray buckets(numCells*BoardCorpus::RatingLevels*BucketSize, '\0');
+        int next = 0;
+        for(int orbit=0; orbit<numCells; ++orbit)
+        {
+            for(int rating=0; rating<BoardCorpus::RatingLevels; ++rating)
+            {
+                const int first = next;
+                while(next < entries.size() && entries.at(next).orbit == orbit && entries.at(next).rating == rating)
+                    next++;
+                uchar* bucket = reinterpret_cast<uchar*>(buckets.data()) + (orbit*BoardCorpus::RatingLevels + rating)*BucketSize;
+                qToLittleEndian<quint32>(first, bucket);
+                qToLittleEndian<quint32>(next - first, bucket + 4);
+            }
+        }
+
+        uchar* entry = reinterpret_cast<uchar*>(header.data()) + HeaderSize + i*ClassSize;
+        qToLittleEndian<quint16>(numRows, entry);
+        qToLittleEndian<quint16>(numCols, entry + 2);
+        qToLittleEndian<quint32>(quint32(key), entry + 4);
+        qToLittleEndian<quint32>(recordSize, entry + 8);
+        qToLittleEndian<quint32>(entries.size(), entry + 12);
+        // offsets are relative to the body for now
+        qToLittleEndian<quint64>(body.size() + buckets.size(), entry + 16);
+        qToLittleEndian<quint64>(body.size(), entry + 24);
+        body.append(buckets);
+        for(const Entry& sorted : std::as_const(entries))
+            body.append(*sorted.record);
+    }
+
+    uchar* data = reinterpret_cast<uchar*>(header.data());
+    qToLittleEndian<quint32>(Magic, data);
+    qToLittleEndian<quint32>(FormatVersion, data + 4);
+    qToLittleEndian<quint32>(keys.size(), data + 8);
+    qToLittleEndian<quint32>(BoardCorpus::RatingLevels, data + 12);
+    for(int i=0; i<keys.size(); ++i)
+    {
+        uchar* entry = data + HeaderSize + i*ClassSize;
+        qToLittleEndian<quint64>(qFromLittleEndian<quint64>(entry + 16) + header.size(), entry + 16);
+        qToLittleEndian<quint64>(qFromLittleEndian<quint64>(entry + 24) + header.size(), entry + 24);
+    }
+
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(header);
+    file.write(body);
+    return file.commit();
+}
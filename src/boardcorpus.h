@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDCORPUS_H
+#define BOARDCORPUS_H
+
+// Qt
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+class QRandomGenerator;
+
+/**
+ * Read-only, memory-mapped collection of pregenerated boards.
+ *
+ * Boards are grouped in classes of equal size and mine count. Each board
+ * is a fixed-size record holding its first click, 3BV, rating and the
+ * mines as a bitmap. Records of a class are sorted by the first click
+ * (reduced to its orbit under the symmetries of the board), rating and
+ * 3BV, and a bucket table gives the records of every orbit and rating,
+ * so picking a board never scans the corpus. A picked board is rotated
+ * or mirrored to put its first click where the player clicked.
+ *
+ * Corpus files are built by the kmines-corpusgen tool.
+ */
+class BoardCorpus
+{
+public:
+    /**
+     * Number of rating levels, ratings are BoardRating::level() values
+     */
+    enum { RatingLevels = 16 };
+
+    BoardCorpus() = default;
+    /**
+     * Maps corpus file, returns false if it is missing or malformed
+     */
+    bool open(const QString& fileName);
+    bool isOpen() const { return m_data != nullptr; }
+    /**
+     * @return corpus installed for the application, null if there is none
+     */
+    static const BoardCorpus* installed();
+
+    /**
+     * @return number of boards of given size and mine count
+     */
+    int count(int numRows, int numCols, int numMines) const;
+    /**
+     * Picks a random board whose first click is safe at clickedIdx.
+     *
+     * @param minRating, maxRating only boards rated within these are considered
+     * @param rating if not null, set to the stored rating of the board
+     * @return row-major digits or FieldGenerator::Mine, empty if there is no such board
+     */
+    QVector<qint8> pick(int numRows, int numCols, int numMines, int clickedIdx,
+                        int minRating, int maxRating, QRandomGenerator* random,
+                        int* rating = nullptr) const;
+
+    /**
+     * @return number of symmetries of a board, 8 if it is square and 4 otherwise
+     */
+    static int symmetryCount(int numRows, int numCols);
+    /**
+     * @return cell idx is moved to by symmetry
+     */
+    static int transformed(int numRows, int numCols, int symmetry, int idx);
+    /**
+     * @return smallest cell of the orbit of idx, boards are indexed by it
+     */
+    static int orbitOf(int numRows, int numCols, int idx);
+private:
+    friend class BoardCorpusWriter;
+
+    struct Class
+    {
+        int numRows;
+        int numCols;
+        int numMines;
+        int recordSize;
+        int recordCount;
+        const uchar* records;
+        const uchar* buckets;
+    };
+    static quint64 classKey(int numRows, int numCols, int numMines);
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    QHash<quint64, Class> m_classes;
+};
+
+/**
+ * Builds corpus files read by BoardCorpus
+ */
+class BoardCorpusWriter
+{
+public:
+    /**
+     * Adds a board.
+     *
+     * @param field row-major cells, FieldGenerator::Mine for mines
+     * @param clickedIdx first click, must be safe
+     */
+    void addBoard(int numRows, int numCols, const QVector<qint8>& field,
+                  int clickedIdx, int bbbv, int rating);
+    /**
+     * Adds all boards of an existing corpus
+     */
+    void addCorpus(const BoardCorpus& corpus);
+    /**
+     * @return number of boards added so far
+     */
+    int count() const;
+    /**
+     * Writes the corpus, replacing fileName only on success
+     */
+    bool save(const QString& fileName) const;
+private:
+    /**
+     * Encoded records by class
+     */
+    QHash<quint64, QVector<QByteArray>> m_records;
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDGEOMETRY_H
+#define BOARDGEOMETRY_H
+
+// own
+#include "boardtopology.h"
+#include "fieldgenerator.h"
+// Qt
+#include <QtAlgorithms>
+#include <QVector>
+// Std
+#include <array>
+
+/**
+ * Neighbourhoods of the cells of a rectangular board of any size.
+ *
+ * Cells are row-major indices. Board algorithms which are hot enough
+ * to care are written as templates over the geometry and run through
+ * withGeometry(), which uses FixedBoardGeometry for the standard
+ * levels, this class for all other square boards and BoardTopology
+ * for other shapes.
+ */
+class BoardGeometry
+{
+public:
+    BoardGeometry(int numRows, int numCols)
+        : m_numRows(numRows), m_numCols(numCols)
+    {
+    }
+
+    int numRows() const { return m_numRows; }
+    int numCols() const { return m_numCols; }
+    int numCells() const { return m_numRows*m_numCols; }
+    /**
+     * All cells of rectangular boards are played
+     */
+    bool isActive(int) const { return true; }
+
+    /**
+     * Calls function with the index of every neighbour of idx
+     */
+    template<typename Function>
+    void forNeighbours(int idx, Function&& function) const
+    {
+        const int row = idx / m_numCols;
+        const int col = idx % m_numCols;
+        for(int r=qMax(row-1, 0); r<=qMin(row+1, m_numRows-1); ++r)
+            for(int c=qMax(col-1, 0); c<=qMin(col+1, m_numCols-1); ++c)
+                if(r != row || c != col)
+                    function(r*m_numCols + c);
+    }
+
+    /**
+     * Fills digits of all cells of field not holding FieldGenerator::Mine
+     */
+    void computeDigits(QVector<qint8>& field) const
+    {
+        for(int idx=0; idx<field.size(); ++idx)
+        {
+            if(field.at(idx) == FieldGenerator::Mine)
+                continue;
+            qint8 digit = 0;
+            forNeighbours(idx, [&](int other) {
+                if(field.at(other) == FieldGenerator::Mine)
+                    digit++;
+            });
+            field[idx] = digit;
+        }
+    }
+
+private:
+    int m_numRows;
+    int m_numCols;
+};
+
+/**
+ * Geometry of a board whose size is known at compile time.
+ *
+ * Neighbours of all cells are listed in a table built by the compiler,
+ * so iterating them needs neither division nor bounds checks, and each
+ * row of mines fits in one 32 bit mask, so digits are counted with a
+ * few population counts per cell.
+ */
+template<int Rows, int Cols>
+class FixedBoardGeometry
+{
+    static_assert(Rows > 0 && Cols > 0 && Cols <= 32, "rows are kept in 32 bit masks");
+public:
+    static constexpr int numRows() { return Rows; }
+    static constexpr int numCols() { return Cols; }
+    static constexpr int numCells() { return Rows*Cols; }
+    static constexpr bool isActive(int) { return true; }
+
+    template<typename Function>
+    void forNeighbours(int idx, Function&& function) const
+    {
+        const Neighbourhood& neighbourhood = s_neighbourhoods[idx];
+        for(int i=0; i<neighbourhood.count; ++i)
+            function(int(neighbourhood.cells[i]));
+    }
+
+    void computeDigits(QVector<qint8>& field) const
+    {
+        Q_ASSERT(field.size() == numCells());
+
+        // padded with an empty row above and below
+        std::array<quint32, Rows + 2> mines = {};
+        for(int row=0; row<Rows; ++row)
+            for(int col=0; col<Cols; ++col)
+                if(field.at(row*Cols + col) == FieldGenerator::Mine)
+                    mines[row + 1] |= quint32(1) << col;
+
+        qint8* cells = field.data();
+        for(int row=0; row<Rows; ++row)
+            for(int col=0; col<Cols; ++col)
+            {
+                // bits col-1 to col+1, the cell itself holds no mine if it gets a digit
+                const quint32 window = quint32((quint64(7) << col) >> 1);
+                const int digit = qPopulationCount(mines[row] & window)
+                                + qPopulationCount(mines[row + 1] & window)
+                                + qPopulationCount(mines[row + 2] & window);
+                qint8& cell = cells[row*Cols + col];
+                cell = cell == FieldGenerator::Mine ? FieldGenerator::Mine : qint8(digit);
+            }
+    }
+
+private:
+    struct Neighbourhood
+    {
+        qint16 cells[8];
+        int count;
+    };
+    typedef std::array<Neighbourhood, Rows*Cols> Neighbourhoods;
+
+    static constexpr Neighbourhoods neighbourhoods()
+    {
+        Neighbourhoods result = {};
+        for(int row=0; row<Rows; ++row)
+            for(int col=0; col<Cols; ++col)
+            {
+                Neighbourhood& neighbourhood = result[row*Cols + col];
+                for(int r=row-1; r<=row+1; ++r)
+                    for(int c=col-1; c<=col+1; ++c)
+                        if(r >= 0 && r < Rows && c >= 0 && c < Cols && (r != row || c != col))
+                            neighbourhood.cells[neighbourhood.count++] = qint16(r*Cols + c);
+            }
+        return result;
+    }
+
+    static constexpr Neighbourhoods s_neighbourhoods = neighbourhoods();
+};
+
+/**
+ * Calls function with the geometry for a board of given size, a
+ * FixedBoardGeometry for the sizes of the standard levels and a
+ * BoardGeometry otherwise. Function must return the same type for all.
+ */
+template<typename Function>
+auto withGeometry(int numRows, int numCols, Function&& function)
+{
+    if(numRows == 9 && numCols == 9)
+        return function(FixedBoardGeometry<9, 9>());
+    if(numRows == 16 && numCols == 16)
+        return function(FixedBoardGeometry<16, 16>());
+    if(numRows == 16 && numCols == 30)
+        return function(FixedBoardGeometry<16, 30>());
+    return function(BoardGeometry(numRows, numCols));
+}
+
+/**
+ * Calls function with the fastest geometry for topology,
+ * which is the topology itself unless the board is a plain rectangle
+ */
+template<typename Function>
+auto withGeometry(const BoardTopology& topology, Function&& function)
+{
+    if(topology.kind() == BoardTopology::Square && topology.isComplete())
+        return withGeometry(topology.numRows(), topology.numCols(), function);
+    return function(topology);
+}
+
+#endif
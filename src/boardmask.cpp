@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardmask.h"
+
+// Qt
+#include <QFile>
+#include <QImage>
+#include <QStringList>
+
+static const QLatin1String MINES_PREFIX("mines:");
+
+BoardMask BoardMask::fromText(const QString& text)
+{
+    BoardMask mask;
+    QStringList rows;
+    int numMines = -1;
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    for(const QString& line : lines)
+    {
+        const QString trimmed = line.trimmed();
+        if(trimmed.startsWith(QLatin1Char(';')))
+            continue;
+        if(trimmed.startsWith(MINES_PREFIX, Qt::CaseInsensitive))
+        {
+            bool ok = false;
+            numMines = trimmed.mid(MINES_PREFIX.size()).trimmed().toInt(&ok);
+            if(!ok || numMines < 1)
+                return BoardMask();
+            continue;
+        }
+        rows.append(line);
+    }
+    // blank lines around the outline are no rows
+    while(!rows.isEmpty() && rows.first().trimmed().isEmpty())
+        rows.removeFirst();
+    while(!rows.isEmpty() && rows.last().trimmed().isEmpty())
+        rows.removeLast();
+
+    int numCols = 0;
+    for(const QString& row : std::as_const(rows))
+        numCols = qMax(numCols, row.size());
+    if(rows.isEmpty() || rows.size() > MAXIMAL_SIZE || numCols > MAXIMAL_SIZE)
+        return BoardMask();
+
+    mask.m_numRows = rows.size();
+    mask.m_numCols = numCols;
+    mask.m_active.resize(mask.m_numRows*numCols);
+    for(int row=0; row<rows.size(); ++row)
+    {
+        const QString& line = rows.at(row);
+        for(int col=0; col<line.size(); ++col)
+        {
+            const QChar c = line.at(col);
+            if(c == QLatin1Char('#'))
+                mask.m_active.setBit(row*numCols + col);
+            else if(c != QLatin1Char('.') && c != QLatin1Char(' ') && c != QLatin1Char('\r'))
+                return BoardMask();
+        }
+    }
+    if(mask.m_active.count(true) == 0)
+        return BoardMask();
+
+    if(numMines > 0)
+        mask.m_numMines = numMines;
+    else
+        mask.setDefaultMines();
+    return mask;
+}
+
+BoardMask BoardMask::fromImage(const QImage& image)
+{
+    if(image.isNull() || image.height() > MAXIMAL_SIZE || image.width() > MAXIMAL_SIZE)
+        return BoardMask();
+
+    BoardMask mask;
+    mask.m_numRows = image.height();
+    mask.m_numCols = image.width();
+    mask.m_active.resize(mask.m_numRows*mask.m_numCols);
+    for(int row=0; row<mask.m_numRows; ++row)
+        for(int col=0; col<mask.m_numCols; ++col)
+        {
+            const QRgb pixel = image.pixel(col, row);
+            if(qAlpha(pixel) > 127 && qGray(pixel) < 128)
+                mask.m_active.setBit(row*mask.m_numCols + col);
+        }
+    if(mask.m_active.count(true) == 0)
+        return BoardMask();
+    mask.setDefaultMines();
+    return mask;
+}
+
+BoardMask BoardMask::load(const QString& fileName)
+{
+    QImage image;
+    if(image.load(fileName))
+        return fromImage(image);
+
+    QFile file(fileName);
+    // levels are tiny, anything big is no level
+    if(!file.open(QIODevice::ReadOnly) || file.size() > MAXIMAL_SIZE*(MAXIMAL_SIZE + 2) + 1024)
+        return BoardMask();
+    return fromText(QString::fromUtf8(file.readAll()));
+}
+
+void BoardMask::setDefaultMines()
+{
+    // 40 mines on 256 cells
+    m_numMines = qMax(1, m_active.count(true)*5/32);
+}
@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDMASK_H
+#define BOARDMASK_H
+
+// Qt
+#include <QBitArray>
+#include <QString>
+
+class QImage;
+
+/**
+ * Outline of a shaped level: which cells of a rectangular grid are
+ * played, the others are left out of the board.
+ *
+ * Levels are small text files, one line per row, where '#' is a played
+ * cell and '.' or a space a cell left out. Lines starting with ';' are
+ * comments, and a line "mines: N" sets the number of mines. Images can
+ * be used as well, dark opaque pixels are the played cells.
+ */
+class BoardMask
+{
+public:
+    /**
+     * Constructs an invalid mask, i.e. a rectangular board
+     */
+    BoardMask() = default;
+    /**
+     * Parses a level, returns an invalid mask if the text is malformed
+     */
+    static BoardMask fromText(const QString& text);
+    static BoardMask fromImage(const QImage& image);
+    /**
+     * Reads a level from a text or image file
+     */
+    static BoardMask load(const QString& fileName);
+
+    bool isValid() const { return !m_active.isEmpty(); }
+    int numRows() const { return m_numRows; }
+    int numCols() const { return m_numCols; }
+    /**
+     * @return number of mines given by the level, or as many
+     * as on a Medium board of the same number of cells
+     */
+    int numMines() const { return m_numMines; }
+    /**
+     * @return one bit per cell, row-major, set for played cells
+     */
+    QBitArray activeCells() const { return m_active; }
+
+    /**
+     * Levels with more rows or columns are refused
+     */
+    static const int MAXIMAL_SIZE = 100;
+private:
+    /**
+     * Sets the mines of levels which don't tell
+     */
+    void setDefaultMines();
+
+    int m_numRows = 0;
+    int m_numCols = 0;
+    int m_numMines = 0;
+    QBitArray m_active;
+};
+
+#endif
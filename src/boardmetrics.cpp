@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardmetrics.h"
+
+// own
+#include "boardgeometry.h"
+
+static int findRoot(QVector<int>& parent, int idx)
+{
+    while(parent[idx] != idx)
+    {
+        // path halving keeps the trees flat
+        parent[idx] = parent[parent[idx]];
+        idx = parent[idx];
+    }
+    return idx;
+}
+
+namespace
+{
+
+template<typename Geometry>
+BoardMetrics computeOn(const Geometry& geometry, const QVector<qint8>& field)
+{
+    Q_ASSERT(field.size() == geometry.numCells());
+
+    BoardMetrics metrics;
+    // union-find labels of empty cells, -1 for the others
+    QVector<int> parent(field.size(), -1);
+
+    for(int idx=0; idx<field.size(); ++idx)
+    {
+        const qint8 value = field.at(idx);
+        if(value == FieldGenerator::Mine || !geometry.isActive(idx))
+            continue;
+
+        if(value == 0)
+        {
+            // every empty cell starts a new opening, which is merged
+            // with the already visited ones
+            parent[idx] = idx;
+            metrics.openings++;
+            geometry.forNeighbours(idx, [&](int other) {
+                if(other > idx || field.at(other) != 0)
+                    return;
+                const int a = findRoot(parent, idx);
+                const int b = findRoot(parent, other);
+                if(a != b)
+                {
+                    parent[a] = b;
+                    metrics.openings--;
+                }
+            });
+            continue;
+        }
+
+        // digit: it is cleared by an opening if it touches any empty cell
+        bool touchesOpening = false;
+        geometry.forNeighbours(idx, [&](int other) {
+            if(field.at(other) == 0)
+                touchesOpening = true;
+        });
+        if(!touchesOpening)
+            metrics.isolatedDigits++;
+    }
+
+    metrics.bbbv = metrics.openings + metrics.isolatedDigits;
+    return metrics;
+}
+
+}
+
+BoardMetrics BoardMetrics::compute(int numRows, int numCols, const QVector<qint8>& field)
+{
+    return withGeometry(numRows, numCols, [&](const auto& geometry) {
+        return computeOn(geometry, field);
+    });
+}
+
+BoardMetrics BoardMetrics::compute(const BoardTopology& topology, const QVector<qint8>& field)
+{
+    return withGeometry(topology, [&](const auto& geometry) {
+        return computeOn(geometry, field);
+    });
+}
@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDMETRICS_H
+#define BOARDMETRICS_H
+
+// own
+#include "fieldgenerator.h"
+// Qt
+#include <QVector>
+
+class BoardTopology;
+
+/**
+ * Difficulty metrics of a generated field as used by competitive players
+ */
+struct BoardMetrics
+{
+    /**
+     * Bechtel's Board Benchmark Value: minimal number of left clicks
+     * needed to clear the field, i.e. openings + isolated digits
+     */
+    int bbbv = 0;
+    /**
+     * Number of connected regions of empty cells
+     */
+    int openings = 0;
+    /**
+     * Number of digit cells which are not at the edge of any opening
+     */
+    int isolatedDigits = 0;
+
+    /**
+     * Computes metrics in one linear pass over the field.
+     *
+     * @param field row-major array of numRows*numCols digits, or FieldGenerator::Mine
+     */
+    static BoardMetrics compute(int numRows, int numCols, const QVector<qint8>& field);
+    /**
+     * Same for boards of any topology, cells are kept as described by topology
+     */
+    static BoardMetrics compute(const BoardTopology& topology, const QVector<qint8>& field);
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardrating.h"
+
+// own
+#include "boardgeometry.h"
+#include "fieldgenerator.h"
+#include "solver.h"
+// Std
+#include <algorithm>
+#include <cmath>
+
+// rating is done for every new board, frontier areas which need more
+// steps are rare and are rated as if they needed a guess
+static const int RATING_SEARCH_STEPS = 1 << 14;
+
+double BoardRating::survival() const
+{
+    double result = 1.0;
+    for(float probability : guesses)
+        result *= 1.0 - probability;
+    return result;
+}
+
+int BoardRating::level() const
+{
+    if(knownLevel >= 0)
+        return knownLevel;
+    if(guesses.isEmpty())
+        return hardestTechnique > Propagation ? 1 : 0;
+    // a guess which can't fail still wasn't proven safe
+    const double halvings = -std::log2(qMax(survival(), 1e-9));
+    return qBound(2, 1 + int(std::ceil(halvings)), LevelCount - 1);
+}
+
+BoardRating BoardRating::fromLevel(int level)
+{
+    BoardRating rating;
+    rating.knownLevel = qBound(0, level, LevelCount - 1);
+    return rating;
+}
+
+namespace
+{
+
+/**
+ * @param analyse runs the solver on the cells the player sees
+ */
+template<typename Geometry, typename Analyse>
+BoardRating rateOn(const Geometry& geometry, const Analyse& analyse, int numMines,
+                   const QVector<qint8>& field, int clickedIdx)
+{
+    Q_ASSERT(field.size() == geometry.numCells());
+    Q_ASSERT(field.at(clickedIdx) != FieldGenerator::Mine);
+
+    // cells as the player sees them, mines proven so far and
+    // revealed digits whose neighbours changed
+    QVector<qint8> visible(field.size(), Solver::Covered);
+    QVector<char> provenMine(field.size(), 0);
+    QVector<int> dirty;
+    QVector<int> queue;
+    int safeLeft = -numMines;
+    // inactive cells look like revealed ones without neighbours
+    for(int idx=0; idx<field.size(); ++idx)
+    {
+        if(geometry.isActive(idx))
+            safeLeft++;
+        else
+            visible[idx] = 0;
+    }
+
+    auto markDirty = [&](int idx) {
+        geometry.forNeighbours(idx, [&](int other) {
+            if(visible.at(other) > 0)
+                dirty.append(other);
+        });
+    };
+    auto reveal = [&](int idx) {
+        queue.append(idx);
+        while(!queue.isEmpty())
+        {
+            const int current = queue.takeLast();
+            if(visible.at(current) != Solver::Covered)
+                continue;
+            Q_ASSERT(field.at(current) != FieldGenerator::Mine);
+            visible[current] = field.at(current);
+            safeLeft--;
+            if(field.at(current) != 0)
+                dirty.append(current);
+            markDirty(current);
+            if(field.at(current) == 0)
+                geometry.forNeighbours(current, [&](int other) { queue.append(other); });
+        }
+    };
+    auto proveMine = [&](int idx) {
+        if(provenMine.at(idx))
+            return;
+        provenMine[idx] = 1;
+        markDirty(idx);
+    };
+
+    BoardRating rating;
+    rating.steps = 0;
+    reveal(clickedIdx);
+    while(safeLeft > 0)
+    {
+        // digits whose covered neighbours are all safe or all mines
+        if(!dirty.isEmpty())
+        {
+            const int idx = dirty.takeLast();
+            int covered = 0;
+            int mines = 0;
+            geometry.forNeighbours(idx, [&](int other) {
+                if(provenMine.at(other))
+                    mines++;
+                else if(visible.at(other) == Solver::Covered)
+                    covered++;
+            });
+            if(covered == 0 || (mines != visible.at(idx) && mines + covered != visible.at(idx)))
+                continue;
+            const bool safe = mines == visible.at(idx);
+            geometry.forNeighbours(idx, [&](int other) {
+                if(provenMine.at(other) || visible.at(other) != Solver::Covered)
+                    return;
+                if(safe)
+                {
+                    reveal(other);
+                    rating.steps++;
+                }
+                else
+                    proveMine(other);
+            });
+            rating.hardestTechnique = qMax(rating.hardestTechnique, BoardRating::Propagation);
+            continue;
+        }
+
+        // pairs of digits where one's unknown neighbours are among the other's
+        bool progress = false;
+        for(int a=0; a<field.size(); ++a)
+        {
+            if(visible.at(a) <= 0)
+                continue;
+            int unknownA = 0;
+            int unknownCellsA[BoardTopology::MAXIMAL_NEIGHBOURS];
+            int leftA = visible.at(a);
+            geometry.forNeighbours(a, [&](int other) {
+                if(provenMine.at(other))
+                    leftA--;
+                else if(visible.at(other) == Solver::Covered)
+                    unknownCellsA[unknownA++] = other;
+            });
+            if(unknownA == 0)
+                continue;
+
+            // b must touch all unknown neighbours of a, so it is next to the first one.
+            // Openings may reach the neighbours of a, so it is done after one deduction
+            bool deduced = false;
+            geometry.forNeighbours(unknownCellsA[0], [&](int b) {
+                if(deduced || b == a || visible.at(b) <= 0)
+                    return;
+                // unknown neighbours of b which aren't next to a
+                int shared = 0;
+                int leftB = visible.at(b);
+                int rest[BoardTopology::MAXIMAL_NEIGHBOURS];
+                int restSize = 0;
+                geometry.forNeighbours(b, [&](int other) {
+                    if(provenMine.at(other))
+                        leftB--;
+                    else if(visible.at(other) != Solver::Covered)
+                        return;
+                    else if(std::find(unknownCellsA, unknownCellsA + unknownA, other) != unknownCellsA + unknownA)
+                        shared++;
+                    else
+                        rest[restSize++] = other;
+                });
+                if(shared != unknownA || restSize == 0)
+                    return;
+                const int restMines = leftB - leftA;
+                if(restMines != 0 && restMines != restSize)
+                    return;
+                for(int i=0; i<restSize; ++i)
+                {
+                    if(restMines == 0)
+                    {
+                        reveal(rest[i]);
+                        rating.steps++;
+                    }
+                    else
+                        proveMine(rest[i]);
+                }
+                deduced = true;
+                progress = true;
+            });
+        }
+        if(progress)
+        {
+            rating.hardestTechnique = qMax(rating.hardestTechnique, BoardRating::Subsets);
+            continue;
+        }
+
+        // stuck, enumeration is much more expensive but rarely needed
+        const BoardAnalysis analysis = analyse(visible);
+        for(int idx : std::as_const(analysis.mineCells))
+            proveMine(idx);
+        if(!analysis.safeCells.isEmpty())
+        {
+            rating.hardestTechnique = BoardRating::Enumeration;
+            for(int idx : std::as_const(analysis.safeCells))
+            {
+                if(visible.at(idx) != Solver::Covered)
+                    continue;
+                reveal(idx);
+                rating.steps++;
+            }
+            continue;
+        }
+
+        int guess = -1;
+        for(int idx=0; idx<field.size(); ++idx)
+        {
+            if(visible.at(idx) != Solver::Covered || field.at(idx) == FieldGenerator::Mine)
+                continue;
+            if(guess == -1 || analysis.mineProbability.at(idx) < analysis.mineProbability.at(guess))
+                guess = idx;
+        }
+        Q_ASSERT(guess != -1);
+        rating.guesses.append(analysis.mineProbability.at(guess));
+        reveal(guess);
+        rating.steps++;
+    }
+    return rating;
+}
+
+}
+
+BoardRating BoardRating::rate(int numRows, int numCols, int numMines,
+                              const QVector<qint8>& field, int clickedIdx)
+{
+    auto analyse = [&](const QVector<qint8>& cells) {
+        return Solver::analyse(numRows, numCols, numMines, cells,
+                               Solver::CancelCheck(), RATING_SEARCH_STEPS);
+    };
+    return withGeometry(numRows, numCols, [&](const auto& geometry) {
+        return rateOn(geometry, analyse, numMines, field, clickedIdx);
+    });
+}
+
+BoardRating BoardRating::rate(const BoardTopology& topology, int numMines,
+                              const QVector<qint8>& field, int clickedIdx)
+{
+    auto analyse = [&](const QVector<qint8>& cells) {
+        return Solver::analyse(topology, numMines, cells,
+                               Solver::CancelCheck(), RATING_SEARCH_STEPS);
+    };
+    return withGeometry(topology, [&](const auto& geometry) {
+        return rateOn(geometry, analyse, numMines, field, clickedIdx);
+    });
+}
@@ -0,0 +1,106 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDRATING_H
+#define BOARDRATING_H
+
+// Qt
+#include <QVector>
+
+class BoardTopology;
+
+/**
+ * How hard a board is to clear by logic, found by letting the solver
+ * play it from the first click.
+ *
+ * Each step opens every cell proven safe by the cheapest technique
+ * that finds any. When nothing can be proven, the safest cell which
+ * holds no mine is opened as a guess, so the replay always clears
+ * the board.
+ */
+struct BoardRating
+{
+    enum Technique
+    {
+        /**
+         * First click alone clears the board
+         */
+        Opening,
+        /**
+         * Digits whose covered neighbours are all safe or all mines
+         */
+        Propagation,
+        /**
+         * Two digits where the covered neighbours of one are among those of the other
+         */
+        Subsets,
+        /**
+         * Several digits or the mine count together
+         */
+        Enumeration
+    };
+
+    /**
+     * Number of levels, level() is in [0, LevelCount-1]
+     */
+    enum { LevelCount = 16 };
+    /**
+     * Boards up to this level never need a guess
+     */
+    static constexpr int MAXIMAL_NO_GUESS_LEVEL = 1;
+
+    /**
+     * Hardest technique needed by a deduction
+     */
+    Technique hardestTechnique = Opening;
+    /**
+     * Mine probability of every guess made, in order
+     */
+    QVector<float> guesses;
+    /**
+     * Number of times cells were opened after the first click,
+     * -1 if the board wasn't rated
+     */
+    int steps = -1;
+    /**
+     * Level of a board rated before, e.g. one of a corpus, whose replay
+     * isn't known; -1 if level() is computed from the replay
+     */
+    int knownLevel = -1;
+
+    bool isValid() const { return steps >= 0 || knownLevel >= 0; }
+    /**
+     * @return probability that all guesses are lucky
+     */
+    double survival() const;
+    /**
+     * Summarizes the rating in one number: 0 for boards cleared by
+     * Propagation, 1 for those needing a harder technique. Boards which
+     * need guesses start at 2, one level more every time the odds to
+     * survive them halve
+     */
+    int level() const;
+
+    /**
+     * @return rating of a board known only by its level
+     */
+    static BoardRating fromLevel(int level);
+    /**
+     * Rates a field.
+     *
+     * @param field row-major array of numRows*numCols digits, or FieldGenerator::Mine
+     * @param clickedIdx first click, must be safe
+     */
+    static BoardRating rate(int numRows, int numCols, int numMines,
+                            const QVector<qint8>& field, int clickedIdx);
+    /**
+     * Rates a field of any topology, cells are kept as described by topology
+     */
+    static BoardRating rate(const BoardTopology& topology, int numMines,
+                            const QVector<qint8>& field, int clickedIdx);
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardsnapshot.h"
+
+// own
+#include "kmines_debug.h"
+// Qt
+#include <QCoreApplication>
+// Std
+#include <atomic>
+
+// segments are never smaller than this, so that usual field
+// resizes don't require creating a new segment
+static const int MINIMAL_SEGMENT_SIZE = 4096;
+// segment numbers tried when keys are still taken by segments
+// of an earlier process with the same pid
+static const int MAXIMAL_SEGMENT_ATTEMPTS = 16;
+
+BoardSnapshot::BoardSnapshot()
+    : m_memory(new QSharedMemory)
+{
+}
+
+BoardSnapshot::~BoardSnapshot()
+{
+    close();
+}
+
+QString BoardSnapshot::keyForProcess(qint64 pid, quint32 segment)
+{
+    if(segment == 0)
+        return QStringLiteral("org.kde.kmines.board.%1").arg(pid);
+    return QStringLiteral("org.kde.kmines.board.%1.%2").arg(pid).arg(segment);
+}
+
+BoardSnapshotHeader* BoardSnapshot::header()
+{
+    return static_cast<BoardSnapshotHeader*>(m_memory->data());
+}
+
+uchar* BoardSnapshot::cells()
+{
+    return static_cast<uchar*>(m_memory->data()) + sizeof(BoardSnapshotHeader);
+}
+
+void BoardSnapshot::close(quint32 successor)
+{
+    if(!m_memory->isAttached())
+        return;
+    header()->successor.storeRelaxed(successor);
+    header()->state.storeRelease(BoardSnapshotHeader::Closed);
+    m_memory->detach();
+}
+
+bool BoardSnapshot::reset(int numRows, int numCols, BoardSnapshotHeader::Topology topology)
+{
+    Q_ASSERT(m_updateDepth == 0);
+
+    const int cellBytes = (numRows*numCols + 1) / 2;
+    const int neededSize = static_cast<int>(sizeof(BoardSnapshotHeader)) + cellBytes;
+
+    if(!m_memory->isAttached() || m_memory->size() < neededSize)
+    {
+        int size = MINIMAL_SEGMENT_SIZE;
+        while(size < neededSize)
+            size *= 2;
+
+        // readers may keep the old segment and its key alive,
+        // so a bigger one always gets a key of its own
+        const bool replacing = m_memory->isAttached();
+        QScopedPointer<QSharedMemory> memory(new QSharedMemory);
+        quint32 segment = replacing ? m_segment + 1 : 0;
+        for(int attempt=0; attempt<MAXIMAL_SEGMENT_ATTEMPTS; ++attempt, ++segment)
+        {
+            memory->setKey(keyForProcess(QCoreApplication::applicationPid(), segment));
+            if(memory->create(size) || memory->error() != QSharedMemory::AlreadyExists)
+                break;
+        }
+        if(!memory->isAttached())
+        {
+            qCWarning(KMINES_LOG) << "Unable to create board snapshot segment:" << memory->errorString();
+            return false;
+        }
+        close(segment);
+        m_memory.swap(memory);
+        m_segment = segment;
+
+        BoardSnapshotHeader* h = header();
+        h->magic = BoardSnapshotHeader::Magic;
+        h->version = BoardSnapshotHeader::Version;
+        h->successor.storeRelaxed(0);
+        h->sequence.storeRelaxed(0);
+        h->generation.storeRelaxed(0);
+        h->state.storeRelease(BoardSnapshotHeader::Live);
+        qCDebug(KMINES_LOG) << "Publishing board snapshot as" << m_memory->key();
+    }
+
+    beginUpdate();
+    BoardSnapshotHeader* h = header();
+    h->rows = numRows;
+    h->cols = numCols;
+    h->topology = topology;
+    m_numCols = numCols;
+    // both nibbles set to Covered
+    memset(cells(), BoardSnapshotHeader::Covered | (BoardSnapshotHeader::Covered << 4), cellBytes);
+    endUpdate();
+    return true;
+}
+
+void BoardSnapshot::beginUpdate()
+{
+    if(!m_memory->isAttached() || m_updateDepth++ > 0)
+        return;
+    BoardSnapshotHeader* h = header();
+    h->sequence.storeRelaxed(h->sequence.loadRelaxed() + 1);
+    // make sure readers see the odd sequence before any cell write
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BoardSnapshot::endUpdate()
+{
+    if(!m_memory->isAttached() || --m_updateDepth > 0)
+        return;
+    BoardSnapshotHeader* h = header();
+    h->generation.storeRelaxed(h->generation.loadRelaxed() + 1);
+    h->sequence.storeRelease(h->sequence.loadRelaxed() + 1);
+}
+
+void BoardSnapshot::setCell(int row, int col, BoardSnapshotHeader::Cell value)
+{
+    if(!m_memory->isAttached())
+        return;
+
+    const Transaction transaction(this);
+    const int idx = row*m_numCols + col;
+    uchar& byte = cells()[idx / 2];
+    if(idx % 2 == 0)
+        byte = (byte & 0xf0) | value;
+    else
+        byte = (byte & 0x0f) | (value << 4);
+}
@@ -0,0 +1,141 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDSNAPSHOT_H
+#define BOARDSNAPSHOT_H
+
+// Qt
+#include <QAtomicInteger>
+#include <QScopedPointer>
+#include <QSharedMemory>
+
+/**
+ * Layout of the shared memory segment published by BoardSnapshot.
+ *
+ * The header is followed by rows*cols cells packed as 4-bit values,
+ * two cells per byte (low nibble first), in row-major order.
+ * Only what the player can see is published, covered cells never
+ * leak their content. Cells left out of shaped boards are Inactive,
+ * they have no neighbours and are no one's neighbour.
+ *
+ * Readers must follow the seqlock protocol:
+ * read sequence (retry while odd), copy what is needed,
+ * read sequence again and retry if it changed.
+ *
+ * A segment is never resized. When a bigger board needs more room, a new
+ * segment is created under the key of the next segment number and the
+ * old one is closed with that number in successor.
+ */
+struct BoardSnapshotHeader
+{
+    enum { Magic = 0x42534d4b }; // "KMSB"
+    enum { Version = 4 };
+    enum State { Closed = 0, Live = 1 };
+    enum Cell { Digit0 = 0, /* 1..8 are revealed digits */ Covered = 9, Flagged = 10,
+                Questioned = 11, Mine = 12, Exploded = 13, WrongFlag = 14, Inactive = 15 };
+    /**
+     * Which cells are neighbours, in the order of BoardTopology::Kind:
+     * Square has up to 8 neighbours. Hexagonal shifts odd rows right by
+     * half a cell, each cell touches 2 cells in its row and 2 in each
+     * of the rows above and below. Torus is square with opposite edges
+     * touching. Layers keeps 2 layers of cols/2 columns side by side in
+     * the rows, cells touch the 4 cells sharing a side and the cell at
+     * the same place on the other layer
+     */
+    enum Topology { Square = 0, Hexagonal = 1, Torus = 2, Layers = 3 };
+
+    quint32 magic;
+    quint32 version;
+    /**
+     * Set to Closed when the game stops updating this segment
+     * (e.g. it was replaced by a bigger one); readers should reattach
+     */
+    QAtomicInteger<quint32> state;
+    /**
+     * Number of the segment replacing this one once it is closed,
+     * 0 if the game stopped publishing
+     */
+    QAtomicInteger<quint32> successor;
+    /**
+     * Seqlock counter, odd while an update is in progress
+     */
+    QAtomicInteger<quint32> sequence;
+    /**
+     * Incremented once per published update. Every cell change is
+     * published as soon as it happens, a reader never waits for
+     * the end of a whole cascade
+     */
+    QAtomicInteger<quint64> generation;
+    quint32 rows;
+    quint32 cols;
+    quint32 topology;
+};
+
+/**
+ * Opt-in publisher of the visible board state in shared memory,
+ * so that local bots and analysers can poll it without any
+ * request/response round-trips.
+ * The writer never waits on readers.
+ */
+class BoardSnapshot
+{
+public:
+    BoardSnapshot();
+    ~BoardSnapshot();
+    /**
+     * @return shared memory key readers should attach to, the first
+     * segment has number 0, its successors are numbered from 1
+     */
+    static QString keyForProcess(qint64 pid, quint32 segment = 0);
+    /**
+     * (Re)initializes segment for a field of given size, all cells covered.
+     * Returns false if shared memory could not be created.
+     */
+    bool reset(int numRows, int numCols, BoardSnapshotHeader::Topology topology);
+    /**
+     * Starts a batch of cell updates. Calls may be nested,
+     * the batch is published when the outermost endUpdate() is reached
+     */
+    void beginUpdate();
+    void endUpdate();
+    /**
+     * Sets the published value of a single cell.
+     * If called outside of begin/endUpdate it is published immediately.
+     */
+    void setCell(int row, int col, BoardSnapshotHeader::Cell value);
+
+    /**
+     * Helper which calls beginUpdate/endUpdate on a possibly null snapshot
+     */
+    class Transaction
+    {
+    public:
+        explicit Transaction(BoardSnapshot* snapshot) : m_snapshot(snapshot)
+            { if(m_snapshot) m_snapshot->beginUpdate(); }
+        ~Transaction() { if(m_snapshot) m_snapshot->endUpdate(); }
+    private:
+        Q_DISABLE_COPY(Transaction)
+        BoardSnapshot* m_snapshot;
+    };
+private:
+    BoardSnapshotHeader* header();
+    uchar* cells();
+    /**
+     * Stops publishing in current segment, telling readers to
+     * continue in the given one
+     */
+    void close(quint32 successor = 0);
+
+    QScopedPointer<QSharedMemory> m_memory;
+    /**
+     * Number of the current segment, or of the last one if none is attached
+     */
+    quint32 m_segment = 0;
+    int m_numCols = 0;
+    int m_updateDepth = 0;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardtopology.h"
+
+// own
+#include "fieldgenerator.h"
+// Std
+#include <cmath>
+
+BoardTopology::BoardTopology(Kind kind, int numRows, int numCols, const QBitArray& active)
+    : m_kind(kind), m_numRows(numRows),
+      m_numCols(kind == Layers ? numCols*LayerCount : numCols), m_layerCols(numCols)
+{
+    if(active.size() == numCells() && active.count(true) != numCells())
+        m_active = active;
+
+    m_offsets.reserve(numCells() + 1);
+    m_neighbours.reserve(numCells()*MAXIMAL_NEIGHBOURS);
+    for(int row=0; row<m_numRows; ++row)
+        for(int col=0; col<m_numCols; ++col)
+        {
+            m_offsets.append(m_neighbours.size());
+            if(!isActive(row*m_numCols + col))
+                continue;
+            switch(m_kind)
+            {
+                case Square:
+                    for(int r=row-1; r<=row+1; ++r)
+                        for(int c=col-1; c<=col+1; ++c)
+                            if(r != row || c != col)
+                                addNeighbour(r, c);
+                    break;
+                case Hexagonal:
+                {
+                    // rows above and below touch two cells, shifted with the row
+                    const int shift = row % 2 == 0 ? -1 : 0;
+                    addNeighbour(row-1, col + shift);
+                    addNeighbour(row-1, col + shift + 1);
+                    addNeighbour(row, col-1);
+                    addNeighbour(row, col+1);
+                    addNeighbour(row+1, col + shift);
+                    addNeighbour(row+1, col + shift + 1);
+                    break;
+                }
+                case Torus:
+                    for(int r=row-1; r<=row+1; ++r)
+                        for(int c=col-1; c<=col+1; ++c)
+                        {
+                            const int wrappedRow = (r + m_numRows) % m_numRows;
+                            const int wrappedCol = (c + m_numCols) % m_numCols;
+                            // small boards wrap onto the cell itself or twice onto the same cell
+                            const int idx = wrappedRow*m_numCols + wrappedCol;
+                            if(idx != row*m_numCols + col && !isNeighbour(row*m_numCols + col, idx))
+                                addNeighbour(wrappedRow, wrappedCol);
+                        }
+                    break;
+                case Layers:
+                {
+                    const int layer = col / m_layerCols;
+                    const int layerCol = col % m_layerCols;
+                    addNeighbour(row-1, col);
+                    if(layerCol > 0)
+                        addNeighbour(row, col-1);
+                    if(layerCol < m_layerCols-1)
+                        addNeighbour(row, col+1);
+                    addNeighbour(row+1, col);
+                    if(layer > 0)
+                        addNeighbour(row, col - m_layerCols);
+                    if(layer < LayerCount-1)
+                        addNeighbour(row, col + m_layerCols);
+                    break;
+                }
+            }
+        }
+    m_offsets.append(m_neighbours.size());
+}
+
+void BoardTopology::addNeighbour(int row, int col)
+{
+    if(row >= 0 && row < m_numRows && col >= 0 && col < m_numCols && isActive(row*m_numCols + col))
+        m_neighbours.append(row*m_numCols + col);
+}
+
+int BoardTopology::activeCount() const
+{
+    return m_active.isEmpty() ? numCells() : m_active.count(true);
+}
+
+bool BoardTopology::isNeighbour(int idx, int other) const
+{
+    // also used while the table of idx is being built
+    const int end = idx + 1 < m_offsets.size() ? m_offsets.at(idx+1) : m_neighbours.size();
+    for(int i=m_offsets.at(idx); i<end; ++i)
+        if(m_neighbours.at(i) == other)
+            return true;
+    return false;
+}
+
+void BoardTopology::computeDigits(QVector<qint8>& field) const
+{
+    Q_ASSERT(field.size() == numCells());
+    for(int idx=0; idx<field.size(); ++idx)
+    {
+        if(field.at(idx) == FieldGenerator::Mine)
+            continue;
+        qint8 digit = 0;
+        forNeighbours(idx, [&](int other) {
+            if(field.at(other) == FieldGenerator::Mine)
+                digit++;
+        });
+        field[idx] = digit;
+    }
+}
+
+QPointF BoardTopology::cellPosition(int idx) const
+{
+    const int row = idx / m_numCols;
+    const int col = idx % m_numCols;
+    switch(m_kind)
+    {
+        case Hexagonal:
+            return QPointF(col + (row % 2 == 0 ? 0.0 : 0.5), row);
+        case Layers:
+            // one empty column between layers
+            return QPointF(col / m_layerCols * (m_layerCols + 1) + col % m_layerCols, row);
+        default:
+            return QPointF(col, row);
+    }
+}
+
+QSizeF BoardTopology::size() const
+{
+    switch(m_kind)
+    {
+        case Hexagonal:
+            return QSizeF(m_numRows > 1 ? m_numCols + 0.5 : m_numCols, m_numRows);
+        case Layers:
+            return QSizeF(LayerCount*(m_layerCols + 1) - 1, m_numRows);
+        default:
+            return QSizeF(m_numCols, m_numRows);
+    }
+}
+
+int BoardTopology::cellAt(const QPointF& pos) const
+{
+    if(pos.y() < 0 || pos.x() < 0)
+        return -1;
+    const int row = static_cast<int>(pos.y());
+    if(row >= m_numRows)
+        return -1;
+
+    int col = -1;
+    switch(m_kind)
+    {
+        case Hexagonal:
+            col = static_cast<int>(std::floor(pos.x() - (row % 2 == 0 ? 0.0 : 0.5)));
+            break;
+        case Layers:
+        {
+            const int x = static_cast<int>(pos.x());
+            const int layer = x / (m_layerCols + 1);
+            const int layerCol = x % (m_layerCols + 1);
+            if(layer >= LayerCount || layerCol == m_layerCols)
+                return -1;
+            col = layer*m_layerCols + layerCol;
+            break;
+        }
+        default:
+            col = static_cast<int>(pos.x());
+            break;
+    }
+    if(col < 0 || col >= m_numCols || !isActive(row*m_numCols + col))
+        return -1;
+    return row*m_numCols + col;
+}
@@ -0,0 +1,132 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDTOPOLOGY_H
+#define BOARDTOPOLOGY_H
+
+// Qt
+#include <QBitArray>
+#include <QPointF>
+#include <QSizeF>
+#include <QVector>
+
+/**
+ * Which cells of a board are neighbours, and where cells are shown.
+ *
+ * Cells are kept row-major in numRows() rows of numCols() cells, as on
+ * the square grid. Neighbours of all cells are computed once in one
+ * flat array indexed by per-cell offsets, so code iterating them needs
+ * no geometry branches whatever the shape. Copies are cheap, the
+ * tables are implicitly shared.
+ *
+ * Boards may have inactive cells, e.g. to give the board another
+ * outline. Such cells are kept like the others but they have no
+ * neighbours and are no one's neighbour.
+ *
+ * BoardTopology can be used as geometry by the algorithms in
+ * boardgeometry.h, see withGeometry().
+ */
+class BoardTopology
+{
+public:
+    enum Kind
+    {
+        /**
+         * Classic grid, up to 8 neighbours
+         */
+        Square,
+        /**
+         * Odd rows are shifted by half a cell, 6 neighbours
+         */
+        Hexagonal,
+        /**
+         * Square grid whose opposite edges touch, always 8 neighbours
+         */
+        Torus,
+        /**
+         * LayerCount square grids stacked on each other and shown side
+         * by side. Neighbours are the 4 cells sharing a side and the
+         * cells right above and below, up to 6
+         */
+        Layers
+    };
+    /**
+     * Number of layers of Layers boards
+     */
+    static constexpr int LayerCount = 2;
+    /**
+     * No cell has more neighbours in any topology
+     */
+    static constexpr int MAXIMAL_NEIGHBOURS = 8;
+
+    BoardTopology() = default;
+    /**
+     * @param numRows, numCols size of the board, or of each layer of Layers boards
+     * @param active one bit per cell, row-major in numRows()*numCols() cells,
+     * all cells are active if empty
+     */
+    BoardTopology(Kind kind, int numRows, int numCols, const QBitArray& active = QBitArray());
+
+    Kind kind() const { return m_kind; }
+    /**
+     * @return number of rows and columns cells are kept in,
+     * all layers are side by side in the rows of Layers boards
+     */
+    int numRows() const { return m_numRows; }
+    int numCols() const { return m_numCols; }
+    int numCells() const { return m_numRows*m_numCols; }
+    /**
+     * @return false if some cells are inactive
+     */
+    bool isComplete() const { return m_active.isEmpty(); }
+    bool isActive(int idx) const { return m_active.isEmpty() || m_active.testBit(idx); }
+    int activeCount() const;
+
+    template<typename Function>
+    void forNeighbours(int idx, Function&& function) const
+    {
+        const int* neighbours = m_neighbours.constData();
+        for(int i=m_offsets.at(idx); i<m_offsets.at(idx+1); ++i)
+            function(neighbours[i]);
+    }
+    bool isNeighbour(int idx, int other) const;
+    /**
+     * Fills digits of all cells of field not holding FieldGenerator::Mine
+     */
+    void computeDigits(QVector<qint8>& field) const;
+
+    /**
+     * @return top left corner of the cell, in cells
+     */
+    QPointF cellPosition(int idx) const;
+    /**
+     * @return size of the bounding rect of all cells, in cells
+     */
+    QSizeF size() const;
+    /**
+     * @return active cell shown at pos, in cells, or -1 if none
+     */
+    int cellAt(const QPointF& pos) const;
+
+private:
+    void addNeighbour(int row, int col);
+
+    Kind m_kind = Square;
+    int m_numRows = 0;
+    int m_numCols = 0;
+    /**
+     * Columns per layer, numCols for other topologies
+     */
+    int m_layerCols = 0;
+    QBitArray m_active;
+    /**
+     * Neighbours of cell idx are m_neighbours[m_offsets[idx]] to m_neighbours[m_offsets[idx+1]-1]
+     */
+    QVector<int> m_offsets;
+    QVector<int> m_neighbours;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardview.h"
+
+// Std
+#include <cstring>
+
+static quint64 mix(quint64 value)
+{
+    // splitmix64 finalizer
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+static quint64 cellHash(int idx, qint8 value)
+{
+    // flags don't tell anything about the board, so covered
+    // and flagged cells hash the same
+    if(value < 0)
+        return 0;
+    return mix(quint64(idx) << 8 | quint8(value));
+}
+
+BoardView::BoardView()
+    : d(new Data)
+{
+}
+
+BoardView::BoardView(int numRows, int numCols, int numMines)
+    : d(new Data)
+{
+    d->numRows = numRows;
+    d->numCols = numCols;
+    d->numMines = numMines;
+    d->hash = mix(quint64(numRows) << 40 ^ quint64(numCols) << 20 ^ quint64(numMines));
+
+    const int numCells = numRows*numCols;
+    d->chunks.resize((numCells + ChunkSize - 1) / ChunkSize);
+    for(QSharedDataPointer<Chunk>& chunk : d->chunks)
+    {
+        chunk = new Chunk;
+        std::memset(chunk->cells, Covered, ChunkSize);
+    }
+}
+
+QVector<qint8> BoardView::cells() const
+{
+    const int numCells = d->numRows*d->numCols;
+    QVector<qint8> result(numCells);
+    for(int first=0; first<numCells; first+=ChunkSize)
+        std::memcpy(result.data() + first, d->chunks.at(first / ChunkSize)->cells,
+                    qMin(int(ChunkSize), numCells - first));
+    return result;
+}
+
+void BoardView::setCell(int idx, qint8 value)
+{
+    const qint8 old = cell(idx);
+    // copies the chunk list and the chunk if they are shared with published versions
+    d->hash ^= cellHash(idx, old) ^ cellHash(idx, value);
+    d->chunks[idx / ChunkSize]->cells[idx % ChunkSize] = value;
+}
+
+void BoardPublisher::reset(int numRows, int numCols, int numMines)
+{
+    m_working = BoardView(numRows, numCols, numMines);
+    m_changed = false;
+    QMutexLocker locker(&m_mutex);
+    m_current = m_working;
+}
+
+void BoardPublisher::setCell(int idx, qint8 value)
+{
+    if(m_working.cell(idx) == value)
+        return;
+    m_working.setCell(idx, value);
+    m_changed = true;
+}
+
+BoardView BoardPublisher::publish()
+{
+    if(m_changed)
+    {
+        m_working.d->version = m_current.version() + 1;
+        m_changed = false;
+        // readers holding older versions keep them alive until they are done
+        QMutexLocker locker(&m_mutex);
+        m_current = m_working;
+    }
+    return m_current;
+}
+
+BoardView BoardPublisher::current() const
+{
+    // only takes a reference, the lock is never held for longer
+    QMutexLocker locker(&m_mutex);
+    return m_current;
+}
@@ -0,0 +1,114 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+// Qt
+#include <QMutex>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVector>
+
+/**
+ * Immutable version of the board as seen by the player.
+ *
+ * Views are implicitly shared and can be copied and read from any
+ * thread. Cells are stored in chunks shared between versions, so
+ * a new version only copies the chunks changed since the previous one.
+ * A version is freed when the last view referring to it goes away.
+ */
+class BoardView
+{
+public:
+    /**
+     * Cell values, other cells hold their revealed digit
+     */
+    static constexpr qint8 Covered = -1;
+    static constexpr qint8 Flagged = -2;
+    /**
+     * Number of cells per chunk
+     */
+    enum { ChunkSize = 4096 };
+
+    /**
+     * Constructs an empty board
+     */
+    BoardView();
+    BoardView(int numRows, int numCols, int numMines);
+
+    int numRows() const { return d->numRows; }
+    int numCols() const { return d->numCols; }
+    int numMines() const { return d->numMines; }
+    /**
+     * Increases with every published version of the same board
+     */
+    quint64 version() const { return d->version; }
+    /**
+     * Hash of the cells, flagged and covered cells hash the same
+     */
+    quint64 hash() const { return d->hash; }
+
+    qint8 cell(int idx) const { return d->chunks.at(idx / ChunkSize)->cells[idx % ChunkSize]; }
+    /**
+     * @return all cells in row-major order
+     */
+    QVector<qint8> cells() const;
+private:
+    friend class BoardPublisher;
+
+    struct Chunk : public QSharedData
+    {
+        qint8 cells[ChunkSize];
+    };
+    struct Data : public QSharedData
+    {
+        int numRows = 0;
+        int numCols = 0;
+        int numMines = 0;
+        quint64 version = 0;
+        quint64 hash = 0;
+        QVector<QSharedDataPointer<Chunk>> chunks;
+    };
+
+    void setCell(int idx, qint8 value);
+
+    QSharedDataPointer<Data> d;
+};
+
+/**
+ * Writer side of BoardView, owned by the thread changing the board.
+ *
+ * Cells are changed on a working copy, publish() makes it the current
+ * version for all readers. Readers never wait for the writer, current()
+ * only takes a reference to the latest version.
+ */
+class BoardPublisher
+{
+public:
+    /**
+     * Starts a new board, all cells covered, and publishes it
+     */
+    void reset(int numRows, int numCols, int numMines);
+    void setCell(int idx, qint8 value);
+    /**
+     * Publishes changes made since the last call, if any
+     *
+     * @return the published version
+     */
+    BoardView publish();
+    /**
+     * @return latest published version, may be called from any thread
+     */
+    BoardView current() const;
+private:
+    BoardView m_working;
+    bool m_changed = false;
+    mutable QMutex m_mutex;
+    BoardView m_current;
+};
+
+#endif
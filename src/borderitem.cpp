@@ -7,15 +7,20 @@
 
 #include "borderitem.h"
 
+// own
+#include "spriteatlas.h"
+// KDEGames
+#include <KGameRenderer>
+
 QHash<KMinesState::BorderElement, QString> BorderItem::s_elementNames;
+QHash<KMinesState::BorderElement, QStringList> BorderItem::s_fallbackNames;
 
-BorderItem::BorderItem( KGameRenderer* renderer, QGraphicsItem* parent )
-    : KGameRenderedItem(renderer, QString(), parent), m_element(KMinesState::BorderEast),
+BorderItem::BorderItem( SpriteAtlas* atlas, QGraphicsItem* parent )
+    : SpriteItem(atlas, parent), m_element(KMinesState::BorderEast),
       m_row(-1), m_col(-1)
 {
     if(s_elementNames.isEmpty())
         fillNameHash();
-    setShapeMode(BoundingRectShape);
 }
 
 void BorderItem::setBorderType(KMinesState::BorderElement e)
@@ -42,7 +47,11 @@ int BorderItem::col() const
 
 void BorderItem::updatePixmap()
 {
-    setSpriteKey(s_elementNames[m_element]);
+    const QString& name = s_elementNames[m_element];
+    if(s_fallbackNames.contains(m_element) && !atlas()->renderer()->spriteExists(name))
+        setSpriteKeys(s_fallbackNames[m_element]);
+    else
+        setSpriteKeys(QStringList(name));
 }
 
 int BorderItem::type() const
@@ -60,4 +69,26 @@ void BorderItem::fillNameHash()
     s_elementNames[KMinesState::BorderCornerNW] = QStringLiteral( "border.outsideCorner.nw" );
     s_elementNames[KMinesState::BorderCornerSW] = QStringLiteral( "border.outsideCorner.sw" );
     s_elementNames[KMinesState::BorderCornerSE] = QStringLiteral( "border.outsideCorner.se" );
+    s_elementNames[KMinesState::BorderInsideCornerNE] = QStringLiteral( "border.insideCorner.ne" );
+    s_elementNames[KMinesState::BorderInsideCornerNW] = QStringLiteral( "border.insideCorner.nw" );
+    s_elementNames[KMinesState::BorderInsideCornerSW] = QStringLiteral( "border.insideCorner.sw" );
+    s_elementNames[KMinesState::BorderInsideCornerSE] = QStringLiteral( "border.insideCorner.se" );
+    s_elementNames[KMinesState::BorderBayNorth] = QStringLiteral( "border.bay.north" );
+    s_elementNames[KMinesState::BorderBaySouth] = QStringLiteral( "border.bay.south" );
+    s_elementNames[KMinesState::BorderBayEast] = QStringLiteral( "border.bay.east" );
+    s_elementNames[KMinesState::BorderBayWest] = QStringLiteral( "border.bay.west" );
+
+    // an inside corner touches cells on two sides, a bay on three
+    const QString north = s_elementNames[KMinesState::BorderNorth];
+    const QString south = s_elementNames[KMinesState::BorderSouth];
+    const QString east = s_elementNames[KMinesState::BorderEast];
+    const QString west = s_elementNames[KMinesState::BorderWest];
+    s_fallbackNames[KMinesState::BorderInsideCornerNE] = QStringList{north, east};
+    s_fallbackNames[KMinesState::BorderInsideCornerNW] = QStringList{north, west};
+    s_fallbackNames[KMinesState::BorderInsideCornerSW] = QStringList{south, west};
+    s_fallbackNames[KMinesState::BorderInsideCornerSE] = QStringList{south, east};
+    s_fallbackNames[KMinesState::BorderBayNorth] = QStringList{north, east, west};
+    s_fallbackNames[KMinesState::BorderBaySouth] = QStringList{south, east, west};
+    s_fallbackNames[KMinesState::BorderBayEast] = QStringList{east, north, south};
+    s_fallbackNames[KMinesState::BorderBayWest] = QStringList{west, north, south};
 }
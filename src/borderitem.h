@@ -10,22 +10,27 @@
 
 // own
 #include "commondefs.h"
-// KDEGames
-#include <KGameRenderedItem>
-
-class KGameRenderer;
+#include "spriteitem.h"
+// Qt
+#include <QHash>
 
 /**
- * Graphics item representing border cell
+ * Graphics item representing border cell.
+ *
+ * Borders of shaped boards also need inside corners and bays, themes
+ * without these sprites get them drawn from edges.
  */
-class BorderItem : public KGameRenderedItem
+class BorderItem : public SpriteItem
 {
 public:
-    BorderItem( KGameRenderer* renderer, QGraphicsItem* parent );
+    BorderItem( SpriteAtlas* atlas, QGraphicsItem* parent );
     void setBorderType( KMinesState::BorderElement e );
     void setRowCol( int row, int col );
     Q_REQUIRED_RESULT int row() const;
     Q_REQUIRED_RESULT int col() const;
+    /**
+     * Fetches the sprites of the border type from the current theme
+     */
     void updatePixmap();
 
     // enable use of qgraphicsitem_cast
@@ -33,6 +38,10 @@ public:
     Q_REQUIRED_RESULT int type() const override;
 private:
     static QHash<KMinesState::BorderElement, QString> s_elementNames;
+    /**
+     * Edges drawn instead of elements which not all themes have
+     */
+    static QHash<KMinesState::BorderElement, QStringList> s_fallbackNames;
     static void fillNameHash();
 
     KMinesState::BorderElement m_element;
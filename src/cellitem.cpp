@@ -14,129 +14,122 @@
 QHash<int, QString> CellItem::s_digitNames;
 QHash<KMinesState::CellState, QList<QString> > CellItem::s_stateNames;
 
-CellItem::CellItem(KGameRenderer* renderer, QGraphicsItem* parent)
-    : KGameRenderedItem(renderer, QString(), parent)
-{
-    if(s_digitNames.isEmpty())
-        fillNameHashes();
-    setShapeMode(BoundingRectShape);
-    reset();
-}
-
 void CellItem::unflag()
 {
-    m_state = KMinesState::Released;
-    updatePixmap();
+    setState(KMinesState::Released);
 }
 
 void CellItem::unexplode()
 {
-    m_exploded = false;
+    if(content() == ExplodedMine)
+        setContent(Mine);
 }
 
 bool CellItem::isRevealed() const
 {
-    return ( m_state == KMinesState::Revealed || m_state == KMinesState::Error);
+    return ( state() == KMinesState::Revealed || state() == KMinesState::Error);
 }
 
 bool CellItem::isFlagged() const
 {
-    return m_state == KMinesState::Flagged;
+    return state() == KMinesState::Flagged;
 }
 
 bool CellItem::isQuestioned() const
 {
-    return m_state == KMinesState::Questioned;
+    return state() == KMinesState::Questioned;
 }
 
 bool CellItem::isExploded() const
 {
-    return m_exploded;
+    return content() == ExplodedMine;
 }
 
+KMinesState::CellState CellItem::state() const
+{
+    return static_cast<KMinesState::CellState>(m_bits & StateMask);
+}
 
 void CellItem::reset()
 {
-    m_state = KMinesState::Released;
-    m_hasMine = false;
-    m_exploded = false;
-    m_digit = 0;
-    m_triviallyFlagged = false;
-    updatePixmap();
+    m_bits = 0;
 }
 
-void CellItem::updatePixmap()
+const QStringList& CellItem::spriteKeys() const
 {
-    QList<QGraphicsItem*> children = childItems();
-    qDeleteAll(children);
+    // keys only depend on state and content, the trivial flag doesn't show
+    static QHash<int, QStringList> s_keys;
+    const int visual = m_bits & (StateMask | ContentMask);
+    auto it = s_keys.constFind(visual);
+    if(it == s_keys.constEnd())
+        it = s_keys.insert(visual, spriteKeysFor(state(), digit(), hasMine(), isExploded()));
+    return it.value();
+}
 
-    QList<QString> spriteKeys = s_stateNames[m_state];
-    setSpriteKey(spriteKeys[0]);
-    for(int i=1; i<spriteKeys.count(); i++)
-        addOverlay(spriteKeys[i]);
-    if(m_state == KMinesState::Revealed)
+QStringList CellItem::spriteKeysFor(KMinesState::CellState state, int digit, bool hasMine, bool exploded)
+{
+    if(s_digitNames.isEmpty())
+        fillNameHashes();
+
+    QStringList spriteKeys = s_stateNames[state];
+    if(state == KMinesState::Revealed)
     {
-        if(m_digit != 0)
-            addOverlay(s_digitNames[m_digit]);
-        else if(m_hasMine)
+        if(digit != 0)
+            spriteKeys.append(s_digitNames[digit]);
+        else if(hasMine)
         {
-            if(m_exploded)
-                addOverlay(QStringLiteral( "explosion" ));
-            addOverlay(QStringLiteral( "mine" ));
+            if(exploded)
+                spriteKeys.append(QStringLiteral( "explosion" ));
+            spriteKeys.append(QStringLiteral( "mine" ));
         }
     }
-}
-
-void CellItem::setRenderSize(const QSize &renderSize)
-{
-    KGameRenderedItem::setRenderSize(renderSize);
-    const QList<QGraphicsItem*> children = childItems();
-    for (QGraphicsItem* item : children) {
-        ((KGameRenderedItem*)item)->setRenderSize(renderSize);
-    }
+    return spriteKeys;
 }
 
 void CellItem::setHasMine(bool hasMine)
 {
-    m_hasMine = hasMine;
-    m_triviallyFlagged = false;
+    setContent(hasMine ? Mine : 0);
+    m_bits &= ~TrivialBit;
 }
 
 bool CellItem::hasMine() const
 {
-    return m_hasMine;
+    return content() >= Mine;
 }
 
 void CellItem::setDigit(int digit)
 {
-    m_digit = digit;
-    updatePixmap();
+    setContent(digit);
 }
 
 int CellItem::digit() const
 {
-    return m_digit;
+    return hasMine() ? 0 : content();
 }
 
 void CellItem::press()
 {
-    if(m_state == KMinesState::Released)
-    {
-        m_state = KMinesState::Pressed;
-        updatePixmap();
-    }
+    if(state() == KMinesState::Released || state() == KMinesState::Hint)
+        setState(KMinesState::Pressed);
+}
+
+void CellItem::hint()
+{
+    if(state() == KMinesState::Released)
+        setState(KMinesState::Hint);
 }
 
 void CellItem::release(bool force)
 {
     // special case for mid-button magic
-    if(force && (m_state == KMinesState::Flagged || m_state == KMinesState::Questioned))
+    if(force && (state() == KMinesState::Flagged || state() == KMinesState::Questioned))
         return;
 
-    if(m_state == KMinesState::Pressed || force)
+    if(state() == KMinesState::Pressed || force)
     {
         // if we hold mine, let's explode
-        m_exploded = m_hasMine;
+        if(hasMine())
+            setContent(ExplodedMine);
         reveal();
     }
 }
@@ -146,32 +139,27 @@ void CellItem::mark()
     // this will provide cycling through
     // Released -> "?"-mark -> "RedFlag"-mark -> Released
 
-    if (m_triviallyFlagged)
+    if (isTriviallyFlagged())
         return;
 
     bool useQuestion = Settings::useQuestionMarks();
 
-    switch(m_state)
+    switch(state())
     {
         case KMinesState::Released:
-            m_state = KMinesState::Flagged;
+        case KMinesState::Hint:
+            setState(KMinesState::Flagged);
             break;
         case KMinesState::Flagged:
-            m_state = useQuestion ? KMinesState::Questioned : KMinesState::Released;
+            setState(useQuestion ? KMinesState::Questioned : KMinesState::Released);
             break;
         case KMinesState::Questioned:
-            m_state = KMinesState::Released;
+            setState(KMinesState::Released);
             break;
         default:
             // shouldn't be here
             break;
     } // end switch
-    updatePixmap();
-}
-
-int CellItem::type() const
-{
-    return Type;
 }
 
 void CellItem::reveal()
@@ -179,27 +167,22 @@ void CellItem::reveal()
     if(isRevealed())
         return; // already revealed
 
-    if(m_state == KMinesState::Flagged && m_hasMine == false)
-        m_state = KMinesState::Error;
+    if(state() == KMinesState::Flagged && !hasMine())
+        setState(KMinesState::Error);
     else
-        m_state = KMinesState::Revealed;
-    updatePixmap();
+        setState(KMinesState::Revealed);
 }
 
 void CellItem::unreveal()
 {
-    m_state = KMinesState::Released;
-    m_triviallyFlagged = false;
-    updatePixmap();
+    setState(KMinesState::Released);
+    m_bits &= ~TrivialBit;
 }
 
 void CellItem::undoPress()
 {
-    if(m_state == KMinesState::Pressed)
-    {
-        m_state = KMinesState::Released;
-        updatePixmap();
-    }
+    if(state() == KMinesState::Pressed)
+        setState(KMinesState::Released);
 }
 
 void CellItem::fillNameHashes()
@@ -227,21 +210,14 @@ void CellItem::fillNameHashes()
     s_stateNames[KMinesState::Hint].append(QStringLiteral( "hint" ));
 }
 
-void CellItem::addOverlay(const QString& spriteKey)
-{
-    KGameRenderedItem* overlay = new KGameRenderedItem(renderer(), spriteKey, this);
-    overlay->setRenderSize(renderSize());
-}
-
 void CellItem::triviallyFlag()
 {
     assert(hasMine());
-    m_triviallyFlagged = true;
-    m_state = KMinesState::Flagged;
-    updatePixmap();
+    m_bits |= TrivialBit;
+    setState(KMinesState::Flagged);
 }
 
 bool CellItem::isTriviallyFlagged() const
 {
-    return m_triviallyFlagged;
+    return m_bits & TrivialBit;
 }
@@ -11,29 +11,21 @@
 
 // own
 #include "commondefs.h"
-// KDEGames
-#include <KGameRenderedItem>
-
-class KGameRenderer;
+// Qt
+#include <QHash>
+#include <QStringList>
 
 /**
- * Graphics item representing single cell on
- * the game field.
- * Handles clicks, emits signals when something important happens :)
+ * State of single cell on the game field, packed in one byte.
+ *
+ * Cells are not graphics items: MineFieldItem keeps them in a plain
+ * array and paints the visible ones with pixmaps shared by all cells,
+ * so the memory used by a field grows with one byte per cell only.
  */
-class CellItem : public KGameRenderedItem
+class CellItem
 {
 public:
-    CellItem(KGameRenderer* renderer, QGraphicsItem* parent);
-    /**
-     * Updates item pixmap according to its current
-     * state and properties
-     */
-    void updatePixmap();
-    /**
-     * Reimplemented to pass the call on to any child items as well
-     */
-    void setRenderSize(const QSize &renderSize);
+    CellItem() = default;
     // FIXME: will it EVER be needed to setHasMine(false)???
     /**
      * Sets whether this item holds mine or not
@@ -87,6 +79,10 @@ public:
      * @return whether this cell is exploded
      */
     bool isExploded() const;
+    /**
+     * @return current state of this cell
+     */
+    KMinesState::CellState state() const;
     /**
      * Resets all properties & state of an item to default ones
      */
@@ -96,41 +92,43 @@ public:
     void release(bool force=false);
     void undoPress();
     void mark();
-    // enable use of qgraphicsitem_cast
-    enum { Type = UserType + 1 };
-    int type() const override;
     void triviallyFlag();
     bool isTriviallyFlagged() const;
-Q_SIGNALS:
-    /**
-     * Emitted when this item is revealed with mouse click
-     */
-    void revealed();
-private:
-    static QHash<int, QString> s_digitNames;
-    static QHash<KMinesState::CellState, QList<QString> > s_stateNames;
-    static void fillNameHashes();
     /**
-     * Current state of this item
+     * Shows a released cell as the suggested next move.
+     * The cell behaves like a released one otherwise
      */
-    KMinesState::CellState m_state;
+    void hint();
     /**
-     * True if this item holds mine
+     * @return sprite keys, bottom layer first, showing this cell
      */
-    bool m_hasMine;
+    const QStringList& spriteKeys() const;
     /**
-     * True if mine is exploded
+     * @return sprite keys, bottom layer first, of a cell in given state
      */
-    bool m_exploded;
+    static QStringList spriteKeysFor(KMinesState::CellState state, int digit, bool hasMine, bool exploded);
+private:
+    static QHash<int, QString> s_digitNames;
+    static QHash<KMinesState::CellState, QList<QString> > s_stateNames;
+    static void fillNameHashes();
+
     /**
-     * Specifies a digit this item holds. 0 if none
+     * Bits 0-2 hold the state, bits 3-6 the content
+     * and bit 7 is set when the cell was trivially flagged
      */
-    int m_digit;
+    enum { StateMask = 0x07, ContentShift = 3, ContentMask = 0x78, TrivialBit = 0x80 };
     /**
-     * Add a child object to display an overlayed pixmap
+     * Content values, 0 to 8 are digits
      */
-    void addOverlay(const QString& spriteKey);
-    bool m_triviallyFlagged = false;
+    enum { Mine = 9, ExplodedMine = 10 };
+
+    void setState(KMinesState::CellState state)
+        { m_bits = (m_bits & ~StateMask) | state; }
+    int content() const { return (m_bits & ContentMask) >> ContentShift; }
+    void setContent(int content)
+        { m_bits = (m_bits & ~ContentMask) | (content << ContentShift); }
+
+    quint8 m_bits = 0;
 };
 
 #endif
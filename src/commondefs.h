@@ -11,7 +11,9 @@ namespace KMinesState
 {
     enum CellState { Released, Pressed, Revealed, Questioned, Flagged, Error, Hint };
     enum BorderElement { BorderNorth, BorderSouth, BorderEast, BorderWest,
-                         BorderCornerNW, BorderCornerSW, BorderCornerNE, BorderCornerSE };
+                         BorderCornerNW, BorderCornerSW, BorderCornerNE, BorderCornerSE,
+                         BorderInsideCornerNW, BorderInsideCornerSW, BorderInsideCornerNE, BorderInsideCornerSE,
+                         BorderBayNorth, BorderBaySouth, BorderBayEast, BorderBayWest };
 }
 
 #endif
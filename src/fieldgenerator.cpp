@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fieldgenerator.h"
+
+// own
+#include "boardgeometry.h"
+// Qt
+#include <QRandomGenerator>
+
+namespace
+{
+
+template<typename Geometry>
+QVector<qint8> generateOn(const Geometry& geometry, int numMines, int clickedIdx, quint32 seed)
+{
+    const int size = geometry.numCells();
+    QVector<qint8> field(size, 0);
+
+    // these are the cells we don't want to put the mine in
+    // to ensure that clickedIdx will stay an empty cell
+    // (it will be empty if none of surrounding cells holds mine)
+    QVector<bool> forbidden(size, false);
+    for(int idx=0; idx<size; ++idx)
+        forbidden[idx] = !geometry.isActive(idx);
+    forbidden[clickedIdx] = true;
+    geometry.forNeighbours(clickedIdx, [&](int idx) { forbidden[idx] = true; });
+
+    QRandomGenerator random(seed);
+    int minesToPlace = numMines;
+    while(minesToPlace != 0)
+    {
+        const int randomIdx = random.bounded( size );
+        if(field.at(randomIdx) != FieldGenerator::Mine && !forbidden.at(randomIdx))
+        {
+            // ok, let's mine this place! :-)
+            field[randomIdx] = FieldGenerator::Mine;
+            minesToPlace--;
+        }
+    }
+
+    geometry.computeDigits(field);
+    return field;
+}
+
+}
+
+QVector<qint8> FieldGenerator::generate(int numRows, int numCols, int numMines, int clickedIdx, quint32 seed)
+{
+    return withGeometry(numRows, numCols, [=](const auto& geometry) {
+        return generateOn(geometry, numMines, clickedIdx, seed);
+    });
+}
+
+void FieldGenerator::computeDigits(int numRows, int numCols, QVector<qint8>& field)
+{
+    withGeometry(numRows, numCols, [&](const auto& geometry) {
+        geometry.computeDigits(field);
+    });
+}
+
+QVector<qint8> FieldGenerator::generate(const BoardTopology& topology, int numMines, int clickedIdx, quint32 seed)
+{
+    return withGeometry(topology, [=](const auto& geometry) {
+        return generateOn(geometry, numMines, clickedIdx, seed);
+    });
+}
+
+void FieldGenerator::computeDigits(const BoardTopology& topology, QVector<qint8>& field)
+{
+    withGeometry(topology, [&](const auto& geometry) {
+        geometry.computeDigits(field);
+    });
+}
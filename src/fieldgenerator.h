@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef FIELDGENERATOR_H
+#define FIELDGENERATOR_H
+
+// Qt
+#include <QVector>
+
+class BoardTopology;
+
+/**
+ * Generation of mine layouts, independent of any graphics item.
+ *
+ * All functions are reentrant, so boards can be generated
+ * on worker threads.
+ */
+class FieldGenerator
+{
+public:
+    /**
+     * Value used for mined cells, other cells hold their digit
+     */
+    static constexpr qint8 Mine = -1;
+    /**
+     * Minimal number of cells left free of mines on a field
+     */
+    static const int MINIMAL_FREE = 10;
+
+    /**
+     * Generates a field ensuring that cell at clickedIdx and all its
+     * neighbours are free of mines, so that the first click opens an
+     * empty area and the player doesn't have to guess at the start.
+     *
+     * @param clickedIdx row-major index of the first clicked cell
+     * @param seed seed of the random generator, same seed gives same field
+     * @return row-major array of numRows*numCols digits, or Mine
+     */
+    static QVector<qint8> generate(int numRows, int numCols, int numMines, int clickedIdx, quint32 seed);
+    /**
+     * Fills digits of all cells not holding Mine
+     */
+    static void computeDigits(int numRows, int numCols, QVector<qint8>& field);
+
+    /**
+     * Same for boards of any topology, cells are kept as described by
+     * topology. Inactive cells get neither mines nor digits
+     */
+    static QVector<qint8> generate(const BoardTopology& topology, int numMines, int clickedIdx, quint32 seed);
+    static void computeDigits(const BoardTopology& topology, QVector<qint8>& field);
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "gamerecord.h"
+
+// Qt
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+#include <QUuid>
+
+// records are a few kilobytes, anything big is no record
+static const qint64 MAXIMAL_FILE_SIZE = 4 << 20;
+
+static const char* const MOVE_NAMES[] = { "reveal", "chord", "mark" };
+
+QString GameRecord::fileSuffix()
+{
+    return QStringLiteral("kmg");
+}
+
+QString GameRecord::toText() const
+{
+    QString text;
+    text += QLatin1String("; KMines game record\n");
+    text += QLatin1String("board: ") + board.toString() + QLatin1Char('\n');
+    text += QLatin1String("player: ") + player + QLatin1Char('\n');
+    text += QLatin1String("started: ") + started.toString(Qt::ISODate) + QLatin1Char('\n');
+    text += QLatin1String("questionMarks: ") + QString::number(questionMarks) + QLatin1Char('\n');
+    text += QLatin1String("opened: ") + QString::number(opened) + QLatin1Char('\n');
+    text += QLatin1String("won: ") + QString::number(won) + QLatin1Char('\n');
+    for(const Move& move : moves)
+    {
+        text += QStringLiteral("%1 %2 %3 %4 %5\n").arg(move.time).arg(QLatin1String(MOVE_NAMES[move.kind]))
+                                                  .arg(move.cell).arg(move.revealed).arg(move.flagged);
+    }
+    return text;
+}
+
+GameRecord GameRecord::fromText(const QString& text)
+{
+    GameRecord record;
+    const QStringList lines = text.split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    for(const QString& line : lines)
+    {
+        if(line.startsWith(QLatin1Char(';')))
+            continue;
+
+        const int colon = line.indexOf(QLatin1Char(':'));
+        if(colon > 0 && !line.at(0).isDigit())
+        {
+            const QString key = line.left(colon).trimmed();
+            const QString value = line.mid(colon + 1).trimmed();
+            if(key == QLatin1String("board"))
+                record.board = BoardCode::fromString(value);
+            else if(key == QLatin1String("player"))
+                record.player = value;
+            else if(key == QLatin1String("started"))
+                record.started = QDateTime::fromString(value, Qt::ISODate);
+            else if(key == QLatin1String("questionMarks"))
+                record.questionMarks = value.toInt() != 0;
+            else if(key == QLatin1String("opened"))
+                record.opened = value.toInt() != 0;
+            else if(key == QLatin1String("won"))
+                record.won = value.toInt() != 0;
+            // unknown keys are left for newer versions
+            continue;
+        }
+
+        const QStringList fields = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        if(fields.size() != 5)
+            return GameRecord();
+        Move move;
+        bool ok[4];
+        move.time = fields.at(0).toInt(&ok[0]);
+        move.cell = fields.at(2).toInt(&ok[1]);
+        move.revealed = fields.at(3).toInt(&ok[2]);
+        move.flagged = fields.at(4).toInt(&ok[3]);
+        int kind = 0;
+        while(kind <= Mark && fields.at(1) != QLatin1String(MOVE_NAMES[kind]))
+            kind++;
+        if(!ok[0] || !ok[1] || !ok[2] || !ok[3] || kind > Mark)
+            return GameRecord();
+        move.kind = static_cast<MoveKind>(kind);
+        record.moves.append(move);
+    }
+
+    if(!record.board.isValid())
+        return GameRecord();
+    const int numCells = record.board.numRows()*record.board.numCols();
+    for(const Move& move : std::as_const(record.moves))
+    {
+        if(move.cell < 0 || move.cell >= numCells)
+            return GameRecord();
+    }
+    return record;
+}
+
+GameRecord GameRecord::load(const QString& fileName)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly) || file.size() > MAXIMAL_FILE_SIZE)
+        return GameRecord();
+    return fromText(QString::fromUtf8(file.readAll()));
+}
+
+bool GameRecord::save(const QString& directory) const
+{
+    if(!QDir().mkpath(directory))
+        return false;
+
+    // several boards may finish at the same moment
+    const QString name = started.toString(QStringLiteral("yyyyMMdd-hhmmss")) + QLatin1Char('-')
+                       + QUuid::createUuid().toString(QUuid::Id128).left(8) + QLatin1Char('.') + fileSuffix();
+    QSaveFile file(QDir(directory).filePath(name));
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(toText().toUtf8());
+    return file.commit();
+}
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+// own
+#include "boardcode.h"
+// Qt
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+/**
+ * Moves of one game, as written to the games folder when
+ * recording is enabled and read back by kmines-replaygrade.
+ *
+ * Records are small text files: a header of "key: value" lines
+ * followed by one line per move, "<ms> <kind> <cell> <revealed> <flagged>".
+ * Lines starting with ';' are comments.
+ */
+struct GameRecord
+{
+    enum MoveKind { Reveal, Chord, Mark };
+
+    struct Move
+    {
+        /**
+         * Milliseconds since the first click
+         */
+        int time = 0;
+        MoveKind kind = Reveal;
+        /**
+         * Row-major index of the clicked cell
+         */
+        int cell = -1;
+        /**
+         * Cells the game revealed and trivially flagged because of this
+         * move, including cascades and automatic deductions
+         */
+        int revealed = 0;
+        int flagged = 0;
+    };
+
+    BoardCode board;
+    QString player;
+    QDateTime started;
+    /**
+     * Whether the question mark was part of the marks cycle
+     */
+    bool questionMarks = true;
+    /**
+     * Whether the game opened the first click of the board code
+     * before the first move, as for boards loaded from a code
+     */
+    bool opened = false;
+    bool won = false;
+    QVector<Move> moves;
+
+    bool isValid() const { return board.isValid(); }
+
+    QString toText() const;
+    /**
+     * Parses a record written by toText(), returns an invalid record
+     * if the text is malformed
+     */
+    static GameRecord fromText(const QString& text);
+    static GameRecord load(const QString& fileName);
+    /**
+     * Writes the record to a new file in directory, which is created if needed
+     */
+    bool save(const QString& directory) const;
+
+    /**
+     * Suffix of record files
+     */
+    static QString fileSuffix();
+};
+
+#endif
@@ -0,0 +1,376 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "infinitefield.h"
+
+// own
+#include "kmines_debug.h"
+#include "settings.h"
+// Qt
+#include <QDir>
+#include <QTemporaryFile>
+
+static quint64 mix(quint64 value)
+{
+    // splitmix64 finalizer
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+static int chunkCoord(int cellCoord)
+{
+    // rounds towards negative infinity
+    return cellCoord >= 0 ? cellCoord / InfiniteField::ChunkSize
+                          : (cellCoord + 1) / InfiniteField::ChunkSize - 1;
+}
+
+InfiniteField::InfiniteField()
+    : m_peeked(MAXIMAL_CHUNKS)
+{
+}
+
+InfiniteField::~InfiniteField()
+{
+    qDeleteAll(m_chunks);
+}
+
+void InfiniteField::reset(quint32 seed, qreal mineDensity)
+{
+    m_seed = seed;
+    m_mineThreshold = static_cast<quint32>(qBound(0.0, mineDensity, 1.0) * 0xffffffffu);
+    clear();
+}
+
+void InfiniteField::restart()
+{
+    clear();
+}
+
+void InfiniteField::clear()
+{
+    qDeleteAll(m_chunks);
+    m_chunks.clear();
+    m_peeked.clear();
+    m_cacheIndex.clear();
+    m_cache.reset();
+    m_useCounter = 0;
+    m_flaggedCount = 0;
+    m_revealedCount = 0;
+}
+
+InfiniteField::ChunkKey InfiniteField::keyFor(int chunkX, int chunkY)
+{
+    return quint64(quint32(chunkX)) << 32 | quint32(chunkY);
+}
+
+InfiniteField::ChunkKey InfiniteField::keyForCell(const QPoint& cell)
+{
+    return keyFor(chunkCoord(cell.x()), chunkCoord(cell.y()));
+}
+
+int InfiniteField::localIndex(const QPoint& cell)
+{
+    const int x = cell.x() - chunkCoord(cell.x())*ChunkSize;
+    const int y = cell.y() - chunkCoord(cell.y())*ChunkSize;
+    return y*ChunkSize + x;
+}
+
+bool InfiniteField::generatedMine(int x, int y) const
+{
+    // the player starts at the origin, let it open an empty area
+    if(qAbs(x) <= 1 && qAbs(y) <= 1)
+        return false;
+
+    const quint64 chunkSeed = mix(quint64(m_seed) << 32 ^ keyFor(chunkCoord(x), chunkCoord(y)));
+    const quint64 value = mix(chunkSeed ^ quint64(localIndex(QPoint(x, y))));
+    return quint32(value) < m_mineThreshold;
+}
+
+void InfiniteField::generateChunk(ChunkKey key, Chunk* chunk) const
+{
+    const int originX = qint32(key >> 32) * ChunkSize;
+    const int originY = qint32(key & 0xffffffff) * ChunkSize;
+
+    // mines of the chunk with a one cell frame taken from its neighbours
+    enum { FramedSize = ChunkSize + 2 };
+    bool mines[FramedSize*FramedSize];
+    for(int y=0; y<FramedSize; ++y)
+        for(int x=0; x<FramedSize; ++x)
+            mines[y*FramedSize + x] = generatedMine(originX + x - 1, originY + y - 1);
+
+    for(int y=0; y<ChunkSize; ++y)
+        for(int x=0; x<ChunkSize; ++x)
+        {
+            quint8& value = chunk->cells[y*ChunkSize + x];
+            if(mines[(y+1)*FramedSize + x+1])
+            {
+                value = MineBit;
+                continue;
+            }
+            int digit = 0;
+            for(int dy=0; dy<3; ++dy)
+                for(int dx=0; dx<3; ++dx)
+                    digit += mines[(y+dy)*FramedSize + x+dx];
+            value = digit;
+        }
+}
+
+bool InfiniteField::storeChunk(ChunkKey key, const Chunk* chunk)
+{
+    if(!m_cache)
+    {
+        m_cache.reset(new QTemporaryFile(QDir::tempPath() + QStringLiteral("/kmines-endless-XXXXXX")));
+        if(!m_cache->open())
+            qCWarning(KMINES_LOG) << "Unable to create chunk cache:" << m_cache->errorString();
+    }
+    if(!m_cache->isOpen())
+        return false;
+
+    // only marks are stored, two bits per cell
+    QByteArray marks(RecordSize, '\0');
+    for(int i=0; i<ChunkSize*ChunkSize; ++i)
+        marks[i/4] = marks.at(i/4) | char(markOf(chunk->cells[i]) << (i%4)*2);
+
+    // records have a fixed size, so a chunk evicted again overwrites its own
+    // and the file only grows with the number of chunks ever changed
+    const qint64 offset = m_cacheIndex.value(key, m_cache->size());
+    if(!m_cache->seek(offset) || m_cache->write(marks) != RecordSize)
+        return false;
+    m_cacheIndex.insert(key, offset);
+    return true;
+}
+
+void InfiniteField::loadChunk(ChunkKey key, Chunk* chunk) const
+{
+    generateChunk(key, chunk);
+
+    const auto it = m_cacheIndex.constFind(key);
+    if(it == m_cacheIndex.constEnd())
+        return;
+
+    m_cache->seek(it.value());
+    const QByteArray marks = m_cache->read(RecordSize);
+    if(marks.size() != RecordSize)
+    {
+        qCWarning(KMINES_LOG) << "Corrupted chunk cache record";
+        return;
+    }
+    for(int i=0; i<ChunkSize*ChunkSize; ++i)
+        setMark(chunk->cells[i], static_cast<Mark>(uchar(marks.at(i/4)) >> (i%4)*2 & 3));
+    chunk->dirty = true;
+}
+
+InfiniteField::Chunk* InfiniteField::chunk(ChunkKey key)
+{
+    Chunk*& chunk = m_chunks[key];
+    if(!chunk)
+    {
+        chunk = new Chunk;
+        loadChunk(key, chunk);
+        m_peeked.remove(key);
+    }
+    chunk->lastUse = ++m_useCounter;
+    return chunk;
+}
+
+quint8& InfiniteField::cellRef(const QPoint& cell)
+{
+    return chunk(keyForCell(cell))->cells[localIndex(cell)];
+}
+
+KMinesState::CellState InfiniteField::stateOf(quint8 value)
+{
+    switch(markOf(value))
+    {
+        case Revealed:
+            return KMinesState::Revealed;
+        case Flagged:
+            return KMinesState::Flagged;
+        case Questioned:
+            return KMinesState::Questioned;
+        case Unmarked:
+            break;
+    }
+    return KMinesState::Released;
+}
+
+KMinesState::CellState InfiniteField::state(const QPoint& cell)
+{
+    return stateOf(cellRef(cell));
+}
+
+InfiniteField::CellInfo InfiniteField::peek(const QPoint& cell) const
+{
+    const ChunkKey key = keyForCell(cell);
+    const Chunk* found = m_chunks.value(key);
+    if(!found)
+        found = m_peeked.object(key);
+    if(!found)
+    {
+        Chunk* peeked = new Chunk;
+        loadChunk(key, peeked);
+        m_peeked.insert(key, peeked);
+        found = peeked;
+    }
+    const quint8 value = found->cells[localIndex(cell)];
+    return CellInfo{stateOf(value), bool(value & MineBit), value & DigitMask, bool(value & ExplodedBit)};
+}
+
+bool InfiniteField::hasMine(const QPoint& cell)
+{
+    return cellRef(cell) & MineBit;
+}
+
+int InfiniteField::digit(const QPoint& cell)
+{
+    return cellRef(cell) & DigitMask;
+}
+
+bool InfiniteField::isExploded(const QPoint& cell)
+{
+    return cellRef(cell) & ExplodedBit;
+}
+
+bool InfiniteField::reveal(const QPoint& cell)
+{
+    const ChunkKey startKey = keyForCell(cell);
+    Chunk* startChunk = chunk(startKey);
+    quint8& value = startChunk->cells[localIndex(cell)];
+    if(markOf(value) != Unmarked)
+        return true;
+
+    startChunk->dirty = true;
+    if(value & MineBit)
+    {
+        setMark(value, Revealed);
+        value |= ExplodedBit;
+        return false;
+    }
+
+    // flood fill works on one chunk at a time with plain array access,
+    // cells across the border are queued for their own chunk
+    QHash<ChunkKey, QVector<int>> pending;
+    pending[startKey].append(localIndex(cell));
+    while(!pending.isEmpty())
+    {
+        const auto it = pending.begin();
+        const ChunkKey key = it.key();
+        QVector<int> queue = it.value();
+        pending.erase(it);
+
+        Chunk* current = chunk(key);
+        current->dirty = true;
+        const int originX = qint32(key >> 32) * ChunkSize;
+        const int originY = qint32(key & 0xffffffff) * ChunkSize;
+
+        while(!queue.isEmpty())
+        {
+            const int idx = queue.takeLast();
+            quint8& cellValue = current->cells[idx];
+            if(markOf(cellValue) != Unmarked)
+                continue;
+            setMark(cellValue, Revealed);
+            m_revealedCount++;
+            if((cellValue & DigitMask) != 0)
+                continue;
+
+            const int x = idx % ChunkSize;
+            const int y = idx / ChunkSize;
+            for(int dy=-1; dy<=1; ++dy)
+                for(int dx=-1; dx<=1; ++dx)
+                {
+                    const int nx = x + dx;
+                    const int ny = y + dy;
+                    if(nx >= 0 && nx < ChunkSize && ny >= 0 && ny < ChunkSize)
+                        queue.append(ny*ChunkSize + nx);
+                    else
+                    {
+                        const QPoint neighbour(originX + nx, originY + ny);
+                        pending[keyForCell(neighbour)].append(localIndex(neighbour));
+                    }
+                }
+        }
+    }
+    return true;
+}
+
+bool InfiniteField::revealNeighbours(const QPoint& cell)
+{
+    const quint8 value = cellRef(cell);
+    const int cellDigit = value & DigitMask;
+    if(markOf(value) != Revealed || cellDigit == 0)
+        return true;
+
+    int flags = 0;
+    for(int dy=-1; dy<=1; ++dy)
+        for(int dx=-1; dx<=1; ++dx)
+            if(markOf(cellRef(cell + QPoint(dx, dy))) == Flagged)
+                flags++;
+    if(flags != cellDigit)
+        return true;
+
+    bool safe = true;
+    for(int dy=-1; dy<=1; ++dy)
+        for(int dx=-1; dx<=1; ++dx)
+            safe = reveal(cell + QPoint(dx, dy)) && safe;
+    return safe;
+}
+
+void InfiniteField::mark(const QPoint& cell)
+{
+    Chunk* current = chunk(keyForCell(cell));
+    quint8& value = current->cells[localIndex(cell)];
+    switch(markOf(value))
+    {
+        case Unmarked:
+            setMark(value, Flagged);
+            m_flaggedCount++;
+            break;
+        case Flagged:
+            setMark(value, Settings::useQuestionMarks() ? Questioned : Unmarked);
+            m_flaggedCount--;
+            break;
+        case Questioned:
+            setMark(value, Unmarked);
+            break;
+        case Revealed:
+            return;
+    }
+    current->dirty = true;
+}
+
+void InfiniteField::setVisibleArea(const QRect& cells)
+{
+    // one chunk of margin, so that small scrolls don't evict anything
+    m_visibleChunks = QRect(QPoint(chunkCoord(cells.left()) - 1, chunkCoord(cells.top()) - 1),
+                            QPoint(chunkCoord(cells.right()) + 1, chunkCoord(cells.bottom()) + 1));
+}
+
+void InfiniteField::trim()
+{
+    while(m_chunks.size() > MAXIMAL_CHUNKS)
+    {
+        auto victim = m_chunks.end();
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        {
+            const QPoint chunkPos(qint32(it.key() >> 32), qint32(it.key() & 0xffffffff));
+            if(m_visibleChunks.contains(chunkPos))
+                continue;
+            if(victim == m_chunks.end() || it.value()->lastUse < victim.value()->lastUse)
+                victim = it;
+        }
+        if(victim == m_chunks.end())
+            return;
+
+        // without a cache changed chunks can't be dropped
+        if(victim.value()->dirty && !storeChunk(victim.key(), victim.value()))
+            return;
+        delete victim.value();
+        m_chunks.erase(victim);
+    }
+}
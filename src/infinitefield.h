@@ -0,0 +1,172 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef INFINITEFIELD_H
+#define INFINITEFIELD_H
+
+// own
+#include "commondefs.h"
+// Qt
+#include <QCache>
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QScopedPointer>
+#include <QVector>
+
+class QTemporaryFile;
+
+/**
+ * Model of an endless mine field.
+ *
+ * The field is split in chunks of ChunkSize x ChunkSize cells which are
+ * created when first touched. Mines of a chunk are derived from a seed
+ * computed from the world seed and chunk coordinates, so a chunk can be
+ * thrown away and recreated at any time. Chunks the player has changed are
+ * written to an on-disk cache when they get evicted, only their marks are
+ * stored since everything else is regenerated from the seed. Every chunk
+ * has one fixed size record there, rewritten on each eviction.
+ *
+ * At most MAXIMAL_CHUNKS chunks outside of the visible area are kept
+ * in memory, however far the player explores.
+ */
+class InfiniteField
+{
+public:
+    enum { ChunkSize = 32 };
+    /**
+     * Number of chunks kept in memory, the visible ones are never evicted
+     */
+    static const int MAXIMAL_CHUNKS = 64;
+
+    InfiniteField();
+    ~InfiniteField();
+    /**
+     * Starts a new field, forgetting all chunks.
+     * Cells around the origin never hold mines.
+     *
+     * @param mineDensity probability of a cell to hold a mine
+     */
+    void reset(quint32 seed, qreal mineDensity);
+    /**
+     * Forgets player marks, the field stays the same
+     */
+    void restart();
+
+    KMinesState::CellState state(const QPoint& cell);
+    bool hasMine(const QPoint& cell);
+    int digit(const QPoint& cell);
+    bool isExploded(const QPoint& cell);
+
+    struct CellInfo
+    {
+        KMinesState::CellState state;
+        bool hasMine;
+        int digit;
+        bool exploded;
+    };
+    /**
+     * @return cell as shown, chunks which aren't loaded are looked at
+     * without loading them, so that painting never grows the field
+     */
+    CellInfo peek(const QPoint& cell) const;
+
+    /**
+     * Reveals cell and, if it is empty, the whole empty area around it
+     *
+     * @return false if a mine was revealed
+     */
+    bool reveal(const QPoint& cell);
+    /**
+     * Reveals unmarked neighbours of a revealed cell if all its mines are flagged
+     *
+     * @return false if a mine was revealed
+     */
+    bool revealNeighbours(const QPoint& cell);
+    /**
+     * Cycles cell through released, flagged and (if enabled) questioned states
+     */
+    void mark(const QPoint& cell);
+
+    /**
+     * Sets area of cells currently shown, chunks in it are never evicted
+     */
+    void setVisibleArea(const QRect& cells);
+    /**
+     * Evicts least recently used chunks outside of the visible area
+     * until at most MAXIMAL_CHUNKS chunks are loaded
+     */
+    void trim();
+
+    int loadedChunks() const { return m_chunks.size(); }
+    int flaggedCount() const { return m_flaggedCount; }
+    qint64 revealedCount() const { return m_revealedCount; }
+private:
+    typedef quint64 ChunkKey;
+    /**
+     * Cell byte layout: digit in bits 0-3, mine in bit 4,
+     * mark in bits 5-6, exploded in bit 7
+     */
+    enum { DigitMask = 0x0f, MineBit = 0x10, MarkShift = 5, MarkMask = 0x60, ExplodedBit = 0x80 };
+    enum Mark { Unmarked = 0, Revealed = 1, Flagged = 2, Questioned = 3 };
+    /**
+     * Bytes of a chunk record in the cache, two bits of marks per cell
+     */
+    enum { RecordSize = ChunkSize*ChunkSize/4 };
+    struct Chunk
+    {
+        quint8 cells[ChunkSize*ChunkSize];
+        quint64 lastUse = 0;
+        /**
+         * True if the player changed any cell, such chunks are cached on eviction
+         */
+        bool dirty = false;
+    };
+
+    static ChunkKey keyFor(int chunkX, int chunkY);
+    static ChunkKey keyForCell(const QPoint& cell);
+    static int localIndex(const QPoint& cell);
+    /**
+     * @return mine flag of a cell, computed from the seed only
+     */
+    bool generatedMine(int x, int y) const;
+    /**
+     * @return chunk with given key, generating or loading it if needed
+     */
+    Chunk* chunk(ChunkKey key);
+    quint8& cellRef(const QPoint& cell);
+    static Mark markOf(quint8 value) { return static_cast<Mark>((value & MarkMask) >> MarkShift); }
+    static KMinesState::CellState stateOf(quint8 value);
+    static void setMark(quint8& value, Mark mark) { value = (value & ~MarkMask) | (mark << MarkShift); }
+
+    void generateChunk(ChunkKey key, Chunk* chunk) const;
+    /**
+     * Writes marks of chunk to its record in the cache, returns false on failure
+     */
+    bool storeChunk(ChunkKey key, const Chunk* chunk);
+    void loadChunk(ChunkKey key, Chunk* chunk) const;
+    void clear();
+
+    quint32 m_seed = 0;
+    quint32 m_mineThreshold = 0;
+    quint64 m_useCounter = 0;
+    int m_flaggedCount = 0;
+    qint64 m_revealedCount = 0;
+    QRect m_visibleChunks;
+    QHash<ChunkKey, Chunk*> m_chunks;
+    /**
+     * Chunks looked at by peek() but not loaded, dropped once loaded
+     */
+    mutable QCache<ChunkKey, Chunk> m_peeked;
+
+    /**
+     * Evicted dirty chunks: offset of their record in m_cache
+     */
+    QHash<ChunkKey, qint64> m_cacheIndex;
+    QScopedPointer<QTemporaryFile> m_cache;
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "infinitefielditem.h"
+
+// own
+#include "cellitem.h"
+#include "perfcounters.h"
+#include "settings.h"
+#include "spriteatlas.h"
+// Qt
+#include <QApplication>
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsSceneWheelEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+// probability of a cell to hold a mine, a bit below "Hard"
+static const qreal MINE_DENSITY = 0.18;
+// number of rows shown, determines cell size
+static const int VISIBLE_ROWS = 16;
+static const int MINIMAL_CELL_SIZE = 16;
+// cells scrolled per wheel step
+static const int WHEEL_STEP = 3;
+
+InfiniteFieldItem::InfiniteFieldItem(SpriteAtlas* atlas, PerfCounters* counters)
+    : m_atlas(atlas), m_perf(counters)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setFlag(QGraphicsItem::ItemClipsToShape);
+}
+
+void InfiniteFieldItem::startGame(quint32 seed)
+{
+    m_field.reset(seed, MINE_DENSITY);
+    restart();
+}
+
+void InfiniteFieldItem::restart()
+{
+    m_field.restart();
+    m_firstClick = true;
+    m_gameOver = false;
+    m_dragging = false;
+    m_leftPressed = false;
+    centerOnOrigin();
+    // cells around the origin are always free, give the player a start
+    m_field.reveal(QPoint(0, 0));
+    Q_EMIT flaggedMinesCountChanged(0);
+    update();
+}
+
+void InfiniteFieldItem::setViewRect(const QRectF& rect)
+{
+    prepareGeometryChange();
+    const QPointF center = m_cellSize > 0 ? m_origin + m_rect.center()/m_cellSize : QPointF();
+    m_rect = rect;
+    m_cellSize = qMax(MINIMAL_CELL_SIZE, static_cast<int>(rect.height() / VISIBLE_ROWS));
+    m_origin = center - m_rect.center()/m_cellSize;
+    updateVisibleArea();
+}
+
+void InfiniteFieldItem::centerOnOrigin()
+{
+    if(m_cellSize > 0)
+        m_origin = QPointF(0.5, 0.5) - m_rect.center()/m_cellSize;
+    updateVisibleArea();
+}
+
+QRectF InfiniteFieldItem::boundingRect() const
+{
+    return m_rect;
+}
+
+QPoint InfiniteFieldItem::cellAt(const QPointF& pos) const
+{
+    const QPointF world = m_origin + pos/m_cellSize;
+    return QPoint(qFloor(world.x()), qFloor(world.y()));
+}
+
+void InfiniteFieldItem::updateVisibleArea()
+{
+    if(m_cellSize == 0)
+        return;
+    m_field.setVisibleArea(QRect(cellAt(m_rect.topLeft()), cellAt(m_rect.bottomRight())));
+}
+
+void InfiniteFieldItem::scrollBy(const QPointF& cells)
+{
+    m_origin += cells;
+    updateVisibleArea();
+    update();
+}
+
+void InfiniteFieldItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* opt, QWidget* w)
+{
+    Q_UNUSED(w);
+    if(m_cellSize == 0)
+        return;
+
+    const QSize size(m_cellSize, m_cellSize);
+    const qreal ratio = painter->device()->devicePixelRatioF();
+    const QRectF exposed = opt->exposedRect.intersected(m_rect);
+    const QPoint first = cellAt(exposed.topLeft());
+    const QPoint last = cellAt(exposed.bottomRight());
+    for(int y=first.y(); y<=last.y(); ++y)
+        for(int x=first.x(); x<=last.x(); ++x)
+        {
+            // painting only looks, chunks are loaded by the player's actions
+            const QPoint cell(x, y);
+            const InfiniteField::CellInfo info = m_field.peek(cell);
+            KMinesState::CellState state = info.state;
+            const bool hasMine = info.hasMine;
+            if(m_gameOver)
+            {
+                // show where the mines were
+                if(state == KMinesState::Flagged && !hasMine)
+                    state = KMinesState::Error;
+                else if(state != KMinesState::Flagged && hasMine)
+                    state = KMinesState::Revealed;
+            }
+            const QStringList keys = CellItem::spriteKeysFor(state, info.digit, hasMine, info.exploded);
+            const QPointF topLeft = (QPointF(cell) - m_origin) * m_cellSize;
+            for(const QString& key : keys)
+                painter->drawPixmap(topLeft, m_atlas->spritePixmap(key, size, ratio));
+        }
+}
+
+void InfiniteFieldItem::onRevealed(bool safe)
+{
+    // a large opening may have loaded many chunks
+    m_field.trim();
+    update();
+    if(safe)
+        return;
+    m_gameOver = true;
+    Q_EMIT gameOver(false);
+}
+
+void InfiniteFieldItem::mousePressEvent(QGraphicsSceneMouseEvent* ev)
+{
+    if(m_gameOver)
+        return;
+    m_perf->beginAction();
+
+    if(ev->button() == Qt::LeftButton)
+    {
+        m_leftPressed = true;
+        m_dragging = false;
+        m_pressPos = ev->pos();
+        m_lastDragPos = ev->pos();
+    }
+}
+
+void InfiniteFieldItem::mouseMoveEvent(QGraphicsSceneMouseEvent* ev)
+{
+    if(!m_leftPressed)
+        return;
+
+    if(!m_dragging && (ev->pos() - m_pressPos).manhattanLength() >= QApplication::startDragDistance())
+        m_dragging = true;
+    if(m_dragging)
+    {
+        scrollBy((m_lastDragPos - ev->pos()) / m_cellSize);
+        m_lastDragPos = ev->pos();
+    }
+}
+
+void InfiniteFieldItem::mouseReleaseEvent(QGraphicsSceneMouseEvent* ev)
+{
+    if(m_gameOver)
+        return;
+    m_perf->beginAction();
+
+    const QPoint cell = cellAt(ev->pos());
+    if(ev->button() == Qt::LeftButton)
+    {
+        m_leftPressed = false;
+        if(m_dragging)
+        {
+            // chunks which went out of view may be dropped now
+            m_dragging = false;
+            m_field.trim();
+            return;
+        }
+
+        if(m_firstClick)
+        {
+            m_firstClick = false;
+            Q_EMIT firstClickDone();
+        }
+        const PerfCounters::Timer timer(&m_perf->revealTime);
+        if(m_field.state(cell) == KMinesState::Revealed && Settings::exploreWithLeftClickOnNumberCells())
+            onRevealed(m_field.revealNeighbours(cell));
+        else
+            onRevealed(m_field.reveal(cell));
+    }
+    else if(ev->button() == Qt::MiddleButton)
+    {
+        const PerfCounters::Timer timer(&m_perf->revealTime);
+        onRevealed(m_field.revealNeighbours(cell));
+    }
+    else if(ev->button() == Qt::RightButton)
+    {
+        m_field.mark(cell);
+        Q_EMIT flaggedMinesCountChanged(m_field.flaggedCount());
+        update();
+    }
+}
+
+void InfiniteFieldItem::wheelEvent(QGraphicsSceneWheelEvent* ev)
+{
+    // one notch is 120 units
+    const qreal steps = -ev->delta() / 120.0 * WHEEL_STEP;
+    if(ev->orientation() == Qt::Horizontal || (ev->modifiers() & Qt::ShiftModifier))
+        scrollBy(QPointF(steps, 0));
+    else
+        scrollBy(QPointF(0, steps));
+    m_field.trim();
+}
@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef INFINITEFIELDITEM_H
+#define INFINITEFIELDITEM_H
+
+// own
+#include "infinitefield.h"
+// Qt
+#include <QGraphicsObject>
+
+class SpriteAtlas;
+struct PerfCounters;
+
+/**
+ * Graphics item showing a window on an endless mine field.
+ *
+ * Unlike MineFieldItem it doesn't create an item per cell, visible
+ * cells are painted straight from the sprite atlas. The field is
+ * scrolled by dragging it with the left mouse button or with the wheel.
+ */
+class InfiniteFieldItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    InfiniteFieldItem(SpriteAtlas* atlas, PerfCounters* counters);
+    /**
+     * Starts a new field generated from seed, centered on the origin
+     */
+    void startGame(quint32 seed);
+    /**
+     * Starts the same field again from scratch
+     */
+    void restart();
+    /**
+     * Sets the area of the scene this item covers
+     */
+    void setViewRect(const QRectF& rect);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* opt, QWidget* w) override;
+Q_SIGNALS:
+    void flaggedMinesCountChanged(int);
+    void firstClickDone();
+    /**
+     * Emitted when a mine is revealed, an endless game can't be won
+     */
+    void gameOver(bool won);
+private:
+    void mousePressEvent(QGraphicsSceneMouseEvent* ev) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent* ev) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent* ev) override;
+    void wheelEvent(QGraphicsSceneWheelEvent* ev) override;
+
+    /**
+     * @return world coordinates of cell at given item position
+     */
+    QPoint cellAt(const QPointF& pos) const;
+    /**
+     * Moves the shown area by given number of cells
+     */
+    void scrollBy(const QPointF& cells);
+    /**
+     * Centers the shown area on the origin
+     */
+    void centerOnOrigin();
+    void updateVisibleArea();
+    /**
+     * Shows the result of revealing cells, ends the game on explosion
+     */
+    void onRevealed(bool safe);
+
+    InfiniteField m_field;
+    SpriteAtlas* m_atlas;
+    PerfCounters* m_perf;
+    QRectF m_rect;
+    int m_cellSize = 0;
+    /**
+     * World coordinates, in cells, of the top left corner of this item
+     */
+    QPointF m_origin;
+
+    QPointF m_pressPos;
+    QPointF m_lastDragPos;
+    bool m_dragging = false;
+    bool m_leftPressed = false;
+    bool m_firstClick = true;
+    bool m_gameOver = false;
+};
+
+#endif
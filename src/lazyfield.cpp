@@ -0,0 +1,260 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "lazyfield.h"
+
+// own
+#include "fieldgenerator.h"
+// Std
+#include <utility>
+
+void LazyField::reset(const BoardTopology& topology, const QVector<qint8>& field, quint32 seed)
+{
+    m_topology = topology;
+    m_field = field;
+    m_revealed.fill(false, field.size());
+    m_revealedNeighbours.fill(0, field.size());
+    m_random.seed(seed);
+    m_localIndex.fill(-1, field.size());
+    m_checkIndex.fill(-1, field.size());
+}
+
+void LazyField::setRevealed(int idx)
+{
+    if(m_revealed.testBit(idx))
+        return;
+    m_revealed.setBit(idx);
+    m_topology.forNeighbours(idx, [this](int other) { m_revealedNeighbours[other]++; });
+}
+
+bool LazyField::reveal(int idx, const GuessCheck& guessForced, QVector<int>* changed)
+{
+    changed->clear();
+    if(m_field.at(idx) != FieldGenerator::Mine)
+        return true;
+
+    // mines far from the frontier only matter by their number,
+    // the whole frontier is searched only if that number is in the way
+    bool found = findLayout(idx, false);
+    if(!found && m_countMismatch)
+    {
+        clearArea();
+        found = findLayout(idx, true);
+    }
+    if(found && guessForced())
+        applyLayout(changed);
+    clearArea();
+    return !changed->isEmpty();
+}
+
+bool LazyField::findLayout(int idx, bool wholeFrontier)
+{
+    auto addCell = [this](int cell) {
+        if(m_localIndex.at(cell) != -1)
+            return;
+        m_localIndex[cell] = m_area.size();
+        m_area.append(cell);
+    };
+    addCell(idx);
+    if(wholeFrontier)
+    {
+        for(int cell=0; cell<m_field.size(); ++cell)
+            if(!m_revealed.testBit(cell) && m_revealedNeighbours.at(cell) > 0)
+                addCell(cell);
+    }
+
+    // area grows with the covered neighbours of all digits around it
+    for(int head=0; head<m_area.size(); ++head)
+    {
+        m_topology.forNeighbours(m_area.at(head), [&](int digitIdx) {
+            if(!m_revealed.testBit(digitIdx) || m_checkIndex.at(digitIdx) != -1)
+                return;
+            m_checkIndex[digitIdx] = m_checks.size();
+            m_checks.append(digitIdx);
+            m_topology.forNeighbours(digitIdx, [&](int cell) {
+                if(!m_revealed.testBit(cell))
+                    addCell(cell);
+            });
+        });
+    }
+
+    const int size = m_area.size();
+    m_cellChecks.resize(size*BoardTopology::MAXIMAL_NEIGHBOURS);
+    m_cellCheckCount.fill(0, size);
+    m_left.resize(m_checks.size());
+    m_unassigned.fill(0, m_checks.size());
+    for(int check=0; check<m_checks.size(); ++check)
+    {
+        const int digitIdx = m_checks.at(check);
+        m_left[check] = m_field.at(digitIdx);
+        m_topology.forNeighbours(digitIdx, [&](int cell) {
+            if(m_revealed.testBit(cell))
+                return;
+            const int local = m_localIndex.at(cell);
+            m_cellChecks[local*BoardTopology::MAXIMAL_NEIGHBOURS + m_cellCheckCount[local]++] = check;
+            m_unassigned[check]++;
+        });
+    }
+
+    // mines of the area may trade places with unconstrained cells
+    m_oldMines = 0;
+    for(int cell : std::as_const(m_area))
+        if(m_field.at(cell) == FieldGenerator::Mine)
+            m_oldMines++;
+    m_poolMines = 0;
+    m_poolFree = 0;
+    for(int cell=0; cell<m_field.size(); ++cell)
+    {
+        if(m_revealed.testBit(cell) || m_revealedNeighbours.at(cell) > 0
+           || m_localIndex.at(cell) != -1 || !m_topology.isActive(cell))
+            continue;
+        if(m_field.at(cell) == FieldGenerator::Mine)
+            m_poolMines++;
+        else
+            m_poolFree++;
+    }
+
+    m_assigned.fill(0, size);
+    m_fixedIdx = idx;
+    m_steps = 0;
+    m_countMismatch = false;
+    return search(0, 0);
+}
+
+bool LazyField::search(int depth, int mines)
+{
+    if(++m_steps > MAXIMAL_SEARCH_STEPS)
+        return false;
+
+    if(depth == m_area.size())
+    {
+        // the other mines have to fit in the unconstrained cells
+        const int delta = mines - m_oldMines;
+        if(delta > m_poolMines || -delta > m_poolFree)
+        {
+            m_countMismatch = true;
+            return false;
+        }
+        return true;
+    }
+
+    // current layout first, so that few mines move
+    const int cell = m_area.at(depth);
+    const char current = m_field.at(cell) == FieldGenerator::Mine ? 1 : 0;
+    const int* checks = m_cellChecks.constData() + depth*BoardTopology::MAXIMAL_NEIGHBOURS;
+    const int checkCount = m_cellCheckCount.at(depth);
+    for(int option=0; option<2; ++option)
+    {
+        const char value = option == 0 ? current : 1 - current;
+        if(value == 1 && cell == m_fixedIdx)
+            continue;
+
+        bool fits = true;
+        for(int i=0; i<checkCount; ++i)
+        {
+            const int left = m_left.at(checks[i]) - value;
+            if(left < 0 || left > m_unassigned.at(checks[i]) - 1)
+            {
+                fits = false;
+                break;
+            }
+        }
+        if(!fits)
+            continue;
+
+        for(int i=0; i<checkCount; ++i)
+        {
+            m_left[checks[i]] -= value;
+            m_unassigned[checks[i]]--;
+        }
+        m_assigned[depth] = value;
+        const bool found = search(depth+1, mines + value);
+        for(int i=0; i<checkCount; ++i)
+        {
+            m_left[checks[i]] += value;
+            m_unassigned[checks[i]]++;
+        }
+        if(found)
+            return true;
+        if(m_steps > MAXIMAL_SEARCH_STEPS)
+            return false;
+    }
+    return false;
+}
+
+void LazyField::applyLayout(QVector<int>* changed)
+{
+    int delta = 0;
+    for(int i=0; i<m_area.size(); ++i)
+    {
+        const int cell = m_area.at(i);
+        const bool mine = m_assigned.at(i);
+        if(mine == (m_field.at(cell) == FieldGenerator::Mine))
+            continue;
+        m_field[cell] = mine ? FieldGenerator::Mine : 0;
+        changed->append(cell);
+        delta += mine ? 1 : -1;
+    }
+
+    // mines the area gained or lost go to or come from random unconstrained cells
+    if(delta != 0)
+    {
+        QVector<int> pool;
+        const bool takeMines = delta > 0;
+        for(int cell=0; cell<m_field.size(); ++cell)
+        {
+            if(m_revealed.testBit(cell) || m_revealedNeighbours.at(cell) > 0
+               || m_localIndex.at(cell) != -1 || !m_topology.isActive(cell))
+                continue;
+            if((m_field.at(cell) == FieldGenerator::Mine) == takeMines)
+                pool.append(cell);
+        }
+        for(int i=0; i<qAbs(delta); ++i)
+        {
+            const int pick = i + m_random.bounded(pool.size() - i);
+            std::swap(pool[i], pool[pick]);
+            m_field[pool.at(i)] = takeMines ? 0 : FieldGenerator::Mine;
+            changed->append(pool.at(i));
+        }
+    }
+
+    // digits around moved mines, revealed ones stay as they are
+    const int moved = changed->size();
+    for(int i=0; i<moved; ++i)
+    {
+        const int cell = changed->at(i);
+        if(m_field.at(cell) != FieldGenerator::Mine)
+            updateDigit(cell);
+        m_topology.forNeighbours(cell, [&](int other) {
+            if(m_field.at(other) == FieldGenerator::Mine || m_revealed.testBit(other))
+                return;
+            const qint8 old = m_field.at(other);
+            updateDigit(other);
+            if(m_field.at(other) != old && !changed->contains(other))
+                changed->append(other);
+        });
+    }
+}
+
+void LazyField::updateDigit(int idx)
+{
+    qint8 digit = 0;
+    m_topology.forNeighbours(idx, [&](int other) {
+        if(m_field.at(other) == FieldGenerator::Mine)
+            digit++;
+    });
+    m_field[idx] = digit;
+}
+
+void LazyField::clearArea()
+{
+    for(int cell : std::as_const(m_area))
+        m_localIndex[cell] = -1;
+    for(int digitIdx : std::as_const(m_checks))
+        m_checkIndex[digitIdx] = -1;
+    m_area.clear();
+    m_checks.clear();
+}
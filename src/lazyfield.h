@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef LAZYFIELD_H
+#define LAZYFIELD_H
+
+// own
+#include "boardtopology.h"
+// Qt
+#include <QBitArray>
+#include <QRandomGenerator>
+#include <QVector>
+// Std
+#include <functional>
+
+/**
+ * Field whose mines stay undecided until the player reveals a cell.
+ *
+ * It always holds one layout consistent with every digit revealed so far
+ * and with the number of mines. Revealing a cell which is free in that
+ * layout costs nothing. When the player opens a mine of the layout
+ * although the digits allow the cell to be free, the connected part of
+ * the frontier around it is searched for another layout, moving as few
+ * mines as possible. The new layout is only taken when the guess was
+ * forced, so the player never loses to a coin flip, while careless
+ * guesses still lose.
+ *
+ * Revealed cells and the number of revealed neighbours of each cell
+ * are kept across moves, so no reveal rebuilds the whole frontier.
+ */
+class LazyField
+{
+public:
+    typedef std::function<bool()> GuessCheck;
+
+    /**
+     * Constructs an invalid field, i.e. mines are fixed
+     */
+    LazyField() = default;
+    /**
+     * Starts over from field as current layout, all cells covered
+     *
+     * @param field row-major array of digits or FieldGenerator::Mine
+     * @param seed seed of the random generator moving mines away from the frontier
+     */
+    void reset(const BoardTopology& topology, const QVector<qint8>& field, quint32 seed);
+    bool isValid() const { return !m_field.isEmpty(); }
+    /**
+     * Decides whether the cell the player reveals holds a mine.
+     *
+     * @param guessForced only called when the cell may or may not hold
+     * a mine, returns whether the player had no safe cell to open
+     * @param changed filled with cells whose content changed, their digits
+     * and mines are then found in field()
+     * @return true if the cell is free of mines
+     */
+    bool reveal(int idx, const GuessCheck& guessForced, QVector<int>* changed);
+    /**
+     * Must be called for every cell revealed without mine, whatever revealed it
+     */
+    void setRevealed(int idx);
+    /**
+     * @return current layout, row-major digits or FieldGenerator::Mine
+     */
+    const QVector<qint8>& field() const { return m_field; }
+
+    /**
+     * Search steps spent on finding another layout, the cell
+     * stays mined beyond that
+     */
+    static const int MAXIMAL_SEARCH_STEPS = 1 << 16;
+private:
+    /**
+     * Searches a layout where idx is free, taking the frontier area around
+     * idx or the whole frontier. The result is left in m_area and m_assigned
+     */
+    bool findLayout(int idx, bool wholeFrontier);
+    bool search(int depth, int mines);
+    void clearArea();
+    /**
+     * Takes the layout found by findLayout()
+     */
+    void applyLayout(QVector<int>* changed);
+    void updateDigit(int idx);
+
+    BoardTopology m_topology;
+    QVector<qint8> m_field;
+    QBitArray m_revealed;
+    /**
+     * Number of revealed neighbours of each cell, covered cells
+     * with none are free of any constraint
+     */
+    QVector<qint8> m_revealedNeighbours;
+    QRandomGenerator m_random;
+
+    // state of the running search, indices are -1 outside of it
+    QVector<int> m_localIndex;
+    QVector<int> m_checkIndex;
+    QVector<int> m_area;
+    QVector<int> m_checks;
+    /**
+     * Local checks of each area cell, MAXIMAL_NEIGHBOURS per cell
+     */
+    QVector<int> m_cellChecks;
+    QVector<int> m_cellCheckCount;
+    QVector<int> m_left;
+    QVector<int> m_unassigned;
+    QVector<char> m_assigned;
+    int m_fixedIdx = -1;
+    int m_oldMines = 0;
+    int m_poolMines = 0;
+    int m_poolFree = 0;
+    int m_steps = 0;
+    bool m_countMismatch = false;
+};
+
+#endif
@@ -7,6 +7,7 @@
 // own
 #include "kmines_version.h"
 #include "mainwindow.h"
+#include "startupprofiler.h"
 // KF
 #include <KAboutData>
 #include <KCrash>
@@ -21,9 +22,11 @@
 
 int main(int argc, char **argv)
 {
+    StartupProfiler::start();
     // Fixes blurry icons with fractional scaling
     QGuiApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     QApplication app(argc, argv);
+    StartupProfiler::mark(QStringLiteral("application created"));
 
     Kdelibs4ConfigMigrator migrate(QStringLiteral("kmines"));
     migrate.setConfigFiles(QStringList() << QStringLiteral("kminesrc"));
@@ -62,15 +65,21 @@ int main(int argc, char **argv)
     KCrash::initialize();
     QCommandLineParser parser;
     aboutData.setupCommandLine(&parser);
+    QCommandLineOption profileStartupOption(QStringLiteral("profile-startup"),
+                                            i18n("Print the duration of each startup phase."));
+    parser.addOption(profileStartupOption);
     parser.process(app);
     aboutData.processCommandLine(&parser);
+    StartupProfiler::setReportEnabled(parser.isSet(profileStartupOption));
     KDBusService service; 
+    StartupProfiler::mark(QStringLiteral("application set up"));
     
     if ( app.isSessionRestored() )
         kRestoreMainWindows<KMinesMainWindow>();
     else {
         KMinesMainWindow *mw = new KMinesMainWindow;
         mw->show();
+        StartupProfiler::mark(QStringLiteral("main window shown"));
     }
     
     return app.exec();
@@ -11,6 +11,7 @@
 #include "minefielditem.h"
 #include "scene.h"
 #include "settings.h"
+#include "startupprofiler.h"
 #include "kmines_debug.h"
 #include "ui_customgame.h"
 #include "ui_generalopts.h"
@@ -22,14 +23,35 @@
 #include <KScoreDialog>
 // KF
 #include <KActionCollection>
+#include <KToggleAction>
 #include <KConfigDialog>
 #include <KLocalizedString>
 // Qt
+#include <QClipboard>
+#include <QFileDialog>
+#include <QGuiApplication>
+#include <QInputDialog>
 #include <QScreen>
 #include <QStatusBar>
 #include <QDesktopWidget>
 #include <QMessageBox>
 
+static const QByteArray ENDLESS_LEVEL_KEY = QByteArrayLiteral("Endless");
+static const QByteArray STAR_LEVEL_KEY = QByteArrayLiteral("Star");
+static const QByteArray FLOWER_LEVEL_KEY = QByteArrayLiteral("Flower");
+
+/**
+ * @return outline of the shaped level with given key, invalid for other levels
+ */
+static BoardMask shapedLevel(const QByteArray& key)
+{
+    if(key == STAR_LEVEL_KEY)
+        return BoardMask::load(QStringLiteral(":/kmines/levels/star.txt"));
+    if(key == FLOWER_LEVEL_KEY)
+        return BoardMask::load(QStringLiteral(":/kmines/levels/flower.txt"));
+    return BoardMask();
+}
+
 /*
  * Classes for config dlg pages
  */
@@ -85,6 +107,7 @@ KMinesMainWindow::KMinesMainWindow()
     connect(m_scene, &KMinesScene::minesCountChanged, this, &KMinesMainWindow::onMinesCountChanged);
     connect(m_scene, &KMinesScene::gameOver, this, &KMinesMainWindow::onGameOver);
     connect(m_scene, &KMinesScene::firstClickDone, this, &KMinesMainWindow::onFirstClick);
+    connect(m_scene, &KMinesScene::metricsReady, this, &KMinesMainWindow::onMetricsReady);
 
     m_view = new KMinesView( m_scene, this );
     m_view->setCacheMode( QGraphicsView::CacheBackground );
@@ -102,13 +125,17 @@ KMinesMainWindow::KMinesMainWindow()
 
     mineLabel->setText(i18n("Mines: 0/0"));
     timeLabel->setText(i18n("Time: 00:00"));
+    metricsLabel->setText(i18n("3BV: -"));
     
     statusBar()->insertPermanentWidget( 0, mineLabel );
     statusBar()->insertPermanentWidget( 1, timeLabel );
+    statusBar()->insertPermanentWidget( 2, metricsLabel );
     setCentralWidget(m_view);
     setupActions();
+    StartupProfiler::mark(QStringLiteral("main window created"));
 
-    newGame();
+    // show the window before building the field and rendering the theme
+    connect(m_view, &KMinesView::firstFramePainted, this, &KMinesMainWindow::newGame, Qt::QueuedConnection);
 }
 
 void KMinesMainWindow::setupActions()
@@ -119,6 +146,26 @@ void KMinesMainWindow::setupActions()
     KStandardGameAction::quit(this, &KMinesMainWindow::close, actionCollection());
     KStandardAction::preferences(this, &KMinesMainWindow::configureSettings, actionCollection());
     m_actionPause = KStandardGameAction::pause(this, &KMinesMainWindow::pauseGame, actionCollection());
+    KStandardGameAction::hint(this, &KMinesMainWindow::showHint, actionCollection());
+
+    KToggleAction* perfHudAction = new KToggleAction(i18n("Show Performance Overlay"), this);
+    actionCollection()->addAction(QStringLiteral("show_perf_hud"), perfHudAction);
+    actionCollection()->setDefaultShortcut(perfHudAction, Qt::CTRL | Qt::SHIFT | Qt::Key_P);
+    connect(perfHudAction, &KToggleAction::toggled, m_scene, &KMinesScene::setPerfHudVisible);
+
+    QAction* copyCodeAction = actionCollection()->addAction(QStringLiteral("game_copy_code"));
+    copyCodeAction->setText(i18n("Copy Board Code"));
+    copyCodeAction->setIcon(QIcon::fromTheme(QStringLiteral("edit-copy")));
+    connect(copyCodeAction, &QAction::triggered, this, &KMinesMainWindow::copyBoardCode);
+
+    QAction* playCodeAction = actionCollection()->addAction(QStringLiteral("game_play_code"));
+    playCodeAction->setText(i18n("Play Board Code..."));
+    connect(playCodeAction, &QAction::triggered, this, &KMinesMainWindow::playBoardCode);
+
+    QAction* playLevelAction = actionCollection()->addAction(QStringLiteral("game_play_level"));
+    playLevelAction->setText(i18n("Play Level File..."));
+    playLevelAction->setIcon(QIcon::fromTheme(QStringLiteral("document-open")));
+    connect(playLevelAction, &QAction::triggered, this, &KMinesMainWindow::playLevelFile);
 
     Kg::difficulty()->addStandardLevelRange(
         KgDifficultyLevel::Easy, KgDifficultyLevel::Hard
@@ -126,6 +173,15 @@ void KMinesMainWindow::setupActions()
     Kg::difficulty()->addLevel(new KgDifficultyLevel(1000,
         QByteArray( "Custom" ), i18n( "Custom" )
     ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(1100,
+        STAR_LEVEL_KEY, i18n( "Star" )
+    ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(1200,
+        FLOWER_LEVEL_KEY, i18n( "Flower" )
+    ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(2000,
+        ENDLESS_LEVEL_KEY, i18n( "Endless" )
+    ));
     KgDifficultyGUI::init(this);
     connect(Kg::difficulty(), &KgDifficulty::currentLevelChanged, this, &KMinesMainWindow::newGame);
 
@@ -134,33 +190,65 @@ void KMinesMainWindow::setupActions()
 
 void KMinesMainWindow::onMinesCountChanged(int count)
 {
+    if(m_scene->isEndless())
+    {
+        mineLabel->setText(i18n("Flags: %1", count));
+        return;
+    }
     mineLabel->setText(i18n("Mines: %1/%2", count, m_scene->totalMines()));
 }
 
 void KMinesMainWindow::newGame()
 {
     qCDebug(KMINES_LOG) << "Inside game";
-    m_gameClock->restart();
-    m_gameClock->pause(); // start only with the 1st click
-
-    // some things to manage pause
-    if( m_actionPause->isChecked() )
+    prepareNewGame();
+    if(Kg::difficulty()->currentLevel()->key() == ENDLESS_LEVEL_KEY)
     {
-            m_scene->setGamePaused(false);
-            m_actionPause->setChecked(false);
+        // there is nothing to compare in highscores
+        m_scene->setComparable(false);
+        m_scene->startEndlessGame();
+        StartupProfiler::setInteractive();
+        return;
     }
-    m_actionPause->setEnabled(false);
-
-    Kg::difficulty()->setGameRunning(false);
+    // shapes are listed in the settings in the order of BoardTopology::Kind,
+    // shaped levels are always played on the square grid
+    const BoardMask mask = shapedLevel(Kg::difficulty()->currentLevel()->key());
+    const BoardTopology::Kind topology = mask.isValid() ? BoardTopology::Square
+                                                        : static_cast<BoardTopology::Kind>(Settings::topology());
+    m_scene->setTopology(topology);
+    m_scene->setMask(mask);
+    // highscores are only comparable for square boards whose mines are
+    // fixed from the start, several boards are ranked in their own table
+    m_scene->setBoardCount(Settings::boardCount());
+    if(topology != BoardTopology::Square || Settings::lazyMines())
+        m_scene->setComparable(false);
+    // custom games are played with any board
+    m_scene->setRatingBand(0, BoardRating::LevelCount - 1);
+    if(mask.isValid())
+    {
+        m_scene->startNewGame(mask.numRows(), mask.numCols(), mask.numMines());
+        StartupProfiler::setInteractive();
+        return;
+    }
+    const bool rated = Settings::ratedLevels();
     switch(Kg::difficultyLevel())
     {
         case KgDifficultyLevel::Easy:
+            // never needs a guess
+            if(rated)
+                m_scene->setRatingBand(0, BoardRating::MAXIMAL_NO_GUESS_LEVEL);
             m_scene->startNewGame(9, 9, 10);
             break;
         case KgDifficultyLevel::Medium:
+            // at most about one coin flip
+            if(rated)
+                m_scene->setRatingBand(0, BoardRating::MAXIMAL_NO_GUESS_LEVEL + 1);
             m_scene->startNewGame(16,16,40);
             break;
         case KgDifficultyLevel::Hard:
+            // needs more than single digits
+            if(rated)
+                m_scene->setRatingBand(1, BoardRating::LevelCount - 1);
             m_scene->startNewGame(16,30,99);
             break;
         case KgDifficultyLevel::Custom:
@@ -171,8 +259,92 @@ void KMinesMainWindow::newGame()
             //unsupported
             break;
     }
-    
+    StartupProfiler::setInteractive();
+}
+
+void KMinesMainWindow::playBoardCode()
+{
+    const QString text = QInputDialog::getText(this, i18n("Play Board Code"), i18n("Board code:"));
+    if(text.isEmpty())
+        return;
+
+    const BoardCode code = BoardCode::fromString(text);
+    if(!code.isValid())
+    {
+        QMessageBox::warning(this, i18n("Play Board Code"), i18n("This is not a valid board code."));
+        return;
+    }
+
+    prepareNewGame();
+    // the board may have any size, so it is not comparable with highscores
+    m_scene->setComparable(false);
+    m_scene->startNewGame(code);
+    onMinesCountChanged(0);
+}
+
+void KMinesMainWindow::playLevelFile()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, i18n("Play Level File"), QString(),
+        i18n("KMines Levels (*.txt);;Images (*.png *.xpm *.xbm *.pbm);;All Files (*)"));
+    if(fileName.isEmpty())
+        return;
+
+    const BoardMask mask = BoardMask::load(fileName);
+    if(!mask.isValid())
+    {
+        QMessageBox::warning(this, i18n("Play Level File"), i18n("This is not a valid level."));
+        return;
+    }
+
+    prepareNewGame();
+    // the level may come from anywhere, so it is not comparable with highscores
+    m_scene->setComparable(false);
+    m_scene->setMask(mask);
+    m_scene->startNewGame(mask.numRows(), mask.numCols(), mask.numMines());
+    onMinesCountChanged(0);
+}
+
+void KMinesMainWindow::copyBoardCode()
+{
+    const BoardCode code = m_scene->boardCode();
+    if(!code.isValid())
+    {
+        if(Settings::topology() != Settings::EnumTopology::Square || m_scene->mask().isValid())
+            statusBar()->showMessage(i18n("Only plain square boards have a code."), 3000);
+        else
+            statusBar()->showMessage(i18n("The board is generated with the first click."), 3000);
+        return;
+    }
+    QGuiApplication::clipboard()->setText(code.toString());
+    statusBar()->showMessage(i18n("Board code copied to clipboard."), 3000);
+}
+
+void KMinesMainWindow::showHint()
+{
+    if(m_actionPause->isChecked())
+        return;
+    if(!m_scene->showHint())
+        statusBar()->showMessage(i18n("No hint available yet."), 3000);
+}
+
+void KMinesMainWindow::prepareNewGame()
+{
+    m_gameClock->restart();
+    m_gameClock->pause(); // start only with the 1st click
+
+    // some things to manage pause
+    if( m_actionPause->isChecked() )
+    {
+            m_scene->setGamePaused(false);
+            m_actionPause->setChecked(false);
+    }
+    m_actionPause->setEnabled(false);
+    // a reset or a hint may only have disabled scoring for the previous game
+    m_scene->setComparable(true);
+
+    Kg::difficulty()->setGameRunning(false);
     timeLabel->setText(i18n("Time: 00:00"));
+    metricsLabel->setText(i18n("3BV: -"));
 }
 
 void KMinesMainWindow::onGameOver(bool won)
@@ -180,17 +352,35 @@ void KMinesMainWindow::onGameOver(bool won)
     m_gameClock->pause();
     m_actionPause->setEnabled(false);
     Kg::difficulty()->setGameRunning(false);
+
+    const BoardMetrics metrics = m_scene->metrics();
+    // clock has a resolution of one second, don't divide by zero on very fast wins
+    const qreal bbbvPerSecond = qreal(metrics.bbbv) / qMax(1, m_gameClock->seconds());
+    const qreal efficiency = qreal(metrics.bbbv) / qMax(1, m_scene->clickCount());
+    if(won)
+        metricsLabel->setText(i18n("3BV: %1  3BV/s: %2  IOE: %3", metrics.bbbv,
+                                   QString::number(bbbvPerSecond, 'f', 2),
+                                   QString::number(efficiency, 'f', 2)));
+    const BoardRating rating = m_scene->rating();
+    if(rating.isValid())
+        metricsLabel->setText(i18n("%1  Rating: %2", metricsLabel->text(), rating.level()));
+
     if(won && m_scene->canScore())
     {
         QPointer<KScoreDialog> scoreDialog = new KScoreDialog(KScoreDialog::Name | KScoreDialog::Time, this);
         scoreDialog->initFromDifficulty(Kg::difficulty());
+        setBoardsGroup(scoreDialog, m_scene->boardCount());
         scoreDialog->hideField(KScoreDialog::Score);
+        addMetricsFields(scoreDialog);
 
         KScoreDialog::FieldInfo scoreInfo;
         // score-in-seconds will be hidden
         scoreInfo[KScoreDialog::Score].setNum(m_gameClock->seconds());
         //score-as-time will be shown
         scoreInfo[KScoreDialog::Time] = m_gameClock->timeString();
+        scoreInfo[KScoreDialog::Custom1].setNum(metrics.bbbv);
+        scoreInfo[KScoreDialog::Custom2].setNum(bbbvPerSecond, 'f', 2);
+        scoreInfo[KScoreDialog::Custom3].setNum(efficiency, 'f', 2);
 
         // we keep highscores as number of seconds
         if( scoreDialog->addScore(scoreInfo, KScoreDialog::LessIsMore) != 0 )
@@ -204,7 +394,7 @@ void KMinesMainWindow::onGameOver(bool won)
             m_scene->reset();
             m_gameClock->restart();
             m_actionPause->setEnabled(true);
-            m_scene->setCanScore(!Settings::disableScoreOnReset());
+            m_scene->setCanScore(m_scene->isComparable() && !Settings::disableScoreOnReset());
         }
     }
 }
@@ -223,15 +413,39 @@ void KMinesMainWindow::onFirstClick()
     Kg::difficulty()->setGameRunning(true);
 }
 
+void KMinesMainWindow::onMetricsReady()
+{
+    metricsLabel->setText(i18n("3BV: %1", m_scene->metrics().bbbv));
+}
+
 void KMinesMainWindow::showHighscores()
 {
     QPointer<KScoreDialog> scoreDialog = new KScoreDialog(KScoreDialog::Name | KScoreDialog::Time, this);
     scoreDialog->initFromDifficulty(Kg::difficulty());
+    setBoardsGroup(scoreDialog, Settings::boardCount());
     scoreDialog->hideField(KScoreDialog::Score);
+    addMetricsFields(scoreDialog);
     scoreDialog->exec();
     delete scoreDialog;
 }
 
+void KMinesMainWindow::addMetricsFields(KScoreDialog* scoreDialog)
+{
+    scoreDialog->addField(KScoreDialog::Custom1, i18n("3BV"), QStringLiteral("3bv"));
+    scoreDialog->addField(KScoreDialog::Custom2, i18n("3BV/s"), QStringLiteral("3bvPerSecond"));
+    scoreDialog->addField(KScoreDialog::Custom3, i18n("IOE"), QStringLiteral("ioe"));
+}
+
+void KMinesMainWindow::setBoardsGroup(KScoreDialog* scoreDialog, int boardCount)
+{
+    if(boardCount <= 1)
+        return;
+    const KgDifficultyLevel* level = Kg::difficulty()->currentLevel();
+    scoreDialog->setConfigGroup(qMakePair(level->key() + "_boards" + QByteArray::number(boardCount),
+                                          i18nc("highscore table, %1 is the difficulty level",
+                                                "%1, %2 Boards", level->title(), boardCount)));
+}
+
 void KMinesMainWindow::configureSettings()
 {
     if ( KConfigDialog::showDialog( QStringLiteral(  "settings" ) ) )
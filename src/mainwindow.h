@@ -17,6 +17,7 @@ class KMinesScene;
 class KMinesView;
 class KGameClock;
 class KToggleAction;
+class KScoreDialog;
 
 class KMinesMainWindow : public KXmlGuiWindow
 {
@@ -26,15 +27,39 @@ public:
 private Q_SLOTS:
     void onMinesCountChanged(int count);
     void newGame();
+    /**
+     * Asks for a board code and starts a game on that board
+     */
+    void playBoardCode();
+    /**
+     * Asks for a level file and starts a game on its shaped board
+     */
+    void playLevelFile();
+    void copyBoardCode();
+    void showHint();
     void onGameOver(bool);
     void advanceTime(const QString&);
     void onFirstClick();
+    void onMetricsReady();
     void showHighscores();
     void configureSettings();
     void pauseGame(bool paused);
     void loadSettings();
 private:
     void setupActions();
+    /**
+     * Resets clock, pause and status bar before a new game is started
+     */
+    void prepareNewGame();
+    /**
+     * Adds board metrics columns to highscore dialog
+     */
+    void addMetricsFields(KScoreDialog* scoreDialog);
+    /**
+     * Selects highscore table of games with given number of boards
+     * of the current difficulty, the level's own one for a single board
+     */
+    void setBoardsGroup(KScoreDialog* scoreDialog, int boardCount);
     KMinesScene* m_scene = nullptr;
     KMinesView* m_view = nullptr;
     KGameClock* m_gameClock = nullptr;
@@ -42,5 +67,6 @@ private:
     
     QPointer<QLabel> mineLabel = new QLabel;
     QPointer<QLabel> timeLabel = new QLabel;
+    QPointer<QLabel> metricsLabel = new QLabel;
 };
 #endif
@@ -6,36 +6,122 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
-#include <iostream> //TODO: delete me
 #include "minefielditem.h"
 
 // own
+#include "analysisservice.h"
 #include "kmines_debug.h"
 #include "cellitem.h"
 #include "borderitem.h"
+#include "boardcorpus.h"
+#include "boardsnapshot.h"
+#include "fieldgenerator.h"
+#include "perfcounters.h"
 #include "settings.h"
+#include "solver.h"
+#include "spriteatlas.h"
+// KF
+#include <KUser>
 // Qt
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
+#include <QPainter>
 #include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QStyleOptionGraphicsItem>
+// Std
+#include <algorithm>
+#include <cmath>
+
+// minimal interval between two applied mouse moves, about one frame
+static const int MOVE_THROTTLE_INTERVAL = 16;
+// time spent showing revealed cells in one go, leaves most of a frame to input
+static const int VISUAL_SLICE_BUDGET = 4;
+// frames a wave of revealed cells takes, and interval between them
+static const int WAVE_FRAMES = 20;
+static const int WAVE_FRAME_INTERVAL = 16;
+// boards generated in search of one within the rating band, and time they may take
+static const int MAXIMAL_GENERATION_ATTEMPTS = 64;
+static const int GENERATION_BUDGET = 100;
+
+static BoardSnapshotHeader::Topology snapshotTopology(BoardTopology::Kind kind)
+{
+    switch(kind)
+    {
+        case BoardTopology::Hexagonal:
+            return BoardSnapshotHeader::Hexagonal;
+        case BoardTopology::Torus:
+            return BoardSnapshotHeader::Torus;
+        case BoardTopology::Layers:
+            return BoardSnapshotHeader::Layers;
+        default:
+            return BoardSnapshotHeader::Square;
+    }
+}
+
+MineFieldItem::MineFieldItem(SpriteAtlas* atlas, PerfCounters* counters)
+    : m_cellSize(0), m_numRows(0), m_numCols(0), m_minesCount(0), m_flaggedMinesCount(0),
+      m_leftButtonPos(-1,-1), m_midButtonPos(-1,-1), m_firstClick(true), m_gameOver(false),
+      m_emulatingMidButton(false), m_numUnrevealed(0), m_atlas(atlas), m_perf(counters),
+      m_analysis(new AnalysisService(this))
+{
+    // only exposed cells are painted
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    // one field at a time, a new game makes the running one useless
+    m_generationPool.setMaxThreadCount(1);
+
+    m_moveThrottleTimer.setSingleShot(true);
+    m_moveThrottleTimer.setInterval(MOVE_THROTTLE_INTERVAL);
+    connect(&m_visualTimer, &QTimer::timeout, this, &MineFieldItem::updateVisuals);
+    connect(&m_moveThrottleTimer, &QTimer::timeout, this, [this]() {
+        if(m_movePending)
+        {
+            applyPendingMove();
+            m_moveThrottleTimer.start();
+        }
+    });
+}
 
-MineFieldItem::MineFieldItem(KGameRenderer* renderer)
-    : m_leftButtonPos(-1,-1), m_midButtonPos(-1,-1), m_gameOver(false),
-      m_emulatingMidButton(false), m_renderer(renderer)
+MineFieldItem::~MineFieldItem()
 {
-	setFlag(QGraphicsItem::ItemHasNoContents);
+    m_generation.ref();
+    m_generationPool.waitForDone();
 }
 
 void MineFieldItem::resetMines()
 {
+    // a field still being generated is replaced by the next first click
+    if(m_generating)
+    {
+        m_generation.ref();
+        m_generating = false;
+        m_firstClick = true;
+    }
+    clearVisualUpdates();
     m_gameOver = false;
     m_numUnrevealed = m_numRows*m_numCols;
+    m_clickCount = 0;
+    m_record = GameRecord();
+
+    if(m_snapshot)
+        m_snapshot->reset(m_numRows, m_numCols, snapshotTopology(m_topology.kind()));
+    m_board.reset(m_numRows, m_numCols, m_minesCount);
 
-    for(CellItem* item : std::as_const(m_cells)) {
-        item->unreveal();
-        item->unflag();
-        item->unexplode();
+    for(CellItem& item : m_cells) {
+        item.unreveal();
+        item.unflag();
+        item.unexplode();
     }
+    // the replay starts from the mines as they are now
+    if(m_lazy.isValid())
+        m_lazy.reset(m_topology, currentField(), QRandomGenerator::global()->generate());
+    hideInactiveCells();
+    publishBoard();
+    m_hintIdx = -1;
+    update();
 
     m_flaggedMinesCount = 0;
     Q_EMIT flaggedMinesCountChanged(m_flaggedMinesCount);
@@ -44,36 +130,27 @@ void MineFieldItem::resetMines()
 
 void MineFieldItem::initField( int numRows, int numCols, int numMines )
 {
-    numMines = qMin(numMines, numRows*numCols - MINIMAL_FREE );
+    // shaped boards use the square grid, every layer gets the mines of a whole board
+    const bool shaped = m_mask.isValid() && m_mask.numRows() == numRows && m_mask.numCols() == numCols;
+    m_topology = BoardTopology(shaped ? BoardTopology::Square : m_topologyKind, numRows, numCols,
+                               shaped ? m_mask.activeCells() : QBitArray());
+    if(m_topology.kind() == BoardTopology::Layers)
+        numMines *= BoardTopology::LayerCount;
+    numRows = m_topology.numRows();
+    numCols = m_topology.numCols();
+    numMines = qBound(0, numMines, m_topology.activeCount() - MINIMAL_FREE );
 
     m_firstClick = true;
+    m_generating = false;
+    m_generation.ref();
     m_gameOver = false;
 
-    int oldSize = m_cells.size();
-    int newSize = numRows*numCols;
-    int oldBorderSize = m_borders.size();
-    int newBorderSize = (numCols+2)*2 + (numRows+2)*2-4;
-
-    // if field is being shrunk, delete elements at the end before resizing vector
-    if(oldSize > newSize)
-    {
-        for( int i=newSize; i<oldSize; ++i )
-        {
-            // is this the best way to remove an item?
-            scene()->removeItem(m_cells[i]);
-            delete m_cells[i];
-        }
-
-        // adjust border item array too
-        for( int i=newBorderSize; i<oldBorderSize; ++i)
-        {
-            scene()->removeItem(m_borders[i]);
-            delete m_borders[i];
-        }
-    }
-
-    m_cells.resize(newSize);
-    m_borders.resize(newBorderSize);
+    // let all cells be empty by default
+    // generateField() will adjust needed cells
+    // to hold digits or mines
+    m_cells.fill(CellItem(), numRows*numCols);
+    clearVisualUpdates();
+    m_visualPending.fill(false, numRows*numCols);
 
     m_numRows = numRows;
     m_numCols = numCols;
@@ -81,135 +158,391 @@ void MineFieldItem::initField( int numRows, int numCols, int numMines )
     m_numUnrevealed = m_numRows*m_numCols;
     m_midButtonPos = qMakePair(-1, -1);
     m_leftButtonPos = qMakePair(-1, -1);
-
-    for(int i=0; i<newSize; ++i)
-    {
-        // reset old, create new
-        if(i<oldSize)
-            m_cells[i]->reset();
-        else
-            m_cells[i] = new CellItem(m_renderer, this);
-        // let it be empty by default
-        // generateField() will adjust needed cells
-        // to hold digits or mines
-        m_cells[i]->setDigit(0);
-    }
-
-    for(int i=oldBorderSize; i<newBorderSize; ++i)
-            m_borders[i] = new BorderItem(m_renderer, this);
+    m_movePending = false;
+    m_metrics = BoardMetrics();
+    m_rating = BoardRating();
+    m_boardCode = BoardCode();
+    m_lazy = LazyField();
+    m_lazyMines = Settings::lazyMines();
+    m_record = GameRecord();
+    m_clickCount = 0;
+    m_hintIdx = -1;
+    m_board.reset(m_numRows, m_numCols, m_minesCount);
+    m_analysis->setTopology(m_topology);
 
     setupBorderItems();
 
     adjustItemPositions();
+    update();
     m_flaggedMinesCount = 0;
     Q_EMIT flaggedMinesCountChanged(m_flaggedMinesCount);
+
+    if(m_snapshotPublisher && Settings::publishBoardSnapshot())
+    {
+        if(!m_snapshot)
+            m_snapshot.reset(new BoardSnapshot);
+        if(!m_snapshot->reset(m_numRows, m_numCols, snapshotTopology(m_topology.kind())))
+            m_snapshot.reset();
+    }
+    else
+        m_snapshot.reset();
+    hideInactiveCells();
+}
+
+void MineFieldItem::hideInactiveCells()
+{
+    if(m_topology.isComplete())
+        return;
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        if(m_topology.isActive(idx))
+            continue;
+        m_cells[idx].reveal();
+        m_numUnrevealed--;
+        // it has no neighbours, so the solver takes it for an opened empty cell
+        m_board.setCell(idx, 0);
+        const FieldPos pos = rowColFromIndex(idx);
+        publishCell(pos.first, pos.second);
+    }
+}
+
+void MineFieldItem::setSnapshotPublisher(bool publisher)
+{
+    m_snapshotPublisher = publisher;
+}
+
+void MineFieldItem::setRatingBand(int minLevel, int maxLevel)
+{
+    m_minRating = minLevel;
+    m_maxRating = maxLevel;
+}
+
+void MineFieldItem::setTopology(BoardTopology::Kind kind)
+{
+    m_topologyKind = kind;
+}
+
+void MineFieldItem::setMask(const BoardMask& mask)
+{
+    m_mask = mask;
+}
+
+void MineFieldItem::initField( const BoardCode& code )
+{
+    // codes describe plain square boards only
+    m_topologyKind = BoardTopology::Square;
+    m_mask = BoardMask();
+    initField(code.numRows(), code.numCols(), code.numMines());
+    // the board is given, so are its mines
+    m_lazyMines = false;
+    // layouts may be denser than generated fields
+    m_minesCount = code.numMines();
+    m_boardCode = code;
+    applyField(code.field());
+    m_board.reset(m_numRows, m_numCols, m_minesCount);
+
+    const int clickedIdx = code.clickedIdx();
+    if(clickedIdx >= 0 && !m_cells.at(clickedIdx).hasMine())
+    {
+        CellItem* item = &m_cells[clickedIdx];
+        item->release(true);
+        cellChanged(item);
+        if(item->isRevealed())
+            onItemRevealed(item);
+    }
+
+    // the field is known before the first click, so is every mark on it
+    startRecording();
+    m_record.opened = clickedIdx >= 0 && m_cells.at(clickedIdx).isRevealed();
 }
 
 void MineFieldItem::generateField(int clickedIdx)
 {
-    // generating mines ensuring that clickedIdx won't hold mine
-    // and that it will be an empty cell so the user don't have
-    // to make random guesses at the start of the game
-    QList<int> cellsWithMines;
-    int minesToPlace = m_minesCount;
-    int randomIdx = 0;
-    CellItem* item = nullptr;
-    FieldPos fp = rowColFromIndex(clickedIdx);
-
-    // this is the list of items we don't want to put the mine in
-    // to ensure that clickedIdx will stay an empty cell
-    // (it will be empty if none of surrounding items holds mine)
-    QList<CellItem*> neighbForClicked = adjacentItemsFor(fp.first, fp.second);
-
-    QRandomGenerator random(QRandomGenerator::global()->generate());
-    while(minesToPlace != 0)
-    {
-        randomIdx = random.bounded( m_numRows*m_numCols );
-        item = m_cells.at(randomIdx);
-        if(!item->hasMine()
-           && neighbForClicked.indexOf(item) == -1
-           && randomIdx != clickedIdx)
+    const bool square = m_topology.kind() == BoardTopology::Square && m_topology.isComplete();
+    const int minRating = m_minRating;
+    const int maxRating = Settings::noGuessBoards() ? qMin(m_maxRating, BoardRating::MAXIMAL_NO_GUESS_LEVEL)
+                                                    : m_maxRating;
+
+    // pregenerated boards cost nothing and are grouped by rating
+    const BoardCorpus* corpus = square ? BoardCorpus::installed() : nullptr;
+    if(corpus)
+    {
+        QElapsedTimer elapsed;
+        elapsed.start();
+        int level = 0;
+        const QVector<qint8> field = corpus->pick(m_numRows, m_numCols, m_minesCount, clickedIdx,
+                                                  minRating, maxRating, QRandomGenerator::global(), &level);
+        if(!field.isEmpty())
         {
-            // ok, let's mine this place! :-)
-            item->setHasMine(true);
-            cellsWithMines.append(randomIdx);
-            minesToPlace--;
+            m_boardCode = BoardCode::fromField(m_numRows, m_numCols, field, clickedIdx);
+            // rated when the corpus was built, the click doesn't wait for a replay
+            m_rating = BoardRating::fromLevel(level);
+            applyField(field);
+            m_perf->generationTime = elapsed.nsecsElapsed();
+            revealFirstClick(clickedIdx);
+            return;
         }
-        else
-            continue;
     }
 
-    for (int idx : std::as_const(cellsWithMines)) {
-        FieldPos rc = rowColFromIndex(idx);
-        const QList<CellItem*> neighbours = adjacentItemsFor(rc.first, rc.second);
-        for (CellItem *item : neighbours) {
-            if(!item->hasMine())
-                item->setDigit( item->digit()+1 );
+    // otherwise boards are generated until one is in the band, keeping the
+    // closest one in case time runs out. Rating replays the solver on every
+    // board, so this runs on a worker thread and the clicked cell stays
+    // pressed meanwhile, the GUI keeps painting
+    m_generating = true;
+    const int generation = m_generation.fetchAndAddOrdered(1) + 1;
+    const BoardTopology topology = m_topology;
+    const int numRows = m_numRows;
+    const int numCols = m_numCols;
+    const int numMines = m_minesCount;
+    m_generationPool.start([this, generation, topology, numRows, numCols, numMines, square,
+                            minRating, maxRating, clickedIdx]() {
+        QElapsedTimer elapsed;
+        elapsed.start();
+        int bestDistance = -1;
+        QVector<qint8> bestField;
+        BoardCode bestCode;
+        BoardRating bestRating;
+        for(int attempt=0; attempt<MAXIMAL_GENERATION_ATTEMPTS; ++attempt)
+        {
+            if(m_generation.loadAcquire() != generation)
+                return;
+            // board codes only describe plain square boards
+            const quint32 seed = QRandomGenerator::global()->generate();
+            const BoardCode code = square ? BoardCode::fromSeed(numRows, numCols, numMines, clickedIdx, seed)
+                                          : BoardCode();
+            const QVector<qint8> field = square ? code.field()
+                                                : FieldGenerator::generate(topology, numMines, clickedIdx, seed);
+            const BoardRating rating = BoardRating::rate(topology, numMines, field, clickedIdx);
+            const int level = rating.level();
+            const int distance = level < minRating ? minRating - level : qMax(0, level - maxRating);
+            if(bestDistance == -1 || distance < bestDistance)
+            {
+                bestDistance = distance;
+                bestField = field;
+                bestCode = code;
+                bestRating = rating;
+            }
+            if(distance == 0 || elapsed.elapsed() >= GENERATION_BUDGET)
+                break;
         }
+        const qint64 time = elapsed.nsecsElapsed();
+        QMetaObject::invokeMethod(this, [this, generation, clickedIdx, bestField, bestCode, bestRating, time]() {
+            if(m_generation.loadAcquire() != generation)
+                return;
+            m_generating = false;
+            m_boardCode = bestCode;
+            m_rating = bestRating;
+            applyField(bestField);
+            m_perf->generationTime = time;
+            revealFirstClick(clickedIdx);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MineFieldItem::revealFirstClick(int clickedIdx)
+{
+    startRecording();
+    Q_EMIT firstClickDone();
+
+    const int unrevealedBefore = m_numUnrevealed;
+    const int flaggedBefore = m_flaggedMinesCount;
+    CellItem* item = &m_cells[clickedIdx];
+    // forced, the cell may have been left pressed while the field was generated
+    item->release(true);
+    cellChanged(item);
+    if(item->isRevealed())
+        onItemRevealed(item);
+    const FieldPos pos = rowColFromIndex(clickedIdx);
+    recordMove(GameRecord::Reveal, pos.first, pos.second, unrevealedBefore, flaggedBefore);
+}
+
+void MineFieldItem::applyField(const QVector<qint8>& field)
+{
+    for(int i=0; i<field.size(); ++i)
+    {
+        if(field.at(i) == FieldGenerator::Mine)
+            m_cells[i].setHasMine(true);
+        else if(field.at(i) != 0)
+            m_cells[i].setDigit(field.at(i));
+    }
+
+    m_metrics = BoardMetrics::compute(m_topology, field);
+    if(m_lazyMines)
+    {
+        // mines may still move, no code describes the board
+        m_boardCode = BoardCode();
+        m_lazy.reset(m_topology, field, QRandomGenerator::global()->generate());
     }
 }
 
+QVector<qint8> MineFieldItem::currentField() const
+{
+    QVector<qint8> field(m_cells.size());
+    for(int i=0; i<m_cells.size(); ++i)
+        field[i] = m_cells.at(i).hasMine() ? FieldGenerator::Mine : m_cells.at(i).digit();
+    return field;
+}
+
+void MineFieldItem::commitCell(int idx, bool mayGuess)
+{
+    if(!m_lazy.isValid())
+        return;
+
+    QVector<int> changed;
+    if(!m_lazy.reveal(idx, [&]() { return mayGuess && guessForced(); }, &changed) || changed.isEmpty())
+        return;
+
+    // only covered cells change, they look the same
+    const QVector<qint8>& field = m_lazy.field();
+    for(int cell : std::as_const(changed))
+    {
+        CellItem& item = m_cells[cell];
+        if(field.at(cell) == FieldGenerator::Mine)
+            item.setHasMine(true);
+        else
+        {
+            if(item.hasMine())
+                item.setHasMine(false);
+            item.setDigit(field.at(cell));
+        }
+    }
+    m_metrics = BoardMetrics::compute(m_topology, field);
+}
+
+bool MineFieldItem::guessForced() const
+{
+    // the background analysis is usually done by the time the player clicks.
+    // Otherwise the click must not wait for a search of the frontier, only
+    // propagation runs: a cell only enumeration proves safe is missed, and
+    // the guess is then taken as forced and the mine moved away
+    const BoardAnalysis* analysis = m_analysis->analysis();
+    BoardAnalysis computed;
+    if(!analysis)
+    {
+        computed = Solver::analyse(m_topology, m_minesCount, m_board.current().cells(),
+                                   Solver::CancelCheck(), 0);
+        if(!computed.isValid())
+            return false;
+        analysis = &computed;
+    }
+    return analysis->safeCells.isEmpty();
+}
+
 void MineFieldItem::setupBorderItems()
 {
-    int i = 0;
-    for(int row=0; row<m_numRows+2; ++row)
-        for(int col=0; col<m_numCols+2; ++col)
+    // squares of the layout holding a cell, with a free ring around.
+    // Cells shifted by half a cell cover two squares
+    const int numRows = m_numRows+2;
+    const int numCols = layoutColumnCount()+2;
+    QVector<char> occupied(numRows*numCols, 0);
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        if(!m_topology.isActive(idx))
+            continue;
+        const QPointF pos = m_topology.cellPosition(idx);
+        const int row = static_cast<int>(pos.y()) + 1;
+        for(int col=static_cast<int>(std::floor(pos.x())); col<pos.x()+1; ++col)
+            occupied[row*numCols + col+1] = 1;
+    }
+    auto isOccupied = [&](int row, int col) {
+        return row >= 0 && row < numRows && col >= 0 && col < numCols && occupied.at(row*numCols + col);
+    };
+
+    // every free square next to a cell gets the elements for the sides touching cells
+    struct Border
+    {
+        int row;
+        int col;
+        KMinesState::BorderElement element;
+    };
+    QVector<Border> borders;
+    for(int row=0; row<numRows; ++row)
+        for(int col=0; col<numCols; ++col)
         {
-            if( row == 0 && col == 0)
+            if(isOccupied(row, col))
+                continue;
+            auto add = [&](KMinesState::BorderElement element) {
+                borders.append(Border{row, col, element});
+            };
+            const bool north = isOccupied(row-1, col);
+            const bool south = isOccupied(row+1, col);
+            const bool east = isOccupied(row, col+1);
+            const bool west = isOccupied(row, col-1);
+            const int sides = north + south + east + west;
+            if(sides == 3)
             {
-                m_borders.at(i)->setRowCol(0,0);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerNW);
-                i++;
+                add(!north ? KMinesState::BorderBayNorth : !south ? KMinesState::BorderBaySouth
+                    : !east ? KMinesState::BorderBayEast : KMinesState::BorderBayWest);
             }
-            else if( row == 0 && col == m_numCols+1)
+            else if(sides == 2 && north != south)
             {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerNE);
-                i++;
+                // cells below and right of it, i.e. the square is north west of them
+                if(south)
+                    add(east ? KMinesState::BorderInsideCornerNW : KMinesState::BorderInsideCornerNE);
+                else
+                    add(east ? KMinesState::BorderInsideCornerSW : KMinesState::BorderInsideCornerSE);
             }
-            else if( row == m_numRows+1 && col == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerSW);
-                i++;
-            }
-            else if( row == m_numRows+1 && col == m_numCols+1 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerSE);
-                i++;
-            }
-            else if( row == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderNorth);
-                i++;
-            }
-            else if( row == m_numRows+1 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderSouth);
-                i++;
-            }
-            else if( col == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderWest);
-                i++;
-            }
-            else if( col == m_numCols+1 )
+            else
             {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderEast);
-                i++;
+                if(south)
+                    add(KMinesState::BorderNorth);
+                if(north)
+                    add(KMinesState::BorderSouth);
+                if(east)
+                    add(KMinesState::BorderWest);
+                if(west)
+                    add(KMinesState::BorderEast);
             }
+
+            // cells touching the square only by a corner
+            if(!south && !east && isOccupied(row+1, col+1))
+                add(KMinesState::BorderCornerNW);
+            if(!south && !west && isOccupied(row+1, col-1))
+                add(KMinesState::BorderCornerNE);
+            if(!north && !east && isOccupied(row-1, col+1))
+                add(KMinesState::BorderCornerSW);
+            if(!north && !west && isOccupied(row-1, col-1))
+                add(KMinesState::BorderCornerSE);
         }
+
+    // if field is being shrunk, delete elements at the end before resizing vector
+    const int oldBorderSize = m_borders.size();
+    for(int i=borders.size(); i<oldBorderSize; ++i)
+    {
+        scene()->removeItem(m_borders[i]);
+        delete m_borders[i];
+    }
+    m_borders.resize(borders.size());
+    for(int i=oldBorderSize; i<borders.size(); ++i)
+        m_borders[i] = new BorderItem(m_atlas, this);
+
+    for(int i=0; i<borders.size(); ++i)
+    {
+        m_borders.at(i)->setRowCol(borders.at(i).row, borders.at(i).col);
+        m_borders.at(i)->setBorderType(borders.at(i).element);
+    }
 }
 
 QRectF MineFieldItem::boundingRect() const
 {
     // +2 - because of border on each side
-    return QRectF(0, 0, m_cellSize*(m_numCols+2), m_cellSize*(m_numRows+2));
+    return QRectF(0, 0, m_cellSize*(layoutColumnCount()+2), m_cellSize*(m_numRows+2));
+}
+
+int MineFieldItem::layoutColumnCount() const
+{
+    return static_cast<int>(std::ceil(m_topology.size().width()));
+}
+
+FieldPos MineFieldItem::cellAt(const QPointF& pos) const
+{
+    if(m_cellSize == 0)
+        return qMakePair(-1, -1);
+    // -1 - because of border
+    const int idx = m_topology.cellAt(pos/m_cellSize - QPointF(1, 1));
+    if(idx == -1)
+        return qMakePair(-1, -1);
+    return qMakePair(idx / m_numCols, idx % m_numCols);
 }
 
 int MineFieldItem::rowCount() const
@@ -227,11 +560,77 @@ int MineFieldItem::minesCount() const
     return m_minesCount;
 }
 
+BoardMetrics MineFieldItem::metrics() const
+{
+    return m_metrics;
+}
+
+int MineFieldItem::clickCount() const
+{
+    return m_clickCount;
+}
+
+BoardCode MineFieldItem::boardCode() const
+{
+    return m_boardCode;
+}
+
+BoardRating MineFieldItem::rating() const
+{
+    return m_rating;
+}
+
 void MineFieldItem::paint( QPainter * painter, const QStyleOptionGraphicsItem* opt, QWidget* w)
 {
-    Q_UNUSED(painter);
-    Q_UNUSED(opt);
     Q_UNUSED(w);
+    if(m_cellSize == 0 || m_cells.isEmpty())
+        return;
+
+    // -1 - because of border. Rows are always stacked, columns only
+    // where a cell is never left of its column: hexagonal rows are
+    // shifted right by half a cell, layers have gaps between them
+    const QRectF& exposed = opt->exposedRect;
+    const int firstRow = qMax(0, static_cast<int>(exposed.top()/m_cellSize) - 1);
+    const int lastRow = qMin(m_numRows-1, static_cast<int>(exposed.bottom()/m_cellSize) - 1);
+    int firstCol = 0;
+    int lastCol = m_numCols-1;
+    if(m_topology.kind() != BoardTopology::Layers)
+    {
+        const int shift = m_topology.kind() == BoardTopology::Hexagonal ? 1 : 0;
+        firstCol = qMax(0, static_cast<int>(exposed.left()/m_cellSize) - 1 - shift);
+        lastCol = qMin(m_numCols-1, static_cast<int>(exposed.right()/m_cellSize) - 1);
+    }
+
+    const QSize size(m_cellSize, m_cellSize);
+    const qreal ratio = painter->device()->devicePixelRatioF();
+    // cells revealed by a cascade which isn't shown yet look untouched
+    static const CellItem coveredCell;
+    for(int row=firstRow; row<=lastRow; ++row)
+        for(int col=firstCol; col<=lastCol; ++col)
+        {
+            const int idx = row*m_numCols + col;
+            const QRectF rect = cellRect(row, col);
+            if(!m_topology.isActive(idx) || !rect.intersects(exposed))
+                continue;
+            const QPointF topLeft = rect.topLeft();
+            const QStringList& keys = m_visualPending.testBit(idx) ? coveredCell.spriteKeys()
+                                                                   : m_cells.at(idx).spriteKeys();
+            for(const QString& key : keys)
+                painter->drawPixmap(topLeft, m_atlas->spritePixmap(key, size, ratio));
+        }
+}
+
+QRectF MineFieldItem::cellRect(int row, int col) const
+{
+    // +1 - because of border
+    const QPointF pos = m_topology.cellPosition(row*m_numCols + col) + QPointF(1, 1);
+    return QRectF(pos*m_cellSize, QSizeF(m_cellSize, m_cellSize));
+}
+
+void MineFieldItem::updateCell(const CellItem* item)
+{
+    const FieldPos pos = rowColFromIndex(item - m_cells.constData());
+    update(cellRect(pos.first, pos.second));
 }
 
 void MineFieldItem::resizeToFitInRect(const QRectF& rect)
@@ -247,21 +646,20 @@ void MineFieldItem::resizeToFitInRect(const QRectF& rect)
     // to understand that criteria for choosing one side or another (for
     // determining cell size from it) is comparing
     // cols/r.width() and rows/r.height():
-    bool chooseHorizontalSide = (m_numCols+2) / rect.width() > (m_numRows+2) / rect.height();
+    const int numCols = layoutColumnCount();
+    bool chooseHorizontalSide = (numCols+2) / rect.width() > (m_numRows+2) / rect.height();
 
     qreal size = 0;
     if( chooseHorizontalSide )
-        size = rect.width() / (m_numCols+2);
+        size = rect.width() / (numCols+2);
     else
         size = rect.height() / (m_numRows+2);
 
     m_cellSize = static_cast<int>(size);
 
-    for (CellItem* item : std::as_const(m_cells)) {
-        item->setRenderSize(QSize(m_cellSize, m_cellSize));
-    }
-
     for (BorderItem *item : std::as_const(m_borders)) {
+        // the theme may have changed
+        item->updatePixmap();
         item->setRenderSize(QSize(m_cellSize, m_cellSize));
     }
 
@@ -270,14 +668,6 @@ void MineFieldItem::resizeToFitInRect(const QRectF& rect)
 
 void MineFieldItem::adjustItemPositions()
 {
-    Q_ASSERT( m_cells.size() == m_numRows*m_numCols );
-
-    for(int row=0; row<m_numRows; ++row)
-        for(int col=0; col<m_numCols; ++col)
-        {
-            itemAt(row,col)->setPos((col+1)*m_cellSize, (row+1)*m_cellSize);
-        }
-
     for (BorderItem* item : std::as_const(m_borders)) {
         item->setPos( item->col()*m_cellSize, item->row()*m_cellSize );
     }
@@ -285,70 +675,80 @@ void MineFieldItem::adjustItemPositions()
 
 bool MineFieldItem::onItemRevealed(int row, int col)
 {
-    std::cout << "revealed " << row << " " << col << std::endl;
+    const PerfCounters::Timer timer(&m_perf->revealTime);
+
     m_numUnrevealed--;
     if(itemAt(row,col)->hasMine())
     {
         revealAllMines();
     }
-    else if(itemAt(row,col)->digit() == 0) // empty cell
+    else
     {
-        revealEmptySpace(row,col);
+        // cells revealed from here on are shown over the next frames,
+        // the game state itself is final when this function returns
+        m_cascading = true;
+        if(itemAt(row,col)->digit() == 0) // empty cell
+            revealEmptySpace(row,col);
+
+        const PerfCounters::Timer propagationTimer(&m_perf->propagationTime);
+        queueTrivials(row, col);
+        while(!m_trivialQueue.isEmpty())
+        {
+            const FieldPos pos = rowColFromIndex(m_trivialQueue.takeLast());
+            updateTrivials(pos.first, pos.second);
+        }
+        m_cascading = false;
     }
     // now let's check for possible win/loss
-    if(checkLost())
-        return true;
-    updateTrivials(row, col);
-    const QList<FieldPos> list = adjacentRowColsFor(row,col);
-    for (const FieldPos& pos : list)
+    if(checkLost() || checkWon())
     {
-        if (itemAt(pos)->isRevealed())
-            updateTrivials(pos.first, pos.second);
+        // final position, nothing left to analyse
+        m_board.publish();
+        return true;
     }
-    return checkWon();
+    startVisualUpdates(row, col);
+    publishBoard();
+    return false;
 }
 
 void MineFieldItem::revealEmptySpace(int row, int col)
 {
-    // recursively reveal neighbour cells until we find cells with digit
-    const QList<FieldPos> list = adjacentRowColsFor(row,col);
-    CellItem *item = nullptr;
-
-    for (const FieldPos& pos : list) {
-        // first is row, second is col
-        item = itemAt(pos);
-        if(item->isRevealed() || item->isFlagged() || item->isQuestioned())
-            continue;
-        if(item->digit() == 0)
-        {
-            item->reveal();
-            m_numUnrevealed--;
-            revealEmptySpace(pos.first,pos.second);
-        }
-        else
-        {
+    // reveal neighbour cells until we find cells with digit,
+    // breadth first and without recursion, so that openings
+    // of any size neither overflow the stack nor allocate per cell
+    QVector<int> queue;
+    queue.append(row*m_numCols + col);
+    for(int head=0; head<queue.size(); ++head)
+    {
+        m_topology.forNeighbours(queue.at(head), [&](int idx) {
+            CellItem* item = &m_cells[idx];
+            if(item->isRevealed() || item->isFlagged() || item->isQuestioned())
+                return;
             item->reveal();
+            const FieldPos pos = rowColFromIndex(idx);
+            cellChanged(pos.first, pos.second);
             m_numUnrevealed--;
-            updateTrivials(row, col);
-            for (const FieldPos& pos : list)
-            {
-                if (itemAt(pos)->isRevealed())
-                    updateTrivials(pos.first, pos.second);
-            }
-        }
+            if(item->digit() == 0)
+                queue.append(idx);
+            else
+                queueTrivials(pos.first, pos.second);
+        });
     }
 }
 
 void MineFieldItem::mousePressEvent( QGraphicsSceneMouseEvent *ev )
 {
-    if(m_gameOver)
+    if(m_gameOver || m_generating)
         return;
 
-    int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
-    int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
-    if( row <0 || row >= m_numRows || col < 0 || col >= m_numCols )
+    const FieldPos pos = cellAt(ev->pos());
+    const int row = pos.first;
+    const int col = pos.second;
+    if( row < 0 )
         return;
 
+    m_perf->beginAction();
+    flushPendingMove();
     CellItem* itemUnderMouse = itemAt(row,col);
     if(!itemUnderMouse)
     {
@@ -365,11 +765,15 @@ void MineFieldItem::mousePressEvent( QGraphicsSceneMouseEvent *ev )
         // in case we just started mid-button emulation (first LeftClick then added a RightClick)
         // undo press that was made by LeftClick. in other cases it won't hurt :)
         itemUnderMouse->undoPress();
+        updateCell(itemUnderMouse);
 
         const QList<CellItem*> neighbours = adjacentItemsFor(row,col);
         for (CellItem* item : neighbours) {
             if(!item->isFlagged() && !item->isQuestioned() && !item->isRevealed())
+            {
                 item->press();
+                updateCell(item);
+            }
             m_midButtonPos = qMakePair(row,col);
 
             m_leftButtonPos = qMakePair(-1,-1); // reset it
@@ -378,19 +782,26 @@ void MineFieldItem::mousePressEvent( QGraphicsSceneMouseEvent *ev )
     else if(ev->button() == Qt::LeftButton)
     {
         itemUnderMouse->press();
+        updateCell(itemUnderMouse);
         m_leftButtonPos = qMakePair(row,col);
     }
 }
 
 void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
 {
-    if(m_gameOver)
+    if(m_gameOver || m_generating)
         return;
 
-    int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
-    int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
+    m_perf->beginAction();
+    flushPendingMove();
+    // the player acts on what is shown, catch up with the last cascade
+    flushVisualUpdates();
 
-    if( row <0 || row >= m_numRows || col < 0 || col >= m_numCols )
+    const FieldPos pos = cellAt(ev->pos());
+    const int row = pos.first;
+    const int col = pos.second;
+
+    if( row < 0 )
     {
         // there might be the case when player moved mouse outside game field
         // while holding mid button and released it outside the field
@@ -401,6 +812,7 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
             const QList<CellItem*> neighbours = adjacentItemsFor(m_midButtonPos.first,m_midButtonPos.second);
             for (CellItem *item : neighbours) {
                 item->undoPress();
+                updateCell(item);
             }
             m_midButtonPos = qMakePair(-1,-1);
             m_emulatingMidButton = false;
@@ -409,6 +821,7 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
         if(m_leftButtonPos.first != -1)
         {
             itemAt(m_leftButtonPos)->undoPress();
+            updateCell(itemAt(m_leftButtonPos));
             m_leftButtonPos = qMakePair(-1,-1);
         }
         return;
@@ -418,16 +831,29 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
 
     bool midButtonReleased = (ev->button() == Qt::MiddleButton || m_emulatingMidButton);
 
+    const int unrevealedBefore = m_numUnrevealed;
+    const int flaggedBefore = m_flaggedMinesCount;
+    // the field of a loaded board is there from the start,
+    // so its game starts with any action, not only a reveal
+    if(m_firstClick && m_boardCode.isValid())
+    {
+        m_firstClick = false;
+        Q_EMIT firstClickDone();
+    }
+
     if( midButtonReleased )
     {
         m_midButtonPos = qMakePair(-1,-1);
+        m_clickCount++;
 
         const QList<CellItem*> neighbours = adjacentItemsFor(row,col);
         if(!itemUnderMouse->isRevealed())
         {
             for (CellItem *item : neighbours) {
                 item->undoPress();
+                updateCell(item);
             }
+            recordMove(GameRecord::Chord, row, col, unrevealedBefore, flaggedBefore);
             return;
         }
 
@@ -444,8 +870,11 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
             for (CellItem *item : neighbours) {
                 if(!item->isRevealed()) // revealing only unrevealed ones
                 {
+                    if(!item->isFlagged() && !item->isQuestioned())
+                        commitCell(item - m_cells.constData(), false);
                     // force=true to omit Pressed check
                     item->release(true);
+                    cellChanged(item);
                     // If revealing the item ends the game, stop the loop,
                     // since everything that needs to be done for the current game is finished.
                     // Otherwise, if the user has restarted the game, we'll be revealing
@@ -459,14 +888,17 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
         {
             for (CellItem *item : neighbours) {
                 item->undoPress();
+                updateCell(item);
             }
         }
+        recordMove(GameRecord::Chord, row, col, unrevealedBefore, flaggedBefore);
     }
     else if(ev->button() == Qt::LeftButton && (ev->buttons() & Qt::RightButton) == false)
     {
         if(m_midButtonPos.first != -1) // mid-button is already pressed
         {
             itemUnderMouse->undoPress();
+            updateCell(itemUnderMouse);
             return;
         }
 
@@ -476,26 +908,35 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
         if(m_leftButtonPos.first == -1)
             return;
 
+        m_clickCount++;
+        if(m_firstClick && !itemUnderMouse->isRevealed())
+        {
+            m_firstClick = false;
+            m_leftButtonPos = qMakePair(-1,-1);//reset
+            generateField( row*m_numCols + col );
+            return;
+        }
         if(!itemUnderMouse->isRevealed()) // revealing only unrevealed ones
         {
-            if(m_firstClick)
-            {
-                m_firstClick = false;
-                generateField( row*m_numCols + col );
-                Q_EMIT firstClickDone();
-            }
 
+            if(itemUnderMouse->state() == KMinesState::Pressed)
+                commitCell(row*m_numCols + col, true);
             itemUnderMouse->release();
+            cellChanged(row, col);
             if(itemUnderMouse->isRevealed())
                 onItemRevealed(row,col);
         }
+        recordMove(GameRecord::Reveal, row, col, unrevealedBefore, flaggedBefore);
         m_leftButtonPos = qMakePair(-1,-1);//reset
     }
     else if(ev->button() == Qt::RightButton && (ev->buttons() & Qt::LeftButton) == false)
     {
         bool wasFlagged = itemUnderMouse->isFlagged();
 
+        m_clickCount++;
         itemUnderMouse->mark();
+        cellChanged(row, col);
+        publishBoard();
 
         bool flagStateChanged = (itemUnderMouse->isFlagged() != wasFlagged);
         if(flagStateChanged)
@@ -506,51 +947,130 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
                 m_flaggedMinesCount--;
             Q_EMIT flaggedMinesCountChanged(m_flaggedMinesCount);
         }
+        recordMove(GameRecord::Mark, row, col, unrevealedBefore, flaggedBefore);
     }
 }
 
+void MineFieldItem::startRecording()
+{
+    // marks made before the field was generated are part of the game
+    const QVector<GameRecord::Move> earlyMoves = m_record.moves;
+    m_record = GameRecord();
+    if(!Settings::recordGames() || !m_boardCode.isValid())
+        return;
+    m_record.board = m_boardCode;
+    m_record.player = KUser().loginName();
+    m_record.started = QDateTime::currentDateTime();
+    m_record.questionMarks = Settings::useQuestionMarks();
+    m_record.moves = earlyMoves;
+    m_recordClock.start();
+}
+
+void MineFieldItem::recordMove(GameRecord::MoveKind kind, int row, int col, int unrevealedBefore, int flaggedBefore)
+{
+    // until the field exists moves are kept for startRecording(), at time 0
+    const bool started = m_record.isValid();
+    if(!started && !m_firstClick)
+        return;
+
+    GameRecord::Move move;
+    move.time = started ? m_recordClock.elapsed() : 0;
+    move.kind = kind;
+    move.cell = row*m_numCols + col;
+    move.revealed = unrevealedBefore - m_numUnrevealed;
+    move.flagged = m_flaggedMinesCount - flaggedBefore;
+    m_record.moves.append(move);
+    if(!started || !m_gameOver)
+        return;
+
+    m_record.won = std::none_of(m_cells.cbegin(), m_cells.cend(),
+                                [](const CellItem& item) { return item.isExploded(); });
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                            + QLatin1String("/games");
+    if(!m_record.save(directory))
+        qCWarning(KMINES_LOG) << "Unable to save game record in" << directory;
+    m_record = GameRecord();
+}
+
 void MineFieldItem::mouseMoveEvent( QGraphicsSceneMouseEvent *ev )
 {
-    if(m_gameOver)
+    if(m_gameOver || m_generating)
+        return;
+
+    const FieldPos pos = cellAt(ev->pos());
+    if( pos.first < 0 )
         return;
 
-    int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
-    int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
+    m_pendingMovePos = pos;
+    m_pendingMoveMidButton = ((ev->buttons() & Qt::MiddleButton) ||
+                             ( (ev->buttons() & Qt::LeftButton) && (ev->buttons() & Qt::RightButton) ) );
+    m_pendingMoveLeftButton = (ev->buttons() & Qt::LeftButton);
+    m_movePending = true;
+
+    // the first move after a pause is applied right away,
+    // the following ones are coalesced until the timer fires
+    if(!m_moveThrottleTimer.isActive())
+    {
+        applyPendingMove();
+        m_moveThrottleTimer.start();
+    }
+}
+
+void MineFieldItem::flushPendingMove()
+{
+    m_moveThrottleTimer.stop();
+    if(m_movePending)
+        applyPendingMove();
+}
 
-    if( row < 0 || row >= m_numRows || col < 0 || col >= m_numCols )
+void MineFieldItem::applyPendingMove()
+{
+    m_movePending = false;
+    if(m_gameOver)
         return;
 
-    bool midButtonPressed = ((ev->buttons() & Qt::MiddleButton) ||
-                            ( (ev->buttons() & Qt::LeftButton) && (ev->buttons() & Qt::RightButton) ) );
+    const int row = m_pendingMovePos.first;
+    const int col = m_pendingMovePos.second;
 
-    if(midButtonPressed)
+    if(m_pendingMoveMidButton)
     {
         if((m_midButtonPos.first != -1 && m_midButtonPos.second != -1) &&
            (m_midButtonPos.first != row || m_midButtonPos.second != col))
         {
-            // un-press previously pressed cells
             const QList<CellItem*> prevNeighbours = adjacentItemsFor(m_midButtonPos.first,
                                                                      m_midButtonPos.second);
+            const QList<CellItem*> neighbours = adjacentItemsFor(row,col);
+
+            // un-press cells which left the pressed area
             for (CellItem *item : prevNeighbours) {
-                   item->undoPress();
+                if(!neighbours.contains(item))
+                {
+                    item->undoPress();
+                    updateCell(item);
+                }
             }
 
-            // and press current neighbours
-            const QList<CellItem*> neighbours = adjacentItemsFor(row,col);
+            // and press the ones which entered it
             for (CellItem *item : neighbours) {
-                item->press();
+                if(!prevNeighbours.contains(item))
+                {
+                    item->press();
+                    updateCell(item);
+                }
             }
 
             m_midButtonPos = qMakePair(row,col);
         }
     }
-    else if(ev->buttons() & Qt::LeftButton)
+    else if(m_pendingMoveLeftButton)
     {
         if((m_leftButtonPos.first != -1 && m_leftButtonPos.second != -1) &&
            (m_leftButtonPos.first != row || m_leftButtonPos.second != col))
         {
             itemAt(m_leftButtonPos)->undoPress();
+            updateCell(itemAt(m_leftButtonPos));
             itemAt(row,col)->press();
+            updateCell(itemAt(row,col));
             m_leftButtonPos = qMakePair(row,col);
         }
     }
@@ -558,10 +1078,11 @@ void MineFieldItem::mouseMoveEvent( QGraphicsSceneMouseEvent *ev )
 
 void MineFieldItem::revealAllMines()
 {
-    for (CellItem* item : std::as_const(m_cells)) {
-        if( (item->isFlagged() && !item->hasMine()) || (!item->isFlagged() && item->hasMine()) )
+    for (CellItem& item : m_cells) {
+        if( (item.isFlagged() && !item.hasMine()) || (!item.isFlagged() && item.hasMine()) )
         {
-            item->reveal();
+            item.reveal();
+            cellChanged(&item);
             m_numUnrevealed--;
         }
     }
@@ -569,24 +1090,228 @@ void MineFieldItem::revealAllMines()
 
 bool MineFieldItem::onItemRevealed(CellItem* item)
 {
-    int idx = m_cells.indexOf(item);
-    if(idx == -1)
+    const FieldPos pos = rowColFromIndex(item - m_cells.constData());
+    return onItemRevealed(pos.first, pos.second);
+}
+
+void MineFieldItem::cellChanged(int row, int col)
+{
+    m_perf->cellsTouched++;
+    const int idx = row*m_numCols + col;
+    const CellItem& item = m_cells.at(idx);
+    if(m_lazy.isValid() && item.isRevealed() && !item.hasMine())
+        m_lazy.setRevealed(idx);
+    // published versions follow the game state, not what is shown yet
+    if(item.isFlagged())
+        m_board.setCell(idx, BoardView::Flagged);
+    else if(item.isRevealed() && !item.hasMine())
+        m_board.setCell(idx, item.digit());
+    else
+        m_board.setCell(idx, BoardView::Covered);
+    if(m_cascading && item.isRevealed())
     {
-        qCDebug(KMINES_LOG) << "really strange - item not found";
+        // shown later by updateVisuals()
+        if(!m_visualPending.testBit(idx))
+        {
+            m_visualPending.setBit(idx);
+            m_visualQueue.append(idx);
+        }
+        return;
+    }
+    update(cellRect(row, col));
+    publishCell(row, col);
+}
+
+void MineFieldItem::publishCell(int row, int col)
+{
+    if(!m_snapshot)
+        return;
+
+    if(!m_topology.isActive(row*m_numCols + col))
+    {
+        m_snapshot->setCell(row, col, BoardSnapshotHeader::Inactive);
+        return;
+    }
+
+    const CellItem* item = itemAt(row,col);
+    BoardSnapshotHeader::Cell value = BoardSnapshotHeader::Covered;
+    switch(item->state())
+    {
+        case KMinesState::Revealed:
+            if(item->hasMine())
+                value = item->isExploded() ? BoardSnapshotHeader::Exploded : BoardSnapshotHeader::Mine;
+            else
+                value = static_cast<BoardSnapshotHeader::Cell>(BoardSnapshotHeader::Digit0 + item->digit());
+            break;
+        case KMinesState::Error:
+            value = BoardSnapshotHeader::WrongFlag;
+            break;
+        case KMinesState::Flagged:
+            value = BoardSnapshotHeader::Flagged;
+            break;
+        case KMinesState::Questioned:
+            value = BoardSnapshotHeader::Questioned;
+            break;
+        default:
+            // pressed cells are still covered for the outside world
+            break;
+    }
+    m_snapshot->setCell(row, col, value);
+}
+
+void MineFieldItem::cellChanged(CellItem* item)
+{
+    const FieldPos pos = rowColFromIndex(item - m_cells.constData());
+    cellChanged(pos.first, pos.second);
+}
+
+BoardView MineFieldItem::boardView() const
+{
+    return m_board.current();
+}
+
+void MineFieldItem::publishBoard()
+{
+    m_analysis->analyse(m_board.publish());
+}
+
+bool MineFieldItem::showHint()
+{
+    if(m_gameOver || m_generating)
+        return false;
+
+    int idx = -1;
+    if(m_firstClick && !m_boardCode.isValid())
+    {
+        // the first click is always safe and opens an empty area,
+        // shaped boards may leave out the middle though
+        idx = m_numRows/2*m_numCols + m_numCols/2;
+        while(!m_topology.isActive(idx))
+            idx = (idx + 1) % m_cells.size();
+    }
+    else
+        idx = m_analysis->hintCell();
+    if(idx == -1)
         return false;
+
+    if(m_hintIdx != -1 && m_cells.at(m_hintIdx).state() == KMinesState::Hint)
+    {
+        m_cells[m_hintIdx].unflag();
+        cellChanged(&m_cells[m_hintIdx]);
+    }
+    m_hintIdx = idx;
+    m_cells[idx].hint();
+    cellChanged(&m_cells[idx]);
+    return true;
+}
+
+void MineFieldItem::startVisualUpdates(int row, int col)
+{
+    const int count = m_visualQueue.size() - m_visualHead;
+    if(count == 0)
+        return;
+
+    if(!Settings::animateCascades())
+    {
+        m_visualLayers.clear();
+        m_visualTimer.start(0);
+        return;
+    }
+
+    // order pending cells by distance from the clicked one, so that
+    // they appear as a wave. Counting sort keeps this linear
+    QVector<int> distances(count);
+    int maxDistance = 0;
+    const QPointF origin = m_topology.cellPosition(row*m_numCols + col);
+    for(int i=0; i<count; ++i)
+    {
+        const QPointF pos = m_topology.cellPosition(m_visualQueue.at(m_visualHead + i));
+        distances[i] = qRound(qMax(qAbs(pos.y() - origin.y()), qAbs(pos.x() - origin.x())));
+        maxDistance = qMax(maxDistance, distances.at(i));
     }
+    QVector<int> offsets(maxDistance + 2, 0);
+    for(int distance : std::as_const(distances))
+        offsets[distance + 1]++;
+    for(int d=1; d<offsets.size(); ++d)
+        offsets[d] += offsets.at(d-1);
+
+    QVector<int> sorted(count);
+    m_visualLayers.resize(count);
+    for(int i=0; i<count; ++i)
+    {
+        const int target = offsets[distances.at(i)]++;
+        sorted[target] = m_visualQueue.at(m_visualHead + i);
+        m_visualLayers[target] = distances.at(i);
+    }
+    m_visualQueue = sorted;
+    m_visualHead = 0;
+
+    // whole wave takes a fixed number of frames, whatever the size of opening
+    m_waveStep = qMax(1, (maxDistance + WAVE_FRAMES - 1) / WAVE_FRAMES);
+    m_waveDistance = 0;
+    m_visualTimer.start(WAVE_FRAME_INTERVAL);
+}
+
+void MineFieldItem::updateVisuals()
+{
+    QElapsedTimer budget;
+    budget.start();
+    m_waveDistance += m_waveStep;
+
+    QRectF dirty;
+    {
+        const BoardSnapshot::Transaction transaction(m_snapshot.data());
+        while(m_visualHead < m_visualQueue.size())
+        {
+            if(!m_visualLayers.isEmpty() && m_visualLayers.at(m_visualHead) > m_waveDistance)
+                break;
+            // check the clock only now and then, it is not free either
+            if((m_visualHead & 0xff) == 0 && budget.elapsed() >= VISUAL_SLICE_BUDGET)
+                break;
+
+            const int idx = m_visualQueue.at(m_visualHead++);
+            m_visualPending.clearBit(idx);
+            const FieldPos pos = rowColFromIndex(idx);
+            publishCell(pos.first, pos.second);
+            dirty |= cellRect(pos.first, pos.second);
+        }
+    }
+    if(!dirty.isNull())
+        update(dirty);
+
+    if(m_visualHead == m_visualQueue.size())
+    {
+        m_visualTimer.stop();
+        m_visualQueue.clear();
+        m_visualLayers.clear();
+        m_visualHead = 0;
+    }
+}
 
-    int row = idx / m_numCols;
-    int col = idx - row*m_numCols;
-    return onItemRevealed(row,col);
+void MineFieldItem::clearVisualUpdates()
+{
+    m_visualTimer.stop();
+    for(int i=m_visualHead; i<m_visualQueue.size(); ++i)
+        m_visualPending.clearBit(m_visualQueue.at(i));
+    m_visualQueue.clear();
+    m_visualLayers.clear();
+    m_visualHead = 0;
+}
+
+void MineFieldItem::flushVisualUpdates()
+{
+    m_visualLayers.clear();
+    while(m_visualHead < m_visualQueue.size())
+        updateVisuals();
 }
 
 bool MineFieldItem::checkLost()
 {
     // for loss...
-    for (CellItem* item : std::as_const(m_cells)) {
-        if(item->isExploded())
+    for (const CellItem& item : std::as_const(m_cells)) {
+        if(item.isExploded())
         {
+            flushVisualUpdates();
             m_gameOver = true;
             Q_EMIT gameOver(false);
             return true;
@@ -602,12 +1327,16 @@ bool MineFieldItem::checkWon()
     // all contain bombs. this counts as win
     if(m_numUnrevealed == m_minesCount)
     {
+        flushVisualUpdates();
         // mark not flagged cells (if any) with flags
-        for (CellItem* item : std::as_const(m_cells)) {
-            if( item->isQuestioned() )
-                item->mark();
-            if( !item->isRevealed() && !item->isFlagged() )
-                item->mark();
+        for (CellItem& item : m_cells) {
+            const KMinesState::CellState oldState = item.state();
+            if( item.isQuestioned() )
+                item.mark();
+            if( !item.isRevealed() && !item.isFlagged() )
+                item.mark();
+            if( item.state() != oldState )
+                cellChanged(&item);
         }
         m_gameOver = true;
         // now all mines should be flagged, notify about this
@@ -621,22 +1350,9 @@ bool MineFieldItem::checkWon()
 QList<FieldPos> MineFieldItem::adjacentRowColsFor(int row, int col)
 {
     QList<FieldPos> resultingList;
-    if(row != 0 && col != 0) // upper-left diagonal
-        resultingList.append( qMakePair(row-1,col-1) );
-    if(row != 0) // upper
-        resultingList.append(qMakePair(row-1, col));
-    if(row != 0 && col != m_numCols-1) // upper-right diagonal
-        resultingList.append(qMakePair(row-1, col+1));
-    if(col != 0) // on the left
-        resultingList.append(qMakePair(row,col-1));
-    if(col != m_numCols-1) // on the right
-        resultingList.append(qMakePair(row, col+1));
-    if(row != m_numRows-1 && col != 0) // bottom-left diagonal
-        resultingList.append(qMakePair(row+1, col-1));
-    if(row != m_numRows-1) // bottom
-        resultingList.append(qMakePair(row+1, col));
-    if(row != m_numRows-1 && col != m_numCols-1) // bottom-right diagonal
-        resultingList.append(qMakePair(row+1, col+1));
+    m_topology.forNeighbours(row*m_numCols + col, [&](int idx) {
+        resultingList.append(rowColFromIndex(idx));
+    });
     return resultingList;
 }
 
@@ -650,46 +1366,33 @@ QList<CellItem*> MineFieldItem::adjacentItemsFor(int row, int col)
     return resultingList;
 }
 
-void MineFieldItem::printCellShit(int row, int col)
+void MineFieldItem::queueTrivials(int row, int col)
 {
-    CellItem *item = itemAt(row,col);
-    std::cout << "row=" << row << " " << "col=" << col << " ";
-    if (item->isRevealed())
-        std::cout << "revealed ";
-    else
-        std::cout << "covered ";
-    if (item->isTriviallyFlagged())
-        std::cout << "trivially_flagged ";
-    if (item->hasMine())
-        std::cout << "mined ";
-    else
-        std::cout << "digit=" << item->digit();
-    std::cout << std::endl;
+    // a changed cell may decide its revealed neighbours and itself
+    auto queueCell = [this](int idx) {
+        const CellItem& item = m_cells.at(idx);
+        if(item.isRevealed() && !item.hasMine() && item.digit() != 0)
+            m_trivialQueue.append(idx);
+    };
+    const int center = row*m_numCols + col;
+    queueCell(center);
+    m_topology.forNeighbours(center, queueCell);
 }
 
 void MineFieldItem::updateTrivials(int row, int col)
 {
-    std::cout << "updateTrivials ";
-    printCellShit(row, col);
-
-
     CellItem *centerItem = itemAt(row,col);
-    assert (!centerItem->hasMine());
+    Q_ASSERT(!centerItem->hasMine());
 
     // revealEmptySpace already does the work
     if (centerItem->digit() == 0)
         return;
 
-    // recursively reveal neighbour cells until we find cells with digit
-    const QList<FieldPos> list = adjacentRowColsFor(row,col);
     QList<FieldPos> flagged;
     QList<FieldPos> undecided;
 
-    for (const FieldPos& pos : list)
+    for (const FieldPos& pos : adjacentRowColsFor(row,col))
     {
-        std::cout << "neighbor ";
-        printCellShit(pos.first, pos.second);
-
         // first is row, second is col
         CellItem *item = itemAt(pos);
 
@@ -707,61 +1410,44 @@ void MineFieldItem::updateTrivials(int row, int col)
         }
     }
 
+    // every change queues the cells it may decide, so that
+    // long chains of deductions don't recurse
     if (flagged.size() == centerItem->digit())
     {
-        for (const FieldPos& pos : undecided)
+        for (const FieldPos& pos : std::as_const(undecided))
         {
             // first is row, second is col
             CellItem *item = itemAt(pos);
+            // may have been opened by an earlier empty cell of this loop
+            if (item->isRevealed())
+                continue;
 
+            item->reveal();
+            cellChanged(pos.first, pos.second);
+            m_numUnrevealed--;
             if(item->digit() == 0)
-            {
-                item->reveal();
-                m_numUnrevealed--;
                 revealEmptySpace(pos.first,pos.second);
-            }
-            else
-            {
-                item->reveal();
-                m_numUnrevealed--;
-                const QList<FieldPos> list = adjacentRowColsFor(pos.first, pos.second);
-                for (const FieldPos& pos : list)
-                {
-                    if (itemAt(pos)->isRevealed())
-                        updateTrivials(pos.first, pos.second);
-                }
-            }
+            queueTrivials(pos.first, pos.second);
         }
     }
 
     if (flagged.size() + undecided.size() == centerItem->digit())
     {
-        for (const FieldPos& pos : undecided)
+        for (const FieldPos& pos : std::as_const(undecided))
         {
             // first is row, second is col
             CellItem *item = itemAt(pos);
 
-            std::cout << "flagging ";
-            printCellShit(pos.first, pos.second);
-
             bool wasFlagged = item->isFlagged();
 
-
             item->triviallyFlag();
+            cellChanged(pos.first, pos.second);
             if (!wasFlagged)
             {
                 m_flaggedMinesCount++;
                 Q_EMIT flaggedMinesCountChanged(m_flaggedMinesCount);
             }
-
-            const QList<FieldPos> list = adjacentRowColsFor(pos.first,pos.second);
-            for (const FieldPos& pos : list)
-            {
-                if (itemAt(pos)->isRevealed())
-                    updateTrivials(pos.first, pos.second);
-            }
+            queueTrivials(pos.first, pos.second);
         }
     }
 }
-
-
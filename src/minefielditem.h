@@ -10,19 +10,39 @@
 #define MINEFIELDITEM_H
 
 // Qt
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QElapsedTimer>
 #include <QVector>
 #include <QGraphicsObject>
 #include <QPair>
+#include <QScopedPointer>
+#include <QThreadPool>
+#include <QTimer>
+// own
+#include "boardcode.h"
+#include "boardmask.h"
+#include "boardmetrics.h"
+#include "boardrating.h"
+#include "boardtopology.h"
+#include "boardview.h"
+#include "cellitem.h"
+#include "fieldgenerator.h"
+#include "gamerecord.h"
+#include "lazyfield.h"
 
-class KGameRenderer;
-class CellItem;
+class AnalysisService;
+class SpriteAtlas;
 class BorderItem;
+class BoardSnapshot;
+struct PerfCounters;
 
 typedef QPair<int,int> FieldPos;
 
 /**
  * Graphics item that represents MineField.
- * It is composed of many (or little) of CellItems.
+ * It holds the state of all cells and paints the exposed ones itself,
+ * there are no graphics items per cell.
  * This class is responsible of generation game field
  * with given properties (num rows, num cols, num mines) and
  * handling resizes
@@ -33,8 +53,12 @@ class MineFieldItem : public QGraphicsObject
 public:
     /**
      * Constructor.
+     *
+     * @param atlas source of cell and border pixmaps
+     * @param counters timing counters this item should update
      */
-    explicit MineFieldItem(KGameRenderer* renderer);
+    MineFieldItem(SpriteAtlas* atlas, PerfCounters* counters);
+    ~MineFieldItem() override;
     /**
      * Initializes game field: creates items, places them on positions,
      * (re)sets some variables
@@ -44,10 +68,37 @@ public:
      * @param numMines number of mines
      */
     void initField( int numRows, int numCols, int numMines );
+    /**
+     * Initializes game field with the board described by code.
+     * If the code knows the first click, that cell is revealed right away,
+     * the game still starts with the player's first click.
+     */
+    void initField( const BoardCode& code );
     /**
      * Resets mines to the initial state.
      */
     void resetMines();
+    /**
+     * Sets whether this field publishes its state via BoardSnapshot when
+     * enabled in settings. Only one field per process may do so.
+     */
+    void setSnapshotPublisher(bool publisher);
+    /**
+     * Sets range of BoardRating::level() generated boards should be in,
+     * takes effect with next game. Boards outside are only played when
+     * none in the range turns up quickly
+     */
+    void setRatingBand(int minLevel, int maxLevel);
+    /**
+     * Sets shape of the board, takes effect with next initField().
+     * Boards loaded from a code are always square
+     */
+    void setTopology(BoardTopology::Kind kind);
+    /**
+     * Sets outline of the board, takes effect with next initField() of
+     * the same size as the mask. Shaped boards are always square
+     */
+    void setMask(const BoardMask& mask);
     /**
      * Resizes this graphics item so it fits in given rect
      */
@@ -68,11 +119,38 @@ public:
      * @return num mines in field
      */
     int minesCount() const;
+    /**
+     * @return metrics of the current field, valid after first click
+     */
+    BoardMetrics metrics() const;
+    /**
+     * @return number of effective clicks made in current game
+     */
+    int clickCount() const;
+    /**
+     * @return code of the current board, invalid until the field is generated
+     */
+    BoardCode boardCode() const;
+    /**
+     * @return rating of the current board, invalid until the field is generated
+     */
+    BoardRating rating() const;
+    /**
+     * Highlights the covered cell the player should open next.
+     * Analysis of the board runs in the background after every move,
+     * returns false if it isn't finished yet.
+     */
+    bool showHint();
+    /**
+     * @return latest version of the board as seen by the player,
+     * may be called from any thread
+     */
+    BoardView boardView() const;
 
     /**
      * Minimal number of free positions on a field
      */
-    static const int MINIMAL_FREE = 10;
+    static const int MINIMAL_FREE = FieldGenerator::MINIMAL_FREE;
 
 Q_SIGNALS:
     void flaggedMinesCountChanged(int);
@@ -90,7 +168,7 @@ private:
      * Returns cell item at (row,col).
      * Always use this function instead hand-computing index in m_cells
      */
-    inline CellItem* itemAt(int row, int col) { return m_cells.at( row*m_numCols + col ); }
+    inline CellItem* itemAt(int row, int col) { return m_cells.data() + row*m_numCols + col; }
     /**
      * Overloaded one, which takes QPair
      */
@@ -103,13 +181,62 @@ private:
             int row = idx/m_numCols;
             return qMakePair(row, idx - row*m_numCols);
         }
+    /**
+     * @return (row,col) of the cell shown at pos in item coordinates,
+     * (-1,-1) if there is none
+     */
+    FieldPos cellAt(const QPointF& pos) const;
+    /**
+     * @return number of columns of cells the board takes on screen
+     */
+    int layoutColumnCount() const;
     /**
      * Generates game field ensuring that cell at clickedIdx
      * will be empty to allow the player quickly jump into the game.
+     * Boards of the corpus are taken at once, others are generated and
+     * rated on a worker thread. Either way the first click is finished
+     * by revealFirstClick() once the field is there.
      *
      * @param clickedIdx specifies index which should NOT have mine and be empty
      */
     void generateField(int clickedIdx);
+    /**
+     * Starts recording and the game, and reveals the cell clicked first
+     */
+    void revealFirstClick(int clickedIdx);
+    /**
+     * Puts mines and digits of field into cell items
+     */
+    void applyField(const QVector<qint8>& field);
+    /**
+     * @return mines and digits of the cell items, as FieldGenerator makes them
+     */
+    QVector<qint8> currentField() const;
+    /**
+     * Decides whether the cell at idx holds a mine before the player
+     * reveals it, if mines are placed lazily. Only cells revealed by a
+     * single click may be guesses, chords trust the player's flags
+     */
+    void commitCell(int idx, bool mayGuess);
+    /**
+     * @return true if the analysis of the current position
+     * knows no covered cell free of mines. If the background analysis
+     * isn't done, only what propagation alone proves is known
+     */
+    bool guessForced() const;
+    /**
+     * Starts recording the game if enabled in settings, once the
+     * field exists. Moves made before are kept in the record,
+     * only games with a board code can be replayed
+     */
+    void startRecording();
+    /**
+     * Appends a click of the player to the record, if any, and
+     * saves the record once the game is over
+     *
+     * @param unrevealedBefore, flaggedBefore counters before the click
+     */
+    void recordMove(GameRecord::MoveKind kind, int row, int col, int unrevealedBefore, int flaggedBefore);
     /**
      * Returns all adjacent items for item at row, col
      */
@@ -136,7 +263,15 @@ private:
      */
     void paint( QPainter * painter, const QStyleOptionGraphicsItem*, QWidget * widget = nullptr ) override;
     /**
-     * Repositions all child cell items upon resizes
+     * @return rectangle of cell at (row,col) in item coordinates
+     */
+    QRectF cellRect(int row, int col) const;
+    /**
+     * Schedules repaint of a cell whose state changed
+     */
+    void updateCell(const CellItem* item);
+    /**
+     * Repositions border items upon resizes
      */
     void adjustItemPositions();
     /**
@@ -145,9 +280,36 @@ private:
      */
     void revealEmptySpace(int row, int col);
     /**
-     * Sets up border items (positions and properties)
+     * Queues revealed digit cells at and around (row,col)
+     * for updateTrivials()
+     */
+    void queueTrivials(int row, int col);
+    /**
+     * Reveals or trivially flags neighbours of cell at (row,col)
+     * if its digit decides them
+     */
+    void updateTrivials(int row, int col);
+    /**
+     * Sets up border items (positions and properties),
+     * following the outline of the cells
      */
     void setupBorderItems();
+    /**
+     * Reveals cells left out of shaped boards, so that they never
+     * count as covered. They are not painted
+     */
+    void hideInactiveCells();
+    /**
+     * Moves pressed cells to the latest pointer position seen
+     * by mouseMoveEvent. Only cells which enter or leave the
+     * pressed area are updated
+     */
+    void applyPendingMove();
+    /**
+     * Applies pending move, if any, so that pressed cells
+     * match the last known pointer position
+     */
+    void flushPendingMove();
 
     /**
      * Return `true` if the game is finished (and possibly restarted) after the call.
@@ -155,14 +317,46 @@ private:
     bool onItemRevealed(int row, int col);
     // overload
     bool onItemRevealed(CellItem* item);
+    /**
+     * Must be called whenever visible state of cell at (row,col) changes
+     */
+    void cellChanged(int row, int col);
+    // overload
+    void cellChanged(CellItem* item);
+    /**
+     * Publishes a new version of the board once an action is complete
+     */
+    void publishBoard();
+    /**
+     * Writes state of cell at (row,col) to the snapshot, if any
+     */
+    void publishCell(int row, int col);
+    /**
+     * Starts showing cells revealed by the last cascade, as
+     * a wave starting at (row,col) if animations are enabled
+     */
+    void startVisualUpdates(int row, int col);
+    /**
+     * Shows the next part of the cells revealed by the last cascade,
+     * spending at most a few milliseconds
+     */
+    void updateVisuals();
+    /**
+     * Immediately shows all cells waiting for updateVisuals()
+     */
+    void flushVisualUpdates();
+    /**
+     * Forgets cells waiting for updateVisuals()
+     */
+    void clearVisualUpdates();
 
     // note: in member functions use itemAt (see above )
     // instead of hand-computing index from row & col!
     // => not depend on how m_cells is represented
     /**
-     * Array which holds all child cell items
+     * State of all cells, one byte per cell
      */
-    QVector<CellItem*> m_cells;
+    QVector<CellItem> m_cells;
     /**
      * Array which holds border items
      */
@@ -179,6 +373,12 @@ private:
      * Number of field columns
      */
     int m_numCols;
+    /**
+     * Neighbours and layout of the cells, built by initField()
+     */
+    BoardTopology m_topology;
+    BoardTopology::Kind m_topologyKind = BoardTopology::Square;
+    BoardMask m_mask;
     /**
      * Number of mines in field
      */
@@ -193,15 +393,104 @@ private:
      */
     FieldPos m_leftButtonPos;
     FieldPos m_midButtonPos;
+    /**
+     * Latest pointer position and buttons received while moves are
+     * throttled. Pointers may report moves much more often than the
+     * screen refreshes, so at most one move per frame is applied
+     */
+    FieldPos m_pendingMovePos;
+    bool m_pendingMoveMidButton = false;
+    bool m_pendingMoveLeftButton = false;
+    bool m_movePending = false;
+    QTimer m_moveThrottleTimer;
     bool m_firstClick;
+    /**
+     * Set while the field is generated after the first click, input waits for it
+     */
+    bool m_generating = false;
+    /**
+     * Incremented for every new game, workers give up as soon
+     * as it doesn't match the value they started with
+     */
+    QAtomicInt m_generation;
+    QThreadPool m_generationPool;
     bool m_gameOver;
     bool m_emulatingMidButton;
     int m_numUnrevealed;
+    /**
+     * Metrics computed when the field is generated
+     */
+    BoardMetrics m_metrics;
+    BoardRating m_rating;
+    int m_minRating = 0;
+    int m_maxRating = BoardRating::LevelCount - 1;
+    /**
+     * Mines of the current game if they are placed lazily, invalid otherwise
+     */
+    LazyField m_lazy;
+    bool m_lazyMines = false;
+    /**
+     * Code of the current board, set when the field is generated
+     * or when the game was loaded from a code
+     */
+    BoardCode m_boardCode;
+    /**
+     * Clicks of the current game, invalid unless recording
+     */
+    GameRecord m_record;
+    QElapsedTimer m_recordClock;
+    /**
+     * Left, right and chord clicks made by player, used
+     * to compute input efficiency
+     */
+    int m_clickCount = 0;
 
-    KGameRenderer* m_renderer;
+    SpriteAtlas* m_atlas;
+    PerfCounters* m_perf;
+    /**
+     * Shared memory view of the board for external readers,
+     * null unless enabled in settings
+     */
+    QScopedPointer<BoardSnapshot> m_snapshot;
+    bool m_snapshotPublisher = true;
+    /**
+     * Versions of the board for readers on other threads, every changed
+     * cell goes to the working copy and each action publishes it
+     */
+    BoardPublisher m_board;
+    /**
+     * Background analysis of the published versions
+     */
+    AnalysisService* m_analysis;
+    /**
+     * Index of the cell currently shown as hint, -1 if none
+     */
+    int m_hintIdx = -1;
 
-    void updateTrivials(int row, int col);
-    void printCellShit(int row, int col);
+    /**
+     * Revealed digit cells whose neighbours may be decided now
+     */
+    QVector<int> m_trivialQueue;
+    /**
+     * Set while a cascade reveals cells. The game state is updated at
+     * once but revealed cells are only shown by updateVisuals(),
+     * a few at a time, so that a huge opening doesn't freeze the UI
+     */
+    bool m_cascading = false;
+    /**
+     * Cells revealed by a cascade and not shown yet, with their
+     * distance from the click when the wave animation is enabled
+     */
+    QVector<int> m_visualQueue;
+    QVector<int> m_visualLayers;
+    int m_visualHead = 0;
+    /**
+     * Bit set for each cell in m_visualQueue, such cells are painted covered
+     */
+    QBitArray m_visualPending;
+    QTimer m_visualTimer;
+    int m_waveDistance = 0;
+    int m_waveStep = 1;
 };
 
 #endif
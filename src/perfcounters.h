@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+// Qt
+#include <QElapsedTimer>
+
+/**
+ * Lightweight timing counters filled by the field and the view,
+ * displayed by PerfHudItem. Updating them costs a couple of
+ * clock reads per action, so they are always enabled.
+ * All durations are in nanoseconds.
+ */
+struct PerfCounters
+{
+    PerfCounters() { clock.start(); }
+
+    /**
+     * Called when player input starts a new action
+     */
+    void beginAction()
+    {
+        inputTimestamp = clock.nsecsElapsed();
+        cellsTouched = 0;
+    }
+
+    /**
+     * Called by the view after a frame was painted
+     */
+    void framePainted(qint64 paintStart)
+    {
+        const qint64 now = clock.nsecsElapsed();
+        frameTime = now - paintStart;
+        frameInterval = now - lastFrameEnd;
+        lastFrameEnd = now;
+        if(inputTimestamp >= 0)
+        {
+            inputLatency = now - inputTimestamp;
+            inputTimestamp = -1;
+        }
+    }
+
+    /**
+     * Stores time spent in its scope into given counter
+     */
+    class Timer
+    {
+    public:
+        explicit Timer(qint64* counter) : m_counter(counter) { m_timer.start(); }
+        ~Timer() { *m_counter = m_timer.nsecsElapsed(); }
+    private:
+        Q_DISABLE_COPY(Timer)
+        qint64* m_counter;
+        QElapsedTimer m_timer;
+    };
+
+    QElapsedTimer clock;
+    qint64 frameTime = 0;
+    qint64 frameInterval = 0;
+    qint64 lastFrameEnd = 0;
+    qint64 inputLatency = 0;
+    /**
+     * Timestamp of the last input not yet painted, -1 if none
+     */
+    qint64 inputTimestamp = -1;
+    qint64 generationTime = 0;
+    qint64 revealTime = 0;
+    qint64 propagationTime = 0;
+    /**
+     * Number of cells whose state changed during the last action
+     */
+    int cellsTouched = 0;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "perfhuditem.h"
+
+// own
+#include "perfcounters.h"
+#include "scene.h"
+// KF
+#include <KLocalizedString>
+// Qt
+#include <QFontDatabase>
+#include <QFontMetricsF>
+#include <QPainter>
+
+static QString formatTime(qint64 nsecs)
+{
+    return i18nc("duration in milliseconds", "%1 ms", QString::number(nsecs / 1000000.0, 'f', 2));
+}
+
+PerfHudItem::PerfHudItem(const PerfCounters* counters, const KMinesScene* scene)
+    : m_counters(counters), m_scene(scene)
+{
+    setZValue(1000);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setVisible(false);
+    m_refreshTimer.setInterval(250);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &PerfHudItem::refresh);
+}
+
+void PerfHudItem::setHudVisible(bool visible)
+{
+    setVisible(visible);
+    if(visible)
+    {
+        refresh();
+        m_refreshTimer.start();
+    }
+    else
+        m_refreshTimer.stop();
+}
+
+QRectF PerfHudItem::boundingRect() const
+{
+    return m_rect;
+}
+
+void PerfHudItem::refresh()
+{
+    m_lines = QStringList {
+        i18n("Frame: %1 (every %2)", formatTime(m_counters->frameTime), formatTime(m_counters->frameInterval)),
+        i18n("Input to repaint: %1", formatTime(m_counters->inputLatency)),
+        i18n("Generation: %1", formatTime(m_counters->generationTime)),
+        i18n("Reveal: %1", formatTime(m_counters->revealTime)),
+        i18n("Propagation: %1", formatTime(m_counters->propagationTime)),
+        i18n("Cells touched: %1", m_counters->cellsTouched),
+        i18n("Scene items: %1", m_scene->items().size()),
+        i18n("Pixmaps: %1 KiB", m_scene->pixmapMemory() / 1024)
+    };
+
+    const QFontMetricsF metrics(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    qreal width = 0;
+    for (const QString& line : std::as_const(m_lines))
+        width = qMax(width, metrics.horizontalAdvance(line));
+
+    prepareGeometryChange();
+    m_rect = QRectF(0, 0, width + 2*metrics.height(), (m_lines.size() + 1)*metrics.height());
+    update();
+}
+
+void PerfHudItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* opt, QWidget* widget)
+{
+    Q_UNUSED(opt);
+    Q_UNUSED(widget);
+
+    const QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    const qreal lineHeight = QFontMetricsF(font).height();
+
+    painter->fillRect(m_rect, QColor(0, 0, 0, 180));
+    painter->setPen(Qt::white);
+    painter->setFont(font);
+    qreal y = lineHeight*1.5;
+    for (const QString& line : std::as_const(m_lines))
+    {
+        painter->drawText(QPointF(lineHeight, y), line);
+        y += lineHeight;
+    }
+}
@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PERFHUDITEM_H
+#define PERFHUDITEM_H
+
+// Qt
+#include <QGraphicsObject>
+#include <QTimer>
+
+struct PerfCounters;
+class KMinesScene;
+
+/**
+ * Overlay showing where the time goes: frame times, input latency,
+ * duration of the last field operations and pixmap memory
+ */
+class PerfHudItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    PerfHudItem(const PerfCounters* counters, const KMinesScene* scene);
+    /**
+     * Shows or hides overlay, counters are only sampled while shown
+     */
+    void setHudVisible(bool visible);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget* widget = nullptr) override;
+private Q_SLOTS:
+    void refresh();
+private:
+    const PerfCounters* m_counters;
+    const KMinesScene* m_scene;
+    QTimer m_refreshTimer;
+    QStringList m_lines;
+    QRectF m_rect;
+};
+
+#endif
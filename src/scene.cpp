@@ -9,13 +9,23 @@
 
 // own
 #include "settings.h"
+#include "backgroundrenderer.h"
+#include "infinitefielditem.h"
 #include "minefielditem.h"
+#include "perfhuditem.h"
+#include "startupprofiler.h"
 // KDEGames
+#include <KGameClock>
 #include <KGamePopupItem>
 #include <KgThemeProvider>
 // KF
 #include <KLocalizedString>
 // Qt
+#include <QCoreApplication>
+#include <QGraphicsSimpleTextItem>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtMath>
 #include <QResizeEvent>
 
 // --------------- KMinesView ---------------
@@ -30,27 +40,63 @@ void KMinesView::resizeEvent( QResizeEvent *ev )
     m_scene->resizeScene( ev->size().width(), ev->size().height() );
 }
 
+void KMinesView::paintEvent( QPaintEvent *ev )
+{
+    PerfCounters& counters = m_scene->perfCounters();
+    const qint64 paintStart = counters.clock.nsecsElapsed();
+    QGraphicsView::paintEvent(ev);
+    counters.framePainted(paintStart);
+
+    StartupProfiler::framePainted();
+    if(!m_firstFramePainted)
+    {
+        m_firstFramePainted = true;
+        Q_EMIT firstFramePainted();
+    }
+}
+
 // -------------- KMinesScene --------------------
 
 static KgThemeProvider* provider()
 {
     KgThemeProvider* prov = new KgThemeProvider;
     prov->discoverThemes("appdata", QStringLiteral("themes"));
+    StartupProfiler::mark(QStringLiteral("themes discovered"));
     
     return prov;
 }
 
+/**
+ * All boards of all windows share one renderer and one atlas,
+ * so that each sprite is rendered and kept in memory only once
+ */
+static KGameRenderer* sharedRenderer()
+{
+    static KGameRenderer* renderer = nullptr;
+    if(!renderer)
+    {
+        renderer = new KGameRenderer(provider());
+        renderer->setParent(QCoreApplication::instance());
+    }
+    return renderer;
+}
+
+static SpriteAtlas* sharedSpriteAtlas()
+{
+    static SpriteAtlas* atlas = nullptr;
+    if(!atlas)
+        atlas = new SpriteAtlas(sharedRenderer(), sharedRenderer());
+    return atlas;
+}
+
+// space between boards when several are shown
+static const int BOARD_SPACING = 8;
+
 KMinesScene::KMinesScene( QObject* parent )
-    : QGraphicsScene(parent), m_renderer(provider())
+    : QGraphicsScene(parent), m_renderer(sharedRenderer()), m_spriteAtlas(sharedSpriteAtlas())
 {
     setItemIndexMethod( NoIndex );
-    m_fieldItem = new MineFieldItem(&m_renderer);
-    connect(m_fieldItem, &MineFieldItem::flaggedMinesCountChanged, this, &KMinesScene::minesCountChanged);
-    connect(m_fieldItem, &MineFieldItem::firstClickDone, this, &KMinesScene::firstClickDone);
-    connect(m_fieldItem, &MineFieldItem::gameOver, this, &KMinesScene::onGameOver);
-    // and re-emit it for others
-    connect(m_fieldItem, &MineFieldItem::gameOver, this, &KMinesScene::gameOver);
-    addItem(m_fieldItem);
+    updateBoards();
 
     m_messageItem = new KGamePopupItem;
     m_messageItem->setMessageOpacity(0.9);
@@ -62,13 +108,185 @@ KMinesScene::KMinesScene( QObject* parent )
     m_gamePausedMessageItem->setMessageTimeout(0);
     m_gamePausedMessageItem->setHideOnMouseClick(false);
     addItem(m_gamePausedMessageItem);
-    
-    setBackgroundBrush(m_renderer.spritePixmap(QStringLiteral( "mainWidget" ), sceneRect().size().toSize()));
+
+    m_perfHudItem = new PerfHudItem(&m_perfCounters, this);
+    addItem(m_perfHudItem);
+
+    m_background = new BackgroundRenderer(m_renderer, this);
+    connect(m_background, &BackgroundRenderer::pixmapChanged, this, &KMinesScene::onBackgroundChanged);
+    StartupProfiler::mark(QStringLiteral("scene created"));
+}
+
+void KMinesScene::updateBoards()
+{
+    while(m_boards.size() > m_boardCount)
+    {
+        Board board = m_boards.takeLast();
+        delete board.field;
+        delete board.clockItem;
+        delete board.clock;
+    }
+
+    while(m_boards.size() < m_boardCount)
+    {
+        const int index = m_boards.size();
+        Board board;
+        board.field = new MineFieldItem(m_spriteAtlas, &m_perfCounters);
+        // there is only one shared memory segment per process
+        board.field->setSnapshotPublisher(index == 0);
+        connect(board.field, &MineFieldItem::flaggedMinesCountChanged, this,
+                [this, index](int count) { onBoardFlaggedMinesCountChanged(index, count); });
+        connect(board.field, &MineFieldItem::firstClickDone, this,
+                [this, index]() { onBoardFirstClickDone(index); });
+        connect(board.field, &MineFieldItem::gameOver, this,
+                [this, index](bool won) { onBoardGameOver(index, won); });
+        addItem(board.field);
+
+        board.clock = new KGameClock(this, KGameClock::MinSecOnly);
+        board.clockItem = new QGraphicsSimpleTextItem;
+        addItem(board.clockItem);
+        connect(board.clock, &KGameClock::timeChanged, board.clockItem, &QGraphicsSimpleTextItem::setText);
+        m_boards.append(board);
+    }
+
+    for(Board& board : m_boards)
+    {
+        board.clockItem->setVisible(m_boardCount > 1);
+        resetBoardClock(board);
+    }
+}
+
+void KMinesScene::resetBoardClock(Board& board)
+{
+    board.clock->restart();
+    board.clock->pause();
+    board.clockItem->setText(board.clock->timeString());
+    board.flaggedMines = 0;
+    board.running = false;
+    board.over = false;
+}
+
+void KMinesScene::onBoardFlaggedMinesCountChanged(int board, int count)
+{
+    m_boards[board].flaggedMines = count;
+    int total = 0;
+    for(const Board& b : qAsConst(m_boards))
+        total += b.flaggedMines;
+    Q_EMIT minesCountChanged(total);
+}
+
+void KMinesScene::onBoardFirstClickDone(int board)
+{
+    bool anyStarted = false;
+    for(const Board& b : qAsConst(m_boards))
+        anyStarted = anyStarted || b.running || b.over;
+
+    Board& b = m_boards[board];
+    b.running = true;
+    b.clock->resume();
+    if(!anyStarted)
+        Q_EMIT firstClickDone();
+
+    // fields are generated with their first click
+    for(const Board& other : qAsConst(m_boards))
+        if(!other.running && !other.over)
+            return;
+    Q_EMIT metricsReady();
+}
+
+void KMinesScene::onBoardGameOver(int board, bool won)
+{
+    Board& b = m_boards[board];
+    b.clock->pause();
+    b.running = false;
+    b.over = true;
+    m_allWon = m_allWon && won;
+
+    for(const Board& other : qAsConst(m_boards))
+        if(!other.over)
+            return;
+
+    showGameOverMessage(m_allWon);
+    Q_EMIT gameOver(m_allWon);
+}
+
+void KMinesScene::showGameOverMessage(bool won)
+{
+    if(won)
+        m_messageItem->showMessage(i18n("Congratulations! You have won!"), KGamePopupItem::Center);
+    else
+        m_messageItem->showMessage(i18n("You have lost."), KGamePopupItem::Center);
+}
+
+void KMinesScene::setEndless(bool endless)
+{
+    m_endless = endless;
+    if(endless && !m_infiniteItem)
+    {
+        m_infiniteItem = new InfiniteFieldItem(m_spriteAtlas, &m_perfCounters);
+        connect(m_infiniteItem, &InfiniteFieldItem::flaggedMinesCountChanged, this, &KMinesScene::minesCountChanged);
+        connect(m_infiniteItem, &InfiniteFieldItem::firstClickDone, this, &KMinesScene::firstClickDone);
+        connect(m_infiniteItem, &InfiniteFieldItem::gameOver, this, [this](bool won) {
+            showGameOverMessage(won);
+            Q_EMIT gameOver(won);
+        });
+        addItem(m_infiniteItem);
+        // below popup messages
+        m_infiniteItem->setZValue(-1);
+    }
+    if(m_infiniteItem)
+        m_infiniteItem->setVisible(endless);
+    for(const Board& board : qAsConst(m_boards))
+    {
+        board.field->setVisible(!endless);
+        board.clockItem->setVisible(!endless && m_boards.size() > 1);
+    }
+}
+
+void KMinesScene::onBackgroundChanged()
+{
+    StartupProfiler::mark(QStringLiteral("background rendered"));
+    invalidate(sceneRect(), BackgroundLayer);
+}
+
+void KMinesScene::drawBackground(QPainter* painter, const QRectF& rect)
+{
+    const QPixmap background = m_background->pixmap();
+    if(background.isNull())
+    {
+        // cheap placeholder until the themed background is ready
+        painter->fillRect(rect, palette().window());
+        return;
+    }
+
+    // only the exposed part is scaled, the old pixmap is stretched
+    // while the background for a new size is being rendered
+    const QRectF scene = sceneRect();
+    const qreal scaleX = background.width() / scene.width();
+    const qreal scaleY = background.height() / scene.height();
+    const QRectF source((rect.x() - scene.x())*scaleX, (rect.y() - scene.y())*scaleY,
+                        rect.width()*scaleX, rect.height()*scaleY);
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawPixmap(rect, background, source);
+    painter->restore();
+}
+
+qint64 KMinesScene::pixmapMemory() const
+{
+    return m_spriteAtlas->memoryUsage() + m_background->memoryUsage();
 }
 
 void KMinesScene::reset()
 {
-    m_fieldItem->resetMines();
+    if(m_endless)
+        m_infiniteItem->restart();
+    for(Board& board : m_boards)
+    {
+        board.field->resetMines();
+        resetBoardClock(board);
+    }
+    m_allWon = true;
     m_messageItem->forceHide();
 }
 
@@ -82,49 +300,222 @@ void KMinesScene::setCanScore(bool value)
     m_canScore = value;
 }
 
+bool KMinesScene::isComparable() const
+{
+    return m_comparable;
+}
+
+void KMinesScene::setComparable(bool value)
+{
+    m_comparable = value;
+    m_canScore = value;
+}
+
+void KMinesScene::setPerfHudVisible(bool visible)
+{
+    m_perfHudItem->setHudVisible(visible);
+}
+
 void KMinesScene::resizeScene(int width, int height)
 {
     setSceneRect(0, 0, width, height);
-    setBackgroundBrush(m_renderer.spritePixmap(QStringLiteral( "mainWidget" ), sceneRect().size().toSize()));
-    m_fieldItem->resizeToFitInRect( sceneRect() );
-    m_fieldItem->setPos( sceneRect().width()/2 - m_fieldItem->boundingRect().width()/2,
-                         sceneRect().height()/2 - m_fieldItem->boundingRect().height()/2 );
+    if(!m_deferBackground)
+        m_background->setTargetSize(QSize(width, height));
+    layoutBoards();
+    if(m_infiniteItem)
+        m_infiniteItem->setViewRect(sceneRect());
     m_gamePausedMessageItem->setPos( sceneRect().width()/2 - m_gamePausedMessageItem->boundingRect().width()/2,
                           sceneRect().height()/2 - m_gamePausedMessageItem->boundingRect().height()/2 );
     m_messageItem->setPos( sceneRect().width()/2 - m_messageItem->boundingRect().width()/2,
                           sceneRect().height()/2 - m_messageItem->boundingRect().height()/2 );
 }
 
+void KMinesScene::layoutBoards()
+{
+    const int count = m_boards.size();
+    const int gridCols = qCeil(qSqrt(count));
+    const int gridRows = (count + gridCols - 1) / gridCols;
+    const qreal cellWidth = sceneRect().width() / gridCols;
+    const qreal cellHeight = sceneRect().height() / gridRows;
+    const qreal labelHeight = count > 1 ? m_boards.first().clockItem->boundingRect().height() : 0;
+
+    for(int i=0; i<count; ++i)
+    {
+        MineFieldItem* field = m_boards.at(i).field;
+        QGraphicsSimpleTextItem* clockItem = m_boards.at(i).clockItem;
+        QRectF cell((i % gridCols)*cellWidth, (i / gridCols)*cellHeight, cellWidth, cellHeight);
+        if(count > 1)
+            cell.adjust(BOARD_SPACING/2, BOARD_SPACING/2 + labelHeight, -BOARD_SPACING/2, -BOARD_SPACING/2);
+
+        field->resizeToFitInRect(cell);
+        const QRectF fieldRect = field->boundingRect();
+        field->setPos(cell.center().x() - fieldRect.width()/2,
+                      cell.center().y() - fieldRect.height()/2);
+        clockItem->setPos(field->pos().x() + fieldRect.width()/2 - clockItem->boundingRect().width()/2,
+                          field->pos().y() - labelHeight);
+    }
+}
+
+void KMinesScene::setBoardCount(int count)
+{
+    m_boardCount = qMax(1, count);
+}
+
+int KMinesScene::boardCount() const
+{
+    return m_boards.size();
+}
+
+void KMinesScene::setRatingBand(int minLevel, int maxLevel)
+{
+    m_minRating = minLevel;
+    m_maxRating = maxLevel;
+}
+
+void KMinesScene::setTopology(BoardTopology::Kind kind)
+{
+    m_topology = kind;
+}
+
+void KMinesScene::setMask(const BoardMask& mask)
+{
+    m_mask = mask;
+}
+
 void KMinesScene::startNewGame(int rows, int cols, int numMines)
 {
     // hide message if any
     m_messageItem->forceHide();
 
-    m_fieldItem->initField(rows, cols, numMines);
+    updateBoards();
+    setEndless(false);
+    m_allWon = true;
+    for(const Board& board : qAsConst(m_boards))
+    {
+        board.field->setRatingBand(m_minRating, m_maxRating);
+        board.field->setTopology(m_topology);
+        board.field->setMask(m_mask);
+        board.field->initField(rows, cols, numMines);
+    }
+    m_deferBackground = false;
     // reposition items
     resizeScene((int)sceneRect().width(), (int)sceneRect().height());
 }
 
+void KMinesScene::startNewGame(const BoardCode& code)
+{
+    m_messageItem->forceHide();
+
+    m_boardCount = 1;
+    m_mask = BoardMask();
+    updateBoards();
+    setEndless(false);
+    m_allWon = true;
+    m_boards.first().field->initField(code);
+    m_deferBackground = false;
+    resizeScene((int)sceneRect().width(), (int)sceneRect().height());
+}
+
+void KMinesScene::startEndlessGame()
+{
+    m_messageItem->forceHide();
+
+    setEndless(true);
+    m_infiniteItem->startGame(QRandomGenerator::global()->generate());
+    m_deferBackground = false;
+    resizeScene((int)sceneRect().width(), (int)sceneRect().height());
+}
+
+BoardCode KMinesScene::boardCode() const
+{
+    if(m_endless)
+        return BoardCode();
+    return m_boards.first().field->boardCode();
+}
+
+bool KMinesScene::showHint()
+{
+    if(m_endless)
+        return false;
+    for(const Board& board : qAsConst(m_boards))
+    {
+        if(board.over || !board.field->showHint())
+            continue;
+        // not even a reset makes the game comparable again
+        m_comparable = false;
+        m_canScore = false;
+        return true;
+    }
+    return false;
+}
+
 int KMinesScene::totalMines() const
 {
-    return m_fieldItem->minesCount();
+    // endless field has no known total
+    if(m_endless)
+        return 0;
+    int total = 0;
+    for(const Board& board : m_boards)
+        total += board.field->minesCount();
+    return total;
 }
 
-void KMinesScene::setGamePaused(bool paused)
+BoardMetrics KMinesScene::metrics() const
 {
-    m_fieldItem->setVisible(!paused);
-    if(paused)
-        m_gamePausedMessageItem->showMessage(i18n("Game is paused."), KGamePopupItem::Center);
-    else
-        m_gamePausedMessageItem->forceHide();
+    BoardMetrics total;
+    if(m_endless)
+        return total;
+    for(const Board& board : m_boards)
+    {
+        const BoardMetrics metrics = board.field->metrics();
+        total.bbbv += metrics.bbbv;
+        total.openings += metrics.openings;
+        total.isolatedDigits += metrics.isolatedDigits;
+    }
+    return total;
 }
 
-void KMinesScene::onGameOver(bool won)
+BoardRating KMinesScene::rating() const
 {
-    if(won)
-        m_messageItem->showMessage(i18n("Congratulations! You have won!"), KGamePopupItem::Center);
-    else
-        m_messageItem->showMessage(i18n("You have lost."), KGamePopupItem::Center);
+    BoardRating hardest;
+    if(m_endless)
+        return hardest;
+    for(const Board& board : m_boards)
+    {
+        const BoardRating rating = board.field->rating();
+        if(!hardest.isValid() || (rating.isValid() && rating.level() > hardest.level()))
+            hardest = rating;
+    }
+    return hardest;
 }
 
+int KMinesScene::clickCount() const
+{
+    if(m_endless)
+        return 0;
+    int total = 0;
+    for(const Board& board : m_boards)
+        total += board.field->clickCount();
+    return total;
+}
 
+void KMinesScene::setGamePaused(bool paused)
+{
+    if(m_infiniteItem)
+        m_infiniteItem->setVisible(!paused && m_endless);
+    for(const Board& board : qAsConst(m_boards))
+    {
+        board.field->setVisible(!paused && !m_endless);
+        board.clockItem->setVisible(!paused && !m_endless && m_boards.size() > 1);
+        if(!board.running)
+            continue;
+        if(paused)
+            board.clock->pause();
+        else
+            board.clock->resume();
+    }
+    if(paused)
+        m_gamePausedMessageItem->showMessage(i18n("Game is paused."), KGamePopupItem::Center);
+    else
+        m_gamePausedMessageItem->forceHide();
+}
@@ -8,14 +8,28 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+// own
+#include "boardcode.h"
+#include "boardmask.h"
+#include "boardmetrics.h"
+#include "boardrating.h"
+#include "boardtopology.h"
+#include "perfcounters.h"
+#include "spriteatlas.h"
 // KDEGames
 #include <KGameRenderer>
 // Qt
 #include <QGraphicsView>
 #include <QGraphicsScene>
+#include <QVector>
 
+class InfiniteFieldItem;
 class MineFieldItem;
+class KGameClock;
 class KGamePopupItem;
+class QGraphicsSimpleTextItem;
+class PerfHudItem;
+class BackgroundRenderer;
 
 /**
  * Graphics scene for KMines game
@@ -33,15 +47,66 @@ public:
      */
     void resizeScene(int width, int height);
     /**
-     * @return total number of mines in field
+     * @return total number of mines in all fields
      */
     int totalMines() const;
     /**
-     * Starts new game
+     * @return metrics of the current fields summed up, valid after first click
+     */
+    BoardMetrics metrics() const;
+    /**
+     * @return rating of the hardest current field, invalid until first click
+     */
+    BoardRating rating() const;
+    /**
+     * @return number of clicks made by player in current game
+     */
+    int clickCount() const;
+    /**
+     * Sets number of boards played side by side, takes effect with next game
+     */
+    void setBoardCount(int count);
+    int boardCount() const;
+    /**
+     * Sets range of BoardRating::level() new boards should be in
+     */
+    void setRatingBand(int minLevel, int maxLevel);
+    /**
+     * Sets shape of new boards, takes effect with next game
+     */
+    void setTopology(BoardTopology::Kind kind);
+    /**
+     * Sets outline of new boards, an invalid mask for rectangular
+     * boards. Takes effect with next game
+     */
+    void setMask(const BoardMask& mask);
+    const BoardMask& mask() const { return m_mask; }
+    /**
+     * Starts new game on all boards
      */
     void startNewGame(int rows, int cols, int numMines);
     /**
-     * Toggles paused state for all cells in the field item
+     * Starts new single board game on the board described by code
+     */
+    void startNewGame(const BoardCode& code);
+    /**
+     * Starts new game on an endless field
+     */
+    void startEndlessGame();
+    bool isEndless() const { return m_endless; }
+    /**
+     * @return code of the first board, invalid until its field is generated
+     */
+    BoardCode boardCode() const;
+    /**
+     * Highlights the next safe move on the first unfinished board.
+     * Games using hints don't enter highscores.
+     *
+     * @return false if no hint is available yet
+     */
+    bool showHint();
+    /**
+     * Toggles paused state for all cells in the field items
      */
     void setGamePaused(bool paused);
     /**
@@ -49,28 +114,129 @@ public:
      */
     void reset();
 
-    KGameRenderer& renderer() {return m_renderer;}
+    /**
+     * Renderer shared by all scenes and boards of the application
+     */
+    KGameRenderer& renderer() {return *m_renderer;}
     /**
      * Represents if the scores should be considered for the highscores
      */
     bool canScore() const;
     void setCanScore(bool value);
+    /**
+     * Represents if the current game may be ranked at all, i.e. it is played
+     * on a board of its difficulty and without hints. Holds until the next
+     * game, scoring is enabled or disabled along with it
+     */
+    bool isComparable() const;
+    void setComparable(bool value);
+    /**
+     * Timing counters fed by the field and the view
+     */
+    PerfCounters& perfCounters() {return m_perfCounters;}
+    /**
+     * Shows or hides performance overlay
+     */
+    void setPerfHudVisible(bool visible);
+    /**
+     * @return approximate number of bytes used by pixmaps of this scene
+     */
+    qint64 pixmapMemory() const;
 
 Q_SIGNALS:
     void minesCountChanged(int);
+    /**
+     * Emitted when the game is over on all boards, won is true if all were won
+     */
     void gameOver(bool);
+    /**
+     * Emitted on the first click of the game on any board
+     */
     void firstClickDone();
+    /**
+     * Emitted once the fields of all boards are generated, from
+     * then on metrics() covers all of them
+     */
+    void metricsReady();
 private Q_SLOTS:
-    void onGameOver(bool);
+    /**
+     * Called when a new background pixmap was rendered
+     */
+    void onBackgroundChanged();
 private:
-    bool m_canScore;
-    KGameRenderer m_renderer;
     /**
-     * Game field graphics item
+     * A field together with its own clock. Each field generates, rates
+     * and analyses its board on worker threads of its own, so boards
+     * don't wait for each other; revealing cells changes graphics items
+     * and stays on the GUI thread
+     */
+    struct Board
+    {
+        MineFieldItem* field = nullptr;
+        KGameClock* clock = nullptr;
+        /**
+         * Shows board clock, only visible when several boards are played
+         */
+        QGraphicsSimpleTextItem* clockItem = nullptr;
+        int flaggedMines = 0;
+        bool running = false;
+        bool over = false;
+    };
+    /**
+     * Draws the exposed part of background pixmap stretched to scene rect
+     */
+    void drawBackground(QPainter* painter, const QRectF& rect) override;
+    /**
+     * Creates or deletes boards so that there are m_boardCount of them
+     */
+    void updateBoards();
+    /**
+     * Places boards in a grid filling the scene
+     */
+    void layoutBoards();
+    /**
+     * Switches between endless field and regular boards
+     */
+    void setEndless(bool endless);
+    void showGameOverMessage(bool won);
+    void onBoardFlaggedMinesCountChanged(int board, int count);
+    void onBoardFirstClickDone(int board);
+    void onBoardGameOver(int board, bool won);
+    void resetBoardClock(Board& board);
+
+    bool m_canScore = true;
+    bool m_comparable = true;
+    KGameRenderer* m_renderer;
+    SpriteAtlas* m_spriteAtlas;
+    PerfCounters m_perfCounters;
+    /**
+     * Game fields, one unless several boards are played side by side
+     */
+    QVector<Board> m_boards;
+    int m_boardCount = 1;
+    int m_minRating = 0;
+    int m_maxRating = BoardRating::LevelCount - 1;
+    BoardTopology::Kind m_topology = BoardTopology::Square;
+    BoardMask m_mask;
+    /**
+     * Game result so far, i.e. false as soon as any board is lost
      */
-    MineFieldItem* m_fieldItem = nullptr;
+    bool m_allWon = true;
+    /**
+     * Endless field, created when first needed
+     */
+    InfiniteFieldItem* m_infiniteItem = nullptr;
+    bool m_endless = false;
     KGamePopupItem* m_messageItem = nullptr;
     KGamePopupItem* m_gamePausedMessageItem = nullptr;
+    PerfHudItem* m_perfHudItem = nullptr;
+    BackgroundRenderer* m_background = nullptr;
+    /**
+     * A plain placeholder is shown instead of the themed background
+     * until the first game is started, so that the window appears
+     * without waiting for SVG rendering
+     */
+    bool m_deferBackground = true;
 };
 
 class QResizeEvent;
@@ -80,9 +246,16 @@ class KMinesView : public QGraphicsView
     Q_OBJECT
 public:
     KMinesView( KMinesScene* scene, QWidget *parent );
+Q_SIGNALS:
+    /**
+     * Emitted once, after the view was painted for the first time
+     */
+    void firstFramePainted();
 private:
     void resizeEvent( QResizeEvent *ev ) override;
+    void paintEvent( QPaintEvent *ev ) override;
 
     KMinesScene* m_scene = nullptr;
+    bool m_firstFramePainted = false;
 };
 #endif
@@ -0,0 +1,620 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "solver.h"
+
+// own
+#include "boardgeometry.h"
+// Std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// above this many convolution terms areas are weighted independently
+static const qint64 MAXIMAL_CONVOLUTION = 1 << 24;
+// search steps between two polls of the cancel check
+static const int CANCEL_CHECK_INTERVAL = 4096;
+
+namespace
+{
+
+enum Knowledge : qint8 { Unknown, Safe, Mine };
+
+/**
+ * Cells or constraints related to one cell, there are never more than
+ * its neighbours. Kept inline, so that building the constraints of a
+ * board doesn't allocate for every cell
+ */
+class NeighbourList
+{
+public:
+    void append(int value) { Q_ASSERT(m_size < BoardTopology::MAXIMAL_NEIGHBOURS); m_items[m_size++] = value; }
+    bool isEmpty() const { return m_size == 0; }
+    const int* begin() const { return m_items; }
+    const int* end() const { return m_items + m_size; }
+private:
+    int m_items[BoardTopology::MAXIMAL_NEIGHBOURS];
+    int m_size = 0;
+};
+
+/**
+ * Revealed digit with its covered neighbours
+ */
+struct Constraint
+{
+    NeighbourList cells;
+    int mines;
+};
+
+/**
+ * Connected part of the frontier, enumerated as a whole
+ */
+struct Area
+{
+    QVector<int> cells;
+    QVector<int> constraints;
+    /**
+     * Number of solutions by number of mines, and for each cell number
+     * of solutions where it holds a mine, cells.size()+1 values per cell
+     */
+    QVector<double> solutions;
+    QVector<double> cellMines;
+    bool enumerated = false;
+};
+
+class Analyser
+{
+public:
+    Analyser(int numMines, const QVector<qint8>& cells,
+             const Solver::CancelCheck& cancelled, int maximalSearchSteps)
+        : m_numMines(numMines), m_cells(cells), m_cancelled(cancelled),
+          m_maximalSearchSteps(maximalSearchSteps)
+    {
+    }
+
+    template<typename Geometry>
+    bool run(const Geometry& geometry, BoardAnalysis* result);
+
+private:
+    bool isCancelled();
+    template<typename Geometry>
+    void collectConstraints(const Geometry& geometry);
+    bool propagate();
+    void findAreas();
+    bool enumerate(Area* area);
+    bool search(int depth, int mines);
+    void combine(BoardAnalysis* result);
+
+    const int m_numMines;
+    const QVector<qint8>& m_cells;
+    const Solver::CancelCheck& m_cancelled;
+    const int m_maximalSearchSteps;
+    int m_steps = 0;
+    bool m_aborted = false;
+
+    QVector<qint8> m_knowledge;
+    QVector<Constraint> m_constraints;
+    /**
+     * Constraints of each covered cell next to a revealed one,
+     * index in m_frontierConstraints or -1
+     */
+    QVector<int> m_frontierIndex;
+    QVector<NeighbourList> m_frontierConstraints;
+    QVector<Area> m_areas;
+
+    // state of the running enumeration
+    Area* m_area = nullptr;
+    QVector<int> m_localIndex;
+    QVector<NeighbourList> m_cellChecks;
+    QVector<int> m_left;
+    QVector<int> m_unassigned;
+    /**
+     * Cells holding a mine in the current branch, as many as its mines
+     */
+    QVector<int> m_mined;
+};
+
+bool Analyser::isCancelled()
+{
+    if(!m_aborted && m_cancelled && m_cancelled())
+        m_aborted = true;
+    return m_aborted;
+}
+
+template<typename Geometry>
+void Analyser::collectConstraints(const Geometry& geometry)
+{
+    m_frontierIndex.fill(-1, m_cells.size());
+    for(int cellIdx=0; cellIdx<m_cells.size(); ++cellIdx)
+    {
+        const qint8 digit = m_cells.at(cellIdx);
+        if(digit < 0)
+            continue;
+
+        Constraint constraint;
+        constraint.mines = digit;
+        geometry.forNeighbours(cellIdx, [&](int other) {
+            if(m_cells.at(other) < 0)
+                constraint.cells.append(other);
+        });
+        if(constraint.cells.isEmpty())
+            continue;
+
+        const int constraintIdx = m_constraints.size();
+        for(int idx : std::as_const(constraint.cells))
+        {
+            if(m_frontierIndex.at(idx) == -1)
+            {
+                m_frontierIndex[idx] = m_frontierConstraints.size();
+                m_frontierConstraints.append(NeighbourList());
+            }
+            m_frontierConstraints[m_frontierIndex.at(idx)].append(constraintIdx);
+        }
+        m_constraints.append(constraint);
+    }
+}
+
+bool Analyser::propagate()
+{
+    // a constraint is revisited whenever one of its cells gets known
+    QVector<int> queue(m_constraints.size());
+    QVector<char> queued(m_constraints.size(), 1);
+    for(int i=0; i<queue.size(); ++i)
+        queue[i] = i;
+
+    while(!queue.isEmpty())
+    {
+        if(++m_steps % CANCEL_CHECK_INTERVAL == 0 && isCancelled())
+            return false;
+
+        const int constraintIdx = queue.takeLast();
+        queued[constraintIdx] = 0;
+        const Constraint& constraint = m_constraints.at(constraintIdx);
+
+        int unknown = 0;
+        int mines = 0;
+        for(int idx : constraint.cells)
+        {
+            if(m_knowledge.at(idx) == Unknown)
+                unknown++;
+            else if(m_knowledge.at(idx) == Mine)
+                mines++;
+        }
+        const int left = constraint.mines - mines;
+        if(unknown == 0 || (left != 0 && left != unknown))
+            continue;
+
+        const qint8 value = left == 0 ? Safe : Mine;
+        for(int idx : constraint.cells)
+        {
+            if(m_knowledge.at(idx) != Unknown)
+                continue;
+            m_knowledge[idx] = value;
+            for(int other : m_frontierConstraints.at(m_frontierIndex.at(idx)))
+                if(!queued.at(other))
+                {
+                    queued[other] = 1;
+                    queue.append(other);
+                }
+        }
+    }
+    return true;
+}
+
+void Analyser::findAreas()
+{
+    QVector<char> visitedConstraint(m_constraints.size(), 0);
+    QVector<char> visitedCell(m_frontierConstraints.size(), 0);
+
+    for(int start=0; start<m_constraints.size(); ++start)
+    {
+        if(visitedConstraint.at(start))
+            continue;
+
+        // breadth first over constraints sharing unknown cells
+        Area area;
+        area.constraints.append(start);
+        visitedConstraint[start] = 1;
+        for(int head=0; head<area.constraints.size(); ++head)
+        {
+            for(int idx : m_constraints.at(area.constraints.at(head)).cells)
+            {
+                const int frontierIdx = m_frontierIndex.at(idx);
+                if(m_knowledge.at(idx) != Unknown || visitedCell.at(frontierIdx))
+                    continue;
+                visitedCell[frontierIdx] = 1;
+                area.cells.append(idx);
+                for(int other : m_frontierConstraints.at(frontierIdx))
+                    if(!visitedConstraint.at(other))
+                    {
+                        visitedConstraint[other] = 1;
+                        area.constraints.append(other);
+                    }
+            }
+        }
+        if(!area.cells.isEmpty())
+            m_areas.append(area);
+    }
+}
+
+bool Analyser::search(int depth, int mines)
+{
+    if(++m_steps % CANCEL_CHECK_INTERVAL == 0 && isCancelled())
+        return false;
+    if(m_steps > m_maximalSearchSteps)
+        return false;
+
+    const int size = m_area->cells.size();
+    if(depth == size)
+    {
+        m_area->solutions[mines] += 1;
+        for(int i=0; i<mines; ++i)
+            m_area->cellMines[m_mined.at(i)*(size+1) + mines] += 1;
+        return true;
+    }
+
+    for(char value=0; value<=1; ++value)
+    {
+        // value fits if no constraint gets too many mines
+        // or too few cells left for its mines
+        bool fits = true;
+        for(int check : m_cellChecks.at(depth))
+        {
+            const int left = m_left.at(check) - value;
+            if(left < 0 || left > m_unassigned.at(check) - 1)
+            {
+                fits = false;
+                break;
+            }
+        }
+        if(!fits)
+            continue;
+
+        for(int check : m_cellChecks.at(depth))
+        {
+            m_left[check] -= value;
+            m_unassigned[check]--;
+        }
+        if(value)
+            m_mined[mines] = depth;
+        const bool finished = search(depth+1, mines + value);
+        for(int check : m_cellChecks.at(depth))
+        {
+            m_left[check] += value;
+            m_unassigned[check]++;
+        }
+        if(!finished)
+            return false;
+    }
+    return true;
+}
+
+bool Analyser::enumerate(Area* area)
+{
+    const int size = area->cells.size();
+    if(size > Solver::MAXIMAL_AREA_CELLS)
+        return true;
+
+    m_area = area;
+    for(int i=0; i<size; ++i)
+        m_localIndex[area->cells.at(i)] = i;
+
+    // constraints are numbered locally, mines already known are taken off
+    m_left.resize(area->constraints.size());
+    m_unassigned.resize(area->constraints.size());
+    m_cellChecks.fill(NeighbourList(), size);
+    for(int check=0; check<area->constraints.size(); ++check)
+    {
+        const Constraint& constraint = m_constraints.at(area->constraints.at(check));
+        m_left[check] = constraint.mines;
+        m_unassigned[check] = 0;
+        for(int idx : constraint.cells)
+        {
+            if(m_knowledge.at(idx) == Mine)
+                m_left[check]--;
+            else if(m_knowledge.at(idx) == Unknown)
+            {
+                m_unassigned[check]++;
+                m_cellChecks[m_localIndex.at(idx)].append(check);
+            }
+        }
+    }
+
+    area->solutions.fill(0, size+1);
+    area->cellMines.fill(0, size*(size+1));
+    m_mined.fill(0, size);
+    const int stepsBefore = m_steps;
+    m_steps = 0;
+    area->enumerated = search(0, 0);
+    m_steps += stepsBefore;
+    if(area->enumerated && std::all_of(area->solutions.cbegin(), area->solutions.cend(),
+                                       [](double count) { return count == 0; }))
+    {
+        // no consistent solution, nothing to learn from this area
+        area->enumerated = false;
+    }
+    if(!area->enumerated)
+    {
+        area->solutions.clear();
+        area->cellMines.clear();
+    }
+    return !m_aborted;
+}
+
+static QVector<double> convolve(const QVector<double>& a, const QVector<double>& b, int maximalSize)
+{
+    QVector<double> result(qMin(a.size() + b.size() - 1, maximalSize), 0.0);
+    for(int i=0; i<a.size(); ++i)
+    {
+        if(a.at(i) == 0)
+            continue;
+        for(int j=0; j<b.size() && i+j<result.size(); ++j)
+            result[i+j] += a.at(i) * b.at(j);
+    }
+    return result;
+}
+
+static double logBinomial(int n, int k)
+{
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+void Analyser::combine(BoardAnalysis* result)
+{
+    QVector<Area*> areas;
+    int knownMines = 0;
+    int unconstrained = 0;
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        if(m_cells.at(idx) >= 0)
+            continue;
+        if(m_knowledge.at(idx) == Mine)
+            knownMines++;
+        else if(m_knowledge.at(idx) == Unknown && m_frontierIndex.at(idx) == -1)
+            unconstrained++;
+    }
+    // cells of areas which couldn't be enumerated count as unconstrained
+    for(Area& area : m_areas)
+    {
+        if(area.enumerated)
+            areas.append(&area);
+        else
+        {
+            unconstrained += area.cells.size();
+            result->exact = false;
+        }
+    }
+    const int leftMines = m_numMines - knownMines;
+    const double density = unconstrained > 0 ? qBound(0.0, double(leftMines) / unconstrained, 1.0) : 0.0;
+
+    // normalized so that products of many areas don't overflow
+    for(Area* area : std::as_const(areas))
+    {
+        double maximum = 0;
+        for(double count : std::as_const(area->solutions))
+            maximum = qMax(maximum, count);
+        for(double& count : area->solutions)
+            count /= maximum;
+        for(double& count : area->cellMines)
+            count /= maximum;
+    }
+
+    // weight of t mines in the frontier: ways to put the others in unconstrained cells.
+    // Combining areas costs about areas*frontier^2 steps, beyond that they are
+    // weighted as if unconstrained cells were endless
+    qint64 frontierCells = 0;
+    for(const Area* area : std::as_const(areas))
+        frontierCells += area->cells.size();
+    const qint64 terms = areas.size() * (frontierCells + 1) * (frontierCells + 1);
+    const bool coupled = leftMines >= 0 && terms <= MAXIMAL_CONVOLUTION;
+
+    QVector<double> weights;
+    if(coupled)
+    {
+        QVector<double> logWeights(leftMines + 1);
+        double maximum = -std::numeric_limits<double>::infinity();
+        for(int t=0; t<=leftMines; ++t)
+        {
+            logWeights[t] = leftMines - t <= unconstrained ? logBinomial(unconstrained, leftMines - t)
+                                                           : -std::numeric_limits<double>::infinity();
+            maximum = qMax(maximum, logWeights.at(t));
+        }
+        weights.resize(leftMines + 1);
+        for(int t=0; t<=leftMines; ++t)
+            weights[t] = std::isinf(logWeights.at(t)) ? 0.0 : std::exp(logWeights.at(t) - maximum);
+    }
+
+    auto weightOf = [&](int t) {
+        if(coupled)
+            return t < weights.size() ? weights.at(t) : 0.0;
+        // many areas: every mine in the frontier is one less in the rest
+        return std::pow(density / qMax(1.0 - density, 1e-9), t);
+    };
+
+    // products of all areas before and after each one
+    QVector<QVector<double>> prefix(areas.size() + 1);
+    QVector<QVector<double>> suffix(areas.size() + 1);
+    if(coupled)
+    {
+        prefix[0] = QVector<double>{1.0};
+        for(int i=0; i<areas.size(); ++i)
+            prefix[i+1] = convolve(prefix.at(i), areas.at(i)->solutions, leftMines + 1);
+        suffix[areas.size()] = QVector<double>{1.0};
+        for(int i=areas.size()-1; i>=0; --i)
+            suffix[i] = convolve(suffix.at(i+1), areas.at(i)->solutions, leftMines + 1);
+    }
+    else
+        result->exact = false;
+
+    double total = 0;
+    double unconstrainedMines = 0;
+    if(coupled)
+    {
+        const QVector<double>& all = prefix.at(areas.size());
+        for(int t=0; t<all.size(); ++t)
+        {
+            total += all.at(t) * weightOf(t);
+            if(unconstrained > 0)
+                unconstrainedMines += all.at(t) * weightOf(t) * (leftMines - t) / unconstrained;
+        }
+    }
+
+    // the rest holds no mines, or only mines, if every possible number
+    // of mines in the frontier leaves it that many
+    bool restSafe = leftMines == 0;
+    bool restMines = false;
+    if(coupled && unconstrained > 0)
+    {
+        const QVector<double>& all = prefix.at(areas.size());
+        bool possible = false;
+        restSafe = restMines = true;
+        for(int t=0; t<all.size(); ++t)
+        {
+            if(all.at(t) <= 0 || leftMines - t > unconstrained)
+                continue;
+            possible = true;
+            restSafe = restSafe && t == leftMines;
+            restMines = restMines && leftMines - t == unconstrained;
+        }
+        restSafe = restSafe && possible;
+        restMines = restMines && possible;
+    }
+
+    // cells are listed as safe or mines on proof only, not
+    // because their probability rounds to 0 or 1
+    QVector<qint8> proven = m_knowledge;
+    result->mineProbability.fill(-1.0f, m_cells.size());
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        if(m_cells.at(idx) >= 0)
+            continue;
+        if(m_knowledge.at(idx) == Safe)
+            result->mineProbability[idx] = 0.0f;
+        else if(m_knowledge.at(idx) == Mine)
+            result->mineProbability[idx] = 1.0f;
+        else
+        {
+            result->mineProbability[idx] = coupled && total > 0 ? unconstrainedMines / total : density;
+            proven[idx] = restSafe ? Safe : restMines ? Mine : Unknown;
+        }
+    }
+
+    for(int i=0; i<areas.size(); ++i)
+    {
+        const Area* area = areas.at(i);
+        const int size = area->cells.size();
+
+        // weight of the area holding k mines, summed over all the others
+        QVector<double> areaWeights(size + 1, 0.0);
+        double areaTotal = 0;
+        if(coupled)
+        {
+            const QVector<double> rest = convolve(prefix.at(i), suffix.at(i+1), leftMines + 1);
+            for(int k=0; k<=size; ++k)
+                for(int r=0; r<rest.size(); ++r)
+                    areaWeights[k] += rest.at(r) * weightOf(k + r);
+        }
+        else
+        {
+            for(int k=0; k<=size; ++k)
+                areaWeights[k] = weightOf(k);
+        }
+        for(int k=0; k<=size; ++k)
+            areaTotal += area->solutions.at(k) * areaWeights.at(k);
+        // cells of the area aren't part of the rest
+        for(int idx : area->cells)
+            proven[idx] = Unknown;
+        if(areaTotal <= 0)
+            continue;
+
+        for(int cell=0; cell<size; ++cell)
+        {
+            double mines = 0;
+            bool alwaysMine = true;
+            for(int k=0; k<=size; ++k)
+            {
+                const double count = area->cellMines.at(cell*(size+1) + k);
+                mines += count * areaWeights.at(k);
+                if(area->solutions.at(k) > 0 && areaWeights.at(k) > 0 && count != area->solutions.at(k))
+                    alwaysMine = false;
+            }
+            const int idx = area->cells.at(cell);
+            if(mines == 0)
+            {
+                result->mineProbability[idx] = 0.0f;
+                proven[idx] = Safe;
+            }
+            else if(alwaysMine)
+            {
+                result->mineProbability[idx] = 1.0f;
+                proven[idx] = Mine;
+            }
+            else
+                result->mineProbability[idx] = qBound(0.0, mines / areaTotal, 1.0);
+        }
+    }
+
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        if(m_cells.at(idx) >= 0)
+            continue;
+        if(proven.at(idx) == Safe)
+            result->safeCells.append(idx);
+        else if(proven.at(idx) == Mine)
+            result->mineCells.append(idx);
+    }
+}
+
+template<typename Geometry>
+bool Analyser::run(const Geometry& geometry, BoardAnalysis* result)
+{
+    Q_ASSERT(m_cells.size() == geometry.numCells());
+
+    m_knowledge.fill(Unknown, m_cells.size());
+    collectConstraints(geometry);
+    if(!propagate())
+        return false;
+    findAreas();
+
+    m_localIndex.fill(-1, m_cells.size());
+    for(Area& area : m_areas)
+    {
+        if(!enumerate(&area))
+            return false;
+    }
+    if(isCancelled())
+        return false;
+    combine(result);
+    return true;
+}
+
+}
+
+BoardAnalysis Solver::analyse(int numRows, int numCols, int numMines,
+                              const QVector<qint8>& cells, const CancelCheck& cancelled,
+                              int maximalSearchSteps)
+{
+    return withGeometry(numRows, numCols, [&](const auto& geometry) {
+        BoardAnalysis result;
+        Analyser analyser(numMines, cells, cancelled, maximalSearchSteps);
+        if(!analyser.run(geometry, &result))
+            return BoardAnalysis();
+        return result;
+    });
+}
+
+BoardAnalysis Solver::analyse(const BoardTopology& topology, int numMines,
+                              const QVector<qint8>& cells, const CancelCheck& cancelled,
+                              int maximalSearchSteps)
+{
+    return withGeometry(topology, [&](const auto& geometry) {
+        BoardAnalysis result;
+        Analyser analyser(numMines, cells, cancelled, maximalSearchSteps);
+        if(!analyser.run(geometry, &result))
+            return BoardAnalysis();
+        return result;
+    });
+}
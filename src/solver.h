@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+// own
+#include "boardview.h"
+// Qt
+#include <QVector>
+// Std
+#include <functional>
+
+class BoardTopology;
+
+/**
+ * What can be deduced about a board from what the player sees
+ */
+struct BoardAnalysis
+{
+    /**
+     * Probability of each cell to hold a mine, -1 for revealed cells
+     */
+    QVector<float> mineProbability;
+    /**
+     * Covered cells which are proven to be free of mines
+     */
+    QVector<int> safeCells;
+    /**
+     * Covered cells which are proven to hold mines
+     */
+    QVector<int> mineCells;
+    /**
+     * False if parts of the board were too big to be enumerated,
+     * their probabilities are then estimates
+     */
+    bool exact = true;
+
+    bool isValid() const { return !mineProbability.isEmpty(); }
+};
+
+/**
+ * Deduces safe cells, mines and mine probabilities of a board.
+ *
+ * Trivial constraints are propagated first, the remaining frontier is
+ * split in independent areas which are enumerated exhaustively and
+ * weighted by the number of ways left mines fit in unconstrained cells.
+ * All functions are reentrant, so they can run on worker threads.
+ */
+class Solver
+{
+public:
+    /**
+     * Cell values of a board as seen by the player, other cells hold their digit
+     */
+    static constexpr qint8 Covered = BoardView::Covered;
+    static constexpr qint8 Flagged = BoardView::Flagged;
+    /**
+     * Frontier areas with more cells aren't enumerated
+     */
+    static const int MAXIMAL_AREA_CELLS = 64;
+    /**
+     * Default maximal number of search steps spent on one frontier area
+     */
+    static const int MAXIMAL_SEARCH_STEPS = 1 << 20;
+
+    typedef std::function<bool()> CancelCheck;
+
+    /**
+     * Analyses a board. Flags are handled as covered cells, since
+     * the player may have put them wrong.
+     *
+     * @param cells row-major array of numRows*numCols revealed digits, Covered or Flagged
+     * @param cancelled polled now and then, the analysis is abandoned when it returns true
+     * @param maximalSearchSteps areas needing more steps are handled as if they weren't enumerated
+     * @return analysis of the board, invalid if cancelled
+     */
+    static BoardAnalysis analyse(int numRows, int numCols, int numMines,
+                                 const QVector<qint8>& cells,
+                                 const CancelCheck& cancelled = CancelCheck(),
+                                 int maximalSearchSteps = MAXIMAL_SEARCH_STEPS);
+    /**
+     * Analyses a board of any topology, cells are kept as described by topology
+     */
+    static BoardAnalysis analyse(const BoardTopology& topology, int numMines,
+                                 const QVector<qint8>& cells,
+                                 const CancelCheck& cancelled = CancelCheck(),
+                                 int maximalSearchSteps = MAXIMAL_SEARCH_STEPS);
+};
+
+#endif
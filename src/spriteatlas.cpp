@@ -0,0 +1,163 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "spriteatlas.h"
+
+// own
+#include "kmines_debug.h"
+// KDEGames
+#include <KGameRenderer>
+#include <KgTheme>
+#include <KgThemeProvider>
+// Qt
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSettings>
+#include <QStandardPaths>
+// Std
+#include <algorithm>
+
+// number of render sizes kept in cache, e.g. while the window is resized
+static const int MAX_CACHED_SIZES = 3;
+// an atlas is used when it is at most this much bigger than the requested size,
+// downscaling by a small factor is not noticeable
+static const qreal MAX_ATLAS_DOWNSCALE = 1.25;
+
+SpriteAtlas::SpriteAtlas(KGameRenderer* renderer, QObject* parent)
+    : QObject(parent), m_renderer(renderer)
+{
+    connect(m_renderer->themeProvider(), &KgThemeProvider::currentThemeChanged, this, &SpriteAtlas::clear);
+}
+
+void SpriteAtlas::clear()
+{
+    m_indexLoaded = false;
+    m_atlasPath.clear();
+    m_atlasSizes.clear();
+    m_atlasKeys.clear();
+    m_sprites.clear();
+}
+
+void SpriteAtlas::loadIndex()
+{
+    m_indexLoaded = true;
+
+    const QFileInfo themeFile(m_renderer->theme()->graphicsPath());
+    const QString indexFile = QStandardPaths::locate(QStandardPaths::AppDataLocation,
+        QStringLiteral("atlases/%1.atlas").arg(themeFile.completeBaseName()));
+    if(indexFile.isEmpty())
+        return;
+
+    // atlas must have been generated from exactly this theme file,
+    // hashing it takes about a millisecond and is done once per theme
+    const QSettings index(indexFile, QSettings::IniFormat);
+    QFile source(themeFile.absoluteFilePath());
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if(!source.open(QIODevice::ReadOnly) || !hash.addData(&source)
+       || index.value(QStringLiteral("SourceHash")).toByteArray() != hash.result().toHex())
+    {
+        qCDebug(KMINES_LOG) << "Ignoring outdated atlas" << indexFile;
+        return;
+    }
+
+    const QStringList sizes = index.value(QStringLiteral("Sizes")).toStringList();
+    for (const QString& size : sizes)
+        m_atlasSizes.append(size.toInt());
+    std::sort(m_atlasSizes.begin(), m_atlasSizes.end());
+    m_atlasKeys = index.value(QStringLiteral("Keys")).toStringList();
+    m_atlasColumns = index.value(QStringLiteral("Columns")).toInt();
+    m_atlasPath = QFileInfo(indexFile).absolutePath() + QLatin1Char('/') + themeFile.completeBaseName();
+}
+
+int SpriteAtlas::atlasSizeFor(const QSize& pixelSize) const
+{
+    // atlases are square, only cells and borders use them
+    if(pixelSize.width() != pixelSize.height())
+        return 0;
+
+    for (int atlasSize : m_atlasSizes)
+    {
+        if(atlasSize < pixelSize.width())
+            continue;
+        return atlasSize <= pixelSize.width()*MAX_ATLAS_DOWNSCALE ? atlasSize : 0;
+    }
+    return 0;
+}
+
+void SpriteAtlas::loadFromAtlas(const QSize& size, qreal ratio, QHash<QString, QPixmap>& sprites)
+{
+    if(!m_indexLoaded)
+        loadIndex();
+
+    const QSize pixelSize = size*ratio;
+    const int atlasSize = atlasSizeFor(pixelSize);
+    if(atlasSize == 0 || m_atlasColumns <= 0)
+        return;
+
+    const QImage atlas(QStringLiteral("%1-%2.png").arg(m_atlasPath).arg(atlasSize));
+    if(atlas.isNull())
+        return;
+
+    for(int i=0; i<m_atlasKeys.size(); ++i)
+    {
+        QImage sprite = atlas.copy((i % m_atlasColumns)*atlasSize, (i / m_atlasColumns)*atlasSize,
+                                   atlasSize, atlasSize);
+        if(atlasSize != pixelSize.width())
+            sprite = sprite.scaled(pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        sprite.setDevicePixelRatio(ratio);
+        sprites.insert(m_atlasKeys.at(i), QPixmap::fromImage(sprite));
+    }
+}
+
+QHash<QString, QPixmap>& SpriteAtlas::spritesForSize(const QSize& size, qreal ratio)
+{
+    for(int i=0; i<m_sprites.size(); ++i)
+    {
+        if(m_sprites.at(i).size == size && m_sprites.at(i).ratio == ratio)
+        {
+            if(i != 0)
+                m_sprites.move(i, 0);
+            return m_sprites.first().pixmaps;
+        }
+    }
+
+    if(m_sprites.size() == MAX_CACHED_SIZES)
+        m_sprites.removeLast();
+    m_sprites.prepend(Sprites{size, ratio, QHash<QString, QPixmap>()});
+    loadFromAtlas(size, ratio, m_sprites.first().pixmaps);
+    return m_sprites.first().pixmaps;
+}
+
+QPixmap SpriteAtlas::spritePixmap(const QString& key, const QSize& size, qreal ratio)
+{
+    if(size.isEmpty())
+        return QPixmap();
+
+    QHash<QString, QPixmap>& sprites = spritesForSize(size, ratio);
+    auto it = sprites.constFind(key);
+    if(it != sprites.constEnd())
+        return *it;
+
+    // not in atlas, fall back to rendering the theme
+    QPixmap pixmap = m_renderer->spritePixmap(key, size*ratio);
+    if(ratio != 1.0)
+        pixmap.setDevicePixelRatio(ratio);
+    sprites.insert(key, pixmap);
+    return pixmap;
+}
+
+qint64 SpriteAtlas::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (const Sprites& entry : m_sprites)
+    {
+        for (const QPixmap& pixmap : entry.pixmaps)
+            bytes += qint64(pixmap.width())*pixmap.height()*pixmap.depth()/8;
+    }
+    return bytes;
+}
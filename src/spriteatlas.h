@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+// Qt
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QVector>
+
+class KGameRenderer;
+
+/**
+ * Source of cell and border pixmaps.
+ *
+ * Shipped themes come with atlases pre-rendered at build time
+ * (see tools/atlasgen.cpp) for a ladder of common cell sizes.
+ * Sprites are taken from the nearest atlas whenever it is close
+ * enough to the requested size in device pixels, the SVG theme is
+ * rendered through KGameRenderer only for unusual sizes or themes
+ * without atlases. Atlases are only used if the hash of the theme
+ * file they were rendered from matches.
+ *
+ * Pixmaps are cached for the few most recently used sizes.
+ */
+class SpriteAtlas : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SpriteAtlas(KGameRenderer* renderer, QObject* parent = nullptr);
+    /**
+     * @return pixmap of sprite with given key rendered at given size,
+     * with ratio device pixels per pixel
+     */
+    QPixmap spritePixmap(const QString& key, const QSize& size, qreal ratio = 1.0);
+    /**
+     * @return approximate number of bytes used by cached pixmaps
+     */
+    qint64 memoryUsage() const;
+    KGameRenderer* renderer() const { return m_renderer; }
+private Q_SLOTS:
+    /**
+     * Drops everything loaded for the previous theme
+     */
+    void clear();
+private:
+    /**
+     * Reads atlas index of current theme, if there is one
+     */
+    void loadIndex();
+    /**
+     * @return atlas size to use for given size in device pixels, 0 if none fits
+     */
+    int atlasSizeFor(const QSize& pixelSize) const;
+    /**
+     * Fills sprites for given render size and ratio from the nearest atlas
+     */
+    void loadFromAtlas(const QSize& size, qreal ratio, QHash<QString, QPixmap>& sprites);
+    /**
+     * @return cache for given size and ratio, evicting least recently used sizes
+     */
+    QHash<QString, QPixmap>& spritesForSize(const QSize& size, qreal ratio);
+
+    KGameRenderer* m_renderer;
+    bool m_indexLoaded = false;
+    QString m_atlasPath;
+    /**
+     * Sizes of the atlases in device pixels, atlases for
+     * higher ratios are just bigger sizes
+     */
+    QVector<int> m_atlasSizes;
+    QStringList m_atlasKeys;
+    int m_atlasColumns = 0;
+
+    struct Sprites
+    {
+        QSize size;
+        qreal ratio;
+        QHash<QString, QPixmap> pixmaps;
+    };
+    /**
+     * Cached sprites per render size and ratio, most recently used first
+     */
+    QVector<Sprites> m_sprites;
+};
+
+#endif
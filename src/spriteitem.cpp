@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "spriteitem.h"
+
+// own
+#include "spriteatlas.h"
+// Qt
+#include <QPainter>
+
+SpriteItem::SpriteItem(SpriteAtlas* atlas, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_atlas(atlas)
+{
+}
+
+void SpriteItem::setSpriteKeys(const QStringList& keys)
+{
+    if(keys == m_spriteKeys)
+        return;
+    m_spriteKeys = keys;
+    updateLayers();
+}
+
+QStringList SpriteItem::spriteKeys() const
+{
+    return m_spriteKeys;
+}
+
+void SpriteItem::setRenderSize(const QSize& renderSize)
+{
+    if(renderSize != m_renderSize)
+    {
+        prepareGeometryChange();
+        m_renderSize = renderSize;
+    }
+    updateLayers();
+}
+
+QSize SpriteItem::renderSize() const
+{
+    return m_renderSize;
+}
+
+void SpriteItem::updateLayers()
+{
+    fetchLayers();
+    update();
+}
+
+void SpriteItem::fetchLayers()
+{
+    m_layers.resize(m_spriteKeys.size());
+    for(int i=0; i<m_spriteKeys.size(); ++i)
+        m_layers[i] = m_atlas->spritePixmap(m_spriteKeys.at(i), m_renderSize, m_ratio);
+}
+
+QRectF SpriteItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), m_renderSize);
+}
+
+void SpriteItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* opt, QWidget* widget)
+{
+    Q_UNUSED(opt);
+    Q_UNUSED(widget);
+
+    const qreal ratio = painter->device()->devicePixelRatioF();
+    if(ratio != m_ratio)
+    {
+        m_ratio = ratio;
+        fetchLayers();
+    }
+    for (const QPixmap& layer : std::as_const(m_layers))
+        painter->drawPixmap(0, 0, layer);
+}
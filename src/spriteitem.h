@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SPRITEITEM_H
+#define SPRITEITEM_H
+
+// Qt
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QStringList>
+#include <QVector>
+
+class SpriteAtlas;
+
+/**
+ * Graphics item drawing a stack of theme sprites on top of each other,
+ * all of them taken from the shared SpriteAtlas
+ */
+class SpriteItem : public QGraphicsItem
+{
+public:
+    SpriteItem(SpriteAtlas* atlas, QGraphicsItem* parent);
+    /**
+     * Sets sprites to draw, first one at the bottom
+     */
+    void setSpriteKeys(const QStringList& keys);
+    QStringList spriteKeys() const;
+    /**
+     * Sets size of this item and re-fetches its pixmaps,
+     * also needed after a theme change. Pixmaps are fetched
+     * again when painted on a screen of another pixel ratio
+     */
+    void setRenderSize(const QSize& renderSize);
+    QSize renderSize() const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget* widget = nullptr) override;
+protected:
+    SpriteAtlas* atlas() const { return m_atlas; }
+private:
+    void updateLayers();
+    void fetchLayers();
+
+    SpriteAtlas* m_atlas;
+    QStringList m_spriteKeys;
+    QSize m_renderSize;
+    qreal m_ratio = 1.0;
+    /**
+     * Pixmaps for m_spriteKeys at m_renderSize and m_ratio
+     */
+    QVector<QPixmap> m_layers;
+};
+
+#endif
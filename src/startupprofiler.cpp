@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "startupprofiler.h"
+
+// Qt
+#include <QElapsedTimer>
+#include <QPair>
+#include <QTextStream>
+#include <QVector>
+
+namespace
+{
+struct ProfilerState
+{
+    QElapsedTimer clock;
+    QVector<QPair<QString, qint64>> phases;
+    bool reportEnabled = false;
+    bool firstFramePainted = false;
+    bool interactive = false;
+    bool finished = false;
+};
+}
+
+static ProfilerState& state()
+{
+    static ProfilerState s_state;
+    return s_state;
+}
+
+void StartupProfiler::start()
+{
+    state().clock.start();
+}
+
+void StartupProfiler::setReportEnabled(bool enabled)
+{
+    state().reportEnabled = enabled;
+}
+
+void StartupProfiler::mark(const QString& phase)
+{
+    ProfilerState& s = state();
+    if(s.finished || !s.clock.isValid())
+        return;
+    s.phases.append(qMakePair(phase, s.clock.nsecsElapsed()));
+}
+
+void StartupProfiler::setInteractive()
+{
+    if(state().interactive)
+        return;
+    mark(QStringLiteral("first game ready"));
+    state().interactive = true;
+}
+
+void StartupProfiler::framePainted()
+{
+    ProfilerState& s = state();
+    if(s.finished)
+        return;
+
+    if(!s.firstFramePainted)
+    {
+        s.firstFramePainted = true;
+        mark(QStringLiteral("first frame"));
+    }
+    if(!s.interactive)
+        return;
+
+    mark(QStringLiteral("first interactive frame"));
+    s.finished = true;
+
+    if(!s.reportEnabled)
+        return;
+
+    // asked for on the command line, so printed whatever the logging rules
+    QTextStream err(stderr);
+    qint64 previous = 0;
+    for (const auto& phase : std::as_const(s.phases))
+    {
+        err << QStringLiteral("%1 ms (+%2 ms) %3")
+            .arg(phase.second / 1000000.0, 8, 'f', 2)
+            .arg((phase.second - previous) / 1000000.0, 8, 'f', 2)
+            .arg(phase.first) << Qt::endl;
+        previous = phase.second;
+    }
+    err << "Time to first interactive frame: " << previous / 1000000.0 << " ms" << Qt::endl;
+}
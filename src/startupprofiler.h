@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+// Qt
+#include <QString>
+
+/**
+ * Records how long each startup phase takes, up to the first frame
+ * painted with a playable field. Recording is always on since it
+ * costs one clock read per phase, the report is only printed when
+ * requested on the command line.
+ */
+class StartupProfiler
+{
+public:
+    /**
+     * Starts the clock, should be the first thing done in main()
+     */
+    static void start();
+    /**
+     * Enables printing the report once startup is over
+     */
+    static void setReportEnabled(bool enabled);
+    /**
+     * Records end of a startup phase
+     */
+    static void mark(const QString& phase);
+    /**
+     * Called when the first game is set up and the field can be played
+     */
+    static void setInteractive();
+    /**
+     * Called by the view after each paint, records first frame
+     * and first interactive frame
+     */
+    static void framePainted();
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Pre-renders cell, overlay, digit and border sprites of a theme into
+// one PNG atlas per cell size and device pixel ratio, plus an index
+// read by SpriteAtlas.
+
+// Qt
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QSettings>
+#include <QSvgRenderer>
+#include <QTextStream>
+// Std
+#include <algorithm>
+#include <cmath>
+
+// keep in sync with CellItem::fillNameHashes() and BorderItem::fillNameHash()
+static const char* const SPRITE_KEYS[] = {
+    "cell_up", "cell_down", "flag", "question", "mine", "error", "explosion", "hint",
+    "arabicOne", "arabicTwo", "arabicThree", "arabicFour",
+    "arabicFive", "arabicSix", "arabicSeven", "arabicEight",
+    "border.edge.north", "border.edge.south", "border.edge.east", "border.edge.west",
+    "border.outsideCorner.ne", "border.outsideCorner.nw",
+    "border.outsideCorner.sw", "border.outsideCorner.se",
+    "border.insideCorner.ne", "border.insideCorner.nw",
+    "border.insideCorner.sw", "border.insideCorner.se",
+    "border.bay.north", "border.bay.south", "border.bay.east", "border.bay.west"
+};
+
+/**
+ * @param sizes sizes of the atlases in device pixels
+ */
+static bool generateAtlases(const QString& themeFile, const QList<int>& sizes, const QDir& outputDir)
+{
+    QTextStream err(stderr);
+    QSvgRenderer renderer(themeFile);
+    QFile source(themeFile);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if(!renderer.isValid() || !source.open(QIODevice::ReadOnly) || !hash.addData(&source))
+    {
+        err << "Unable to load " << themeFile << Qt::endl;
+        return false;
+    }
+
+    QStringList keys;
+    for (const char* key : SPRITE_KEYS)
+    {
+        if(renderer.elementExists(QLatin1String(key)))
+            keys.append(QLatin1String(key));
+    }
+
+    const QString baseName = QFileInfo(themeFile).completeBaseName();
+    const int columns = static_cast<int>(std::ceil(std::sqrt(keys.size())));
+    const int rows = (keys.size() + columns - 1) / columns;
+
+    QStringList sizeList;
+    for (int size : sizes)
+    {
+        QImage atlas(columns*size, rows*size, QImage::Format_ARGB32_Premultiplied);
+        atlas.fill(Qt::transparent);
+        QPainter painter(&atlas);
+        for(int i=0; i<keys.size(); ++i)
+            renderer.render(&painter, keys.at(i), QRectF((i % columns)*size, (i / columns)*size, size, size));
+        painter.end();
+
+        const QString fileName = outputDir.filePath(QStringLiteral("%1-%2.png").arg(baseName).arg(size));
+        if(!atlas.save(fileName))
+        {
+            err << "Unable to write " << fileName << Qt::endl;
+            return false;
+        }
+        sizeList.append(QString::number(size));
+    }
+
+    QSettings index(outputDir.filePath(baseName + QStringLiteral(".atlas")), QSettings::IniFormat);
+    index.clear();
+    index.setValue(QStringLiteral("SourceHash"), hash.result().toHex());
+    index.setValue(QStringLiteral("Sizes"), sizeList);
+    index.setValue(QStringLiteral("Keys"), keys);
+    index.setValue(QStringLiteral("Columns"), columns);
+    index.sync();
+    return index.status() == QSettings::NoError;
+}
+
+int main(int argc, char** argv)
+{
+    // fonts are needed for text in themes, but no display
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Pre-renders KMines theme sprites into atlases"));
+    parser.addHelpOption();
+    QCommandLineOption sizesOption(QStringLiteral("sizes"),
+                                   QStringLiteral("Comma separated list of cell sizes."),
+                                   QStringLiteral("sizes"));
+    QCommandLineOption ratiosOption(QStringLiteral("ratios"),
+                                    QStringLiteral("Comma separated list of device pixel ratios, every size is rendered for each."),
+                                    QStringLiteral("ratios"), QStringLiteral("1"));
+    QCommandLineOption outputOption(QStringLiteral("output"),
+                                    QStringLiteral("Directory for generated atlases."),
+                                    QStringLiteral("dir"), QStringLiteral("."));
+    parser.addOption(sizesOption);
+    parser.addOption(ratiosOption);
+    parser.addOption(outputOption);
+    parser.addPositionalArgument(QStringLiteral("themes"), QStringLiteral("Theme SVG files."));
+    parser.process(app);
+
+    QList<int> sizes;
+    const QStringList sizeArgs = parser.value(sizesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString& size : sizeArgs)
+    {
+        bool ok = false;
+        const int value = size.toInt(&ok);
+        if(!ok || value <= 0)
+            parser.showHelp(1);
+        sizes.append(value);
+    }
+    QList<qreal> ratios;
+    const QStringList ratioArgs = parser.value(ratiosOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString& ratio : ratioArgs)
+    {
+        bool ok = false;
+        const qreal value = ratio.toDouble(&ok);
+        if(!ok || value <= 0)
+            parser.showHelp(1);
+        ratios.append(value);
+    }
+    if(sizes.isEmpty() || ratios.isEmpty() || parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    // atlases are looked up by size in device pixels,
+    // so higher ratios only add bigger sizes
+    QList<int> pixelSizes;
+    for (int size : std::as_const(sizes))
+        for (qreal ratio : std::as_const(ratios))
+            pixelSizes.append(qRound(size*ratio));
+    std::sort(pixelSizes.begin(), pixelSizes.end());
+    pixelSizes.erase(std::unique(pixelSizes.begin(), pixelSizes.end()), pixelSizes.end());
+
+    QDir outputDir(parser.value(outputOption));
+    if(!outputDir.mkpath(QStringLiteral(".")))
+        return 1;
+
+    const QStringList themes = parser.positionalArguments();
+    for (const QString& theme : themes)
+    {
+        if(!generateAtlases(theme, pixelSizes, outputDir))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Generates boards on all cores and adds them to a board corpus
+// read by BoardCorpus. Existing boards of the output file are kept.
+
+// own
+#include "boardcorpus.h"
+#include "boardmetrics.h"
+#include "boardrating.h"
+#include "fieldgenerator.h"
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThreadPool>
+// Std
+#include <tuple>
+
+// boards generated by one task
+static const int BATCH_SIZE = 256;
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Adds generated boards to a KMines board corpus"));
+    parser.addHelpOption();
+    QCommandLineOption rowsOption(QStringLiteral("rows"), QStringLiteral("Number of rows."), QStringLiteral("rows"));
+    QCommandLineOption colsOption(QStringLiteral("cols"), QStringLiteral("Number of columns."), QStringLiteral("cols"));
+    QCommandLineOption minesOption(QStringLiteral("mines"), QStringLiteral("Number of mines."), QStringLiteral("mines"));
+    QCommandLineOption countOption(QStringLiteral("count"), QStringLiteral("Number of boards to add."),
+                                   QStringLiteral("count"), QStringLiteral("10000"));
+    QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("Number of worker threads, all cores by default."),
+                                     QStringLiteral("threads"));
+    parser.addOption(rowsOption);
+    parser.addOption(colsOption);
+    parser.addOption(minesOption);
+    parser.addOption(countOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument(QStringLiteral("corpus"), QStringLiteral("Corpus file, created if it doesn't exist."));
+    parser.process(app);
+
+    const int numRows = parser.value(rowsOption).toInt();
+    const int numCols = parser.value(colsOption).toInt();
+    const int numMines = parser.value(minesOption).toInt();
+    const int count = parser.value(countOption).toInt();
+    // same limits as MineFieldItem::initField()
+    if(numRows <= 0 || numCols <= 0 || numMines <= 0 || numMines > numRows*numCols - FieldGenerator::MINIMAL_FREE
+        || count <= 0 || parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    QTextStream out(stdout);
+    const QString fileName = parser.positionalArguments().first();
+    BoardCorpusWriter writer;
+    if(QFileInfo::exists(fileName))
+    {
+        BoardCorpus corpus;
+        if(!corpus.open(fileName))
+        {
+            QTextStream(stderr) << "Unable to read " << fileName << Qt::endl;
+            return 1;
+        }
+        writer.addCorpus(corpus);
+        out << "Keeping " << writer.count() << " boards" << Qt::endl;
+    }
+
+    QThreadPool pool;
+    if(parser.isSet(threadsOption))
+        pool.setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+
+    QElapsedTimer timer;
+    timer.start();
+    QMutex writerMutex;
+    for(int first=0; first<count; first+=BATCH_SIZE)
+    {
+        const int batchSize = qMin(BATCH_SIZE, count - first);
+        const quint32 batchSeed = QRandomGenerator::global()->generate();
+        pool.start([&, batchSize, batchSeed]() {
+            QRandomGenerator random(batchSeed);
+            // the clicked cell is random, so that boards exist for every first click
+            QVector<std::tuple<QVector<qint8>, int, int, int>> boards;
+            for(int i=0; i<batchSize; ++i)
+            {
+                const int clickedIdx = random.bounded(numRows*numCols);
+                const QVector<qint8> field = FieldGenerator::generate(numRows, numCols, numMines,
+                                                                      clickedIdx, random.generate());
+                const int bbbv = BoardMetrics::compute(numRows, numCols, field).bbbv;
+                const int rating = BoardRating::rate(numRows, numCols, numMines, field, clickedIdx).level();
+                boards.append(std::make_tuple(field, clickedIdx, bbbv, rating));
+            }
+
+            QMutexLocker locker(&writerMutex);
+            for(const auto& board : std::as_const(boards))
+                writer.addBoard(numRows, numCols, std::get<0>(board), std::get<1>(board),
+                                std::get<2>(board), std::get<3>(board));
+        });
+    }
+    pool.waitForDone();
+
+    out << "Generated " << count << " boards in " << timer.elapsed() << " ms using "
+        << pool.maxThreadCount() << " threads" << Qt::endl;
+    if(!writer.save(fileName))
+    {
+        QTextStream(stderr) << "Unable to write " << fileName << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,423 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Replays mouse sessions on a real KMinesView offscreen and measures
+// how long each input takes to show up on screen. Built-in sessions
+// cover clicks, chord drags, rapid flagging and a huge cascade, games
+// recorded by KMines can be replayed as well.
+
+// own
+#include "boardcode.h"
+#include "fieldgenerator.h"
+#include "gamerecord.h"
+#include "minefielditem.h"
+#include "perfcounters.h"
+#include "scene.h"
+#include "settings.h"
+// Qt
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGraphicsSceneMouseEvent>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTextStream>
+// Std
+#include <algorithm>
+
+// one frame at 60 Hz
+static const qint64 FRAME_NS = 16666667;
+// an input not followed by any change of the scene for that long shows nothing
+static const qint64 NO_CHANGE_NS = 100000000;
+// a session is over once nothing was painted for that long after its last input
+static const qint64 IDLE_NS = 250000000;
+// time a button is held during a click of a recorded game, which doesn't store it
+static const int CLICK_MS = 50;
+static const QSize VIEW_SIZE(1024, 768);
+
+namespace
+{
+
+struct Step
+{
+    /**
+     * Milliseconds since the start of the session
+     */
+    int time;
+    QEvent::Type type;
+    Qt::MouseButton button;
+    /**
+     * Buttons held after the event
+     */
+    Qt::MouseButtons buttons;
+    int cell;
+};
+
+struct Session
+{
+    QString name;
+    BoardCode board;
+    bool questionMarks = true;
+    QVector<Step> steps;
+
+    void click(int time, int cell, Qt::MouseButton button, int holdTime = CLICK_MS)
+    {
+        steps.append(Step{time, QEvent::GraphicsSceneMousePress, button, button, cell});
+        steps.append(Step{time + holdTime, QEvent::GraphicsSceneMouseRelease, button, Qt::NoButton, cell});
+    }
+};
+
+struct Result
+{
+    int inputs = 0;
+    int frames = 0;
+    /**
+     * Number of 60 Hz frames which passed while an input was waiting to be painted
+     */
+    int droppedFrames = 0;
+    /**
+     * Nanoseconds from sending an input until the end of the first
+     * frame showing it, for inputs which changed the scene
+     */
+    QVector<qint64> latencies;
+};
+
+QVector<int> shuffled(QVector<int> cells, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    for(int i=cells.size()-1; i>0; --i)
+        std::swap(cells[i], cells[random.bounded(i + 1)]);
+    return cells;
+}
+
+/**
+ * Opens the expert board and clicks safe cells at a relaxed pace
+ */
+Session clicksSession()
+{
+    Session session;
+    session.name = QStringLiteral("clicks");
+    session.board = BoardCode::fromSeed(16, 30, 99, 8*30 + 15, 1);
+    const QVector<qint8> field = session.board.field();
+    QVector<int> safe;
+    for(int idx=0; idx<field.size(); ++idx)
+        if(field.at(idx) != FieldGenerator::Mine)
+            safe.append(idx);
+
+    session.click(0, session.board.clickedIdx(), Qt::LeftButton);
+    int time = 200;
+    for(int cell : shuffled(safe, 2).mid(0, 150))
+    {
+        session.click(time, cell, Qt::LeftButton);
+        time += 150;
+    }
+    return session;
+}
+
+/**
+ * Drags the chord button in a snake over the board, with moves
+ * coming faster than frames
+ */
+Session chordDragSession()
+{
+    Session session;
+    session.name = QStringLiteral("chord-drag");
+    session.board = BoardCode::fromSeed(16, 30, 99, 8*30 + 15, 1);
+    session.click(0, session.board.clickedIdx(), Qt::LeftButton);
+
+    int time = 200;
+    for(int drag=0; drag<3; ++drag)
+    {
+        const int first = drag*5*30;
+        session.steps.append(Step{time, QEvent::GraphicsSceneMousePress, Qt::MiddleButton, Qt::MiddleButton, first});
+        for(int i=1; i<150; ++i)
+        {
+            const int row = drag*5 + i/30;
+            const int col = row % 2 ? 29 - i % 30 : i % 30;
+            time += 5;
+            session.steps.append(Step{time, QEvent::GraphicsSceneMouseMove, Qt::NoButton, Qt::MiddleButton,
+                                      row*30 + col});
+        }
+        time += 5;
+        session.steps.append(Step{time, QEvent::GraphicsSceneMouseRelease, Qt::MiddleButton, Qt::NoButton,
+                                  session.steps.last().cell});
+        time += 300;
+    }
+    return session;
+}
+
+/**
+ * Flags every mine of the expert board as fast as a player could
+ */
+Session flaggingSession()
+{
+    Session session;
+    session.name = QStringLiteral("flagging");
+    session.board = BoardCode::fromSeed(16, 30, 99, 8*30 + 15, 1);
+    const QVector<qint8> field = session.board.field();
+    session.click(0, session.board.clickedIdx(), Qt::LeftButton);
+
+    int time = 200;
+    for(int idx=0; idx<field.size(); ++idx)
+    {
+        if(field.at(idx) != FieldGenerator::Mine)
+            continue;
+        session.click(time, idx, Qt::RightButton, 15);
+        time += 40;
+    }
+    return session;
+}
+
+/**
+ * One click opening nearly all of a big sparse board
+ */
+Session cascadeSession()
+{
+    Session session;
+    session.name = QStringLiteral("cascade");
+    session.board = BoardCode::fromSeed(100, 100, 20, 50*100 + 50, 1);
+    session.click(0, session.board.clickedIdx(), Qt::LeftButton);
+    return session;
+}
+
+Session recordedSession(const QString& fileName)
+{
+    const GameRecord record = GameRecord::load(fileName);
+    Session session;
+    if(!record.isValid())
+        return session;
+    session.name = QFileInfo(fileName).completeBaseName();
+    session.board = record.board;
+    session.questionMarks = record.questionMarks;
+
+    int time = 0;
+    for(const GameRecord::Move& move : record.moves)
+    {
+        // clicks don't overlap, even if the record is sparse in time
+        time = qMax(time, move.time);
+        const Qt::MouseButton button = move.kind == GameRecord::Reveal ? Qt::LeftButton
+                                     : move.kind == GameRecord::Chord ? Qt::MiddleButton : Qt::RightButton;
+        session.click(time, move.cell, button);
+        time += CLICK_MS + 1;
+    }
+    return session;
+}
+
+MineFieldItem* fieldItem(KMinesScene* scene)
+{
+    const QList<QGraphicsItem*> items = scene->items();
+    for(QGraphicsItem* item : items)
+    {
+        if(MineFieldItem* field = qobject_cast<MineFieldItem*>(item->toGraphicsObject()))
+            return field;
+    }
+    return nullptr;
+}
+
+void sendMouseEvent(KMinesScene* scene, const Step& step, const QPointF& pos)
+{
+    QGraphicsSceneMouseEvent event(step.type);
+    event.setScenePos(pos);
+    event.setScreenPos(pos.toPoint());
+    event.setLastScenePos(pos);
+    event.setLastScreenPos(pos.toPoint());
+    event.setButton(step.button);
+    event.setButtons(step.buttons);
+    if(step.type == QEvent::GraphicsSceneMousePress)
+        event.setButtonDownScenePos(step.button, pos);
+    event.setAccepted(false);
+    QCoreApplication::sendEvent(scene, &event);
+}
+
+Result replay(KMinesScene* scene, const Session& session, double speed)
+{
+    Settings::setUseQuestionMarks(session.questionMarks);
+    scene->startNewGame(session.board);
+    QElapsedTimer settle;
+    settle.start();
+    while(settle.elapsed() < 200)
+        QCoreApplication::processEvents();
+
+    const MineFieldItem* field = fieldItem(scene);
+    const qreal cellSize = field->boundingRect().height() / (session.board.numRows() + 2);
+    auto cellPos = [&](int cell) {
+        const int row = cell / session.board.numCols();
+        const int col = cell % session.board.numCols();
+        return field->mapToScene(QPointF((col + 1.5)*cellSize, (row + 1.5)*cellSize));
+    };
+
+    // inputs sent but not painted yet, oldest first
+    struct Pending
+    {
+        qint64 time;
+        bool changed;
+    };
+    QVector<Pending> pending;
+    const QMetaObject::Connection connection = QObject::connect(scene, &QGraphicsScene::changed, [&]() {
+        for(Pending& input : pending)
+            input.changed = true;
+    });
+
+    Result result;
+    PerfCounters& counters = scene->perfCounters();
+    qint64 lastFrameEnd = counters.lastFrameEnd;
+    auto poll = [&]() {
+        QCoreApplication::processEvents();
+        const qint64 now = counters.clock.nsecsElapsed();
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const Pending& input) {
+            return !input.changed && now - input.time > NO_CHANGE_NS;
+        }), pending.end());
+        if(counters.lastFrameEnd == lastFrameEnd)
+            return;
+
+        lastFrameEnd = counters.lastFrameEnd;
+        result.frames++;
+        // inputs sent before the frame started are on it
+        const qint64 frameStart = lastFrameEnd - counters.frameTime;
+        int shown = 0;
+        while(shown < pending.size() && pending.at(shown).time <= frameStart)
+        {
+            if(pending.at(shown).changed)
+                result.latencies.append(lastFrameEnd - pending.at(shown).time);
+            shown++;
+        }
+        if(shown > 0)
+            result.droppedFrames += (lastFrameEnd - pending.first().time) / FRAME_NS;
+        pending.remove(0, shown);
+    };
+
+    QElapsedTimer clock;
+    clock.start();
+    for(const Step& step : session.steps)
+    {
+        const qint64 due = qint64(step.time / speed * 1000000);
+        while(clock.nsecsElapsed() < due)
+            poll();
+        pending.append(Pending{counters.clock.nsecsElapsed(), false});
+        result.inputs++;
+        sendMouseEvent(scene, step, cellPos(step.cell));
+        poll();
+    }
+    // cascades keep painting after the last input
+    while(!pending.isEmpty() || counters.clock.nsecsElapsed() - lastFrameEnd < IDLE_NS)
+        poll();
+
+    QObject::disconnect(connection);
+    return result;
+}
+
+qint64 percentile(const QVector<qint64>& sorted, int percent)
+{
+    if(sorted.isEmpty())
+        return 0;
+    return sorted.at(qMin(sorted.size() - 1, sorted.size()*percent/100));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    // themes and atlases are found like in the game, settings
+    // and recorded games of the player are left alone
+    QCoreApplication::setApplicationName(QStringLiteral("kmines"));
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures input to paint latency of KMines"));
+    parser.addHelpOption();
+    QCommandLineOption scenariosOption(QStringLiteral("scenarios"),
+                                       QStringLiteral("Comma separated built-in sessions, or \"none\"."),
+                                       QStringLiteral("names"), QStringLiteral("clicks,chord-drag,flagging,cascade"));
+    QCommandLineOption repeatOption(QStringLiteral("repeat"), QStringLiteral("Number of times each session is replayed."),
+                                    QStringLiteral("count"), QStringLiteral("3"));
+    QCommandLineOption speedOption(QStringLiteral("speed"), QStringLiteral("Replay speed, 2 replays twice as fast."),
+                                   QStringLiteral("factor"), QStringLiteral("1"));
+    parser.addOption(scenariosOption);
+    parser.addOption(repeatOption);
+    parser.addOption(speedOption);
+    parser.addPositionalArgument(QStringLiteral("records"),
+                                 QStringLiteral("Recorded games to replay, or folders holding them."),
+                                 QStringLiteral("[records...]"));
+    parser.process(app);
+
+    const int repeat = parser.value(repeatOption).toInt();
+    const double speed = parser.value(speedOption).toDouble();
+    if(repeat <= 0 || speed <= 0)
+        parser.showHelp(1);
+
+    QVector<Session> sessions;
+    const QStringList scenarios = parser.value(scenariosOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for(const QString& scenario : scenarios)
+    {
+        if(scenario == QLatin1String("clicks"))
+            sessions.append(clicksSession());
+        else if(scenario == QLatin1String("chord-drag"))
+            sessions.append(chordDragSession());
+        else if(scenario == QLatin1String("flagging"))
+            sessions.append(flaggingSession());
+        else if(scenario == QLatin1String("cascade"))
+            sessions.append(cascadeSession());
+        else if(scenario != QLatin1String("none"))
+            parser.showHelp(1);
+    }
+    for(const QString& argument : parser.positionalArguments())
+    {
+        QStringList files;
+        if(QFileInfo(argument).isDir())
+        {
+            QDirIterator it(argument, QStringList(QLatin1String("*.") + GameRecord::fileSuffix()),
+                            QDir::Files, QDirIterator::Subdirectories);
+            while(it.hasNext())
+                files.append(it.next());
+            std::sort(files.begin(), files.end());
+        }
+        else
+            files.append(argument);
+
+        for(const QString& file : std::as_const(files))
+        {
+            const Session session = recordedSession(file);
+            if(!session.board.isValid())
+                QTextStream(stderr) << "Skipping " << file << Qt::endl;
+            else
+                sessions.append(session);
+        }
+    }
+    if(sessions.isEmpty())
+        parser.showHelp(1);
+
+    KMinesScene scene(nullptr);
+    KMinesView view(&scene, nullptr);
+    view.resize(VIEW_SIZE);
+    view.show();
+
+    // latencies in microseconds
+    QTextStream out(stdout);
+    out << "session\tinputs\tshown\tframes\tp50\tp90\tp99\tmax\tdropped" << Qt::endl;
+    for(const Session& session : std::as_const(sessions))
+    {
+        Result total;
+        for(int i=0; i<repeat; ++i)
+        {
+            const Result result = replay(&scene, session, speed);
+            total.inputs += result.inputs;
+            total.frames += result.frames;
+            total.droppedFrames += result.droppedFrames;
+            total.latencies += result.latencies;
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        out << session.name << '\t' << total.inputs << '\t' << total.latencies.size() << '\t' << total.frames << '\t'
+            << percentile(total.latencies, 50)/1000 << '\t' << percentile(total.latencies, 90)/1000 << '\t'
+            << percentile(total.latencies, 99)/1000 << '\t'
+            << (total.latencies.isEmpty() ? 0 : total.latencies.last()/1000) << '\t'
+            << total.droppedFrames << Qt::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,392 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Measures memory used by boards of growing size, and how it changes
+// when mines are reset, boards shrink and grow again and themes change.
+// Heap bytes and allocations are counted by wrapping malloc, which
+// needs glibc; elsewhere only resident memory is reported.
+
+// own
+#include "borderitem.h"
+#include "minefielditem.h"
+#include "scene.h"
+#include "spriteatlas.h"
+// KDEGames
+#include <KgTheme>
+#include <KgThemeProvider>
+// Qt
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGraphicsRectItem>
+#include <QGraphicsSceneMouseEvent>
+#include <QStandardPaths>
+#include <QTextStream>
+// Std
+#include <atomic>
+#include <cerrno>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+static std::atomic<qint64> s_heapBytes{0};
+static std::atomic<qint64> s_allocations{0};
+
+static void* counted(void* ptr)
+{
+    if(ptr)
+    {
+        s_heapBytes += malloc_usable_size(ptr);
+        s_allocations++;
+    }
+    return ptr;
+}
+
+extern "C" {
+void* malloc(size_t size)
+{
+    return counted(__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size)
+{
+    return counted(__libc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    const qint64 oldSize = ptr ? malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    // a failed realloc leaves the old block alone
+    if(result || size == 0)
+        s_heapBytes -= oldSize;
+    return counted(result);
+}
+
+void free(void* ptr)
+{
+    if(ptr)
+        s_heapBytes -= malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    void* result = counted(__libc_memalign(alignment, size));
+    if(!result)
+        return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+}
+
+static qint64 heapBytes() { return s_heapBytes; }
+static qint64 allocations() { return s_allocations; }
+#else
+static qint64 heapBytes() { return 0; }
+static qint64 allocations() { return 0; }
+#endif
+
+// share of cells holding mines on the measured boards
+static const double MINE_DENSITY = 0.15;
+// time given to painting and background analysis after each step
+static const int SETTLE_MS = 300;
+static const QSize VIEW_SIZE(1024, 768);
+// board played in between two measured ones
+static const int MINIMAL_SIZE = 4;
+
+namespace
+{
+
+qint64 residentBytes()
+{
+    // second field of statm is the resident set in pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if(!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong()*sysconf(_SC_PAGESIZE) : 0;
+}
+
+void settle()
+{
+    QElapsedTimer timer;
+    timer.start();
+    while(timer.elapsed() < SETTLE_MS)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+
+/**
+ * Heap bytes taken by one BorderItem, including its private data
+ */
+qint64 borderItemCost(SpriteAtlas* atlas)
+{
+    static const int COUNT = 256;
+    QGraphicsRectItem parent;
+    const qint64 before = heapBytes();
+    for(int i=0; i<COUNT; ++i)
+        (new BorderItem(atlas, &parent))->setBorderType(KMinesState::BorderNorth);
+    return (heapBytes() - before) / COUNT;
+}
+
+int borderItemCount(KMinesScene* scene)
+{
+    int count = 0;
+    const QList<QGraphicsItem*> items = scene->items();
+    for(QGraphicsItem* item : items)
+        if(qgraphicsitem_cast<BorderItem*>(item))
+            count++;
+    return count;
+}
+
+MineFieldItem* fieldItem(KMinesScene* scene)
+{
+    const QList<QGraphicsItem*> items = scene->items();
+    for(QGraphicsItem* item : items)
+    {
+        if(MineFieldItem* field = qobject_cast<MineFieldItem*>(item->toGraphicsObject()))
+            return field;
+    }
+    return nullptr;
+}
+
+/**
+ * Clicks the centre of the board, so that the field is generated
+ * and analysed like in a game
+ */
+void clickCentre(KMinesScene* scene)
+{
+    const MineFieldItem* field = fieldItem(scene);
+    const qreal cellSize = field->boundingRect().height() / (field->rowCount() + 2);
+    const QPointF pos = field->mapToScene(QPointF((field->columnCount()/2 + 1.5)*cellSize,
+                                                  (field->rowCount()/2 + 1.5)*cellSize));
+    for(const QEvent::Type type : {QEvent::GraphicsSceneMousePress, QEvent::GraphicsSceneMouseRelease})
+    {
+        QGraphicsSceneMouseEvent event(type);
+        event.setScenePos(pos);
+        event.setScreenPos(pos.toPoint());
+        event.setButton(Qt::LeftButton);
+        event.setButtons(type == QEvent::GraphicsSceneMousePress ? Qt::LeftButton : Qt::NoButton);
+        event.setButtonDownScenePos(Qt::LeftButton, pos);
+        QCoreApplication::sendEvent(scene, &event);
+    }
+}
+
+/**
+ * Heap taken by the parts of the current board, each measured around
+ * the calls which build or leave it, pixmaps rendered meanwhile left
+ * out. -1 if not measured in a step
+ */
+struct BoardCost
+{
+    /**
+     * Taken by initField() beyond border items: cells, topology and board model
+     */
+    qint64 cells = -1;
+    qint64 borders = -1;
+    /**
+     * Given back when the previous board was left
+     */
+    qint64 freed = -1;
+    /**
+     * Taken by the first click: generation, analysis and game record
+     */
+    qint64 game = -1;
+};
+
+/**
+ * Heap taken by a call, without pixmaps it rendered
+ */
+template<typename Call>
+qint64 heapDelta(KMinesScene* scene, Call call)
+{
+    const qint64 heap = heapBytes();
+    const qint64 pixmaps = scene->pixmapMemory();
+    call();
+    return heapBytes() - heap - (scene->pixmapMemory() - pixmaps);
+}
+
+/**
+ * Prints one line of measurements, split into subsystems
+ */
+class Report
+{
+public:
+    Report(KMinesScene* scene, qint64 baseline)
+        : m_scene(scene), m_baseline(baseline), m_out(stdout)
+    {
+        m_lastAllocations = allocations();
+        m_out << "step\trss\theap\tallocs\tcells\tborders\tfreed\tgame\tpixmaps" << Qt::endl;
+    }
+
+    void measure(const QString& step, const BoardCost& cost)
+    {
+        auto value = [](qint64 bytes) {
+            return bytes < 0 ? QStringLiteral("-") : QString::number(bytes);
+        };
+        m_out << step << '\t' << residentBytes() << '\t' << heapBytes() - m_baseline << '\t'
+              << allocations() - m_lastAllocations << '\t' << value(cost.cells) << '\t' << value(cost.borders) << '\t'
+              << value(cost.freed) << '\t' << value(cost.game) << '\t' << m_scene->pixmapMemory() << Qt::endl;
+        m_lastAllocations = allocations();
+    }
+private:
+    KMinesScene* m_scene;
+    qint64 m_baseline;
+    qint64 m_lastAllocations = 0;
+    QTextStream m_out;
+};
+
+BoardCost newGame(KMinesScene* scene, int size, qint64 borderCost)
+{
+    const int numCells = size*size;
+    const int mines = qBound(1, qRound(numCells*MINE_DENSITY), numCells - MineFieldItem::MINIMAL_FREE);
+    BoardCost cost;
+
+    // the smallest board in between, so that leaving the
+    // previous board is measured apart from building this one
+    cost.freed = -heapDelta(scene, [scene]() {
+        scene->startNewGame(MINIMAL_SIZE, MINIMAL_SIZE, 1);
+    });
+    const int bordersBefore = borderItemCount(scene);
+    const qint64 built = heapDelta(scene, [scene, size, mines]() {
+        scene->startNewGame(size, size, mines);
+    });
+    const int borders = borderItemCount(scene);
+    cost.borders = borders*borderCost;
+    cost.cells = built - (borders - bordersBefore)*borderCost;
+    settle();
+
+    cost.game = heapDelta(scene, [scene]() {
+        clickCentre(scene);
+        settle();
+    });
+    return cost;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    // themes and atlases are found like in the game, settings
+    // of the player are left alone
+    QCoreApplication::setApplicationName(QStringLiteral("kmines"));
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures memory used by KMines boards"));
+    parser.addHelpOption();
+    QCommandLineOption sizesOption(QStringLiteral("sizes"),
+                                   QStringLiteral("Comma separated list of board sizes, boards are square."),
+                                   QStringLiteral("sizes"), QStringLiteral("10,20,30,40,50,75,100,150,200"));
+    QCommandLineOption cyclesOption(QStringLiteral("cycles"),
+                                    QStringLiteral("Number of resets, shrink and grow cycles and theme rounds."),
+                                    QStringLiteral("count"), QStringLiteral("5"));
+    parser.addOption(sizesOption);
+    parser.addOption(cyclesOption);
+    parser.process(app);
+
+    QList<int> sizes;
+    const QStringList sizeArgs = parser.value(sizesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for(const QString& size : sizeArgs)
+    {
+        bool ok = false;
+        const int value = size.toInt(&ok);
+        if(!ok || value < 4)
+            parser.showHelp(1);
+        sizes.append(value);
+    }
+    const int cycles = parser.value(cyclesOption).toInt();
+    if(sizes.isEmpty() || cycles <= 0)
+        parser.showHelp(1);
+
+    // the scene without a board: view, background, popups and clocks
+    const qint64 baseline = heapBytes();
+    KMinesScene scene(nullptr);
+    KMinesView view(&scene, nullptr);
+    view.resize(VIEW_SIZE);
+    view.show();
+    settle();
+
+    // the probe atlas is gone before anything is measured
+    qint64 borderCost = 0;
+    {
+        SpriteAtlas atlas(&scene.renderer());
+        borderCost = borderItemCost(&atlas);
+    }
+
+    Report report(&scene, baseline);
+    BoardCost board;
+    report.measure(QStringLiteral("scene"), board);
+    for(int size : std::as_const(sizes))
+    {
+        board = newGame(&scene, size, borderCost);
+        report.measure(QStringLiteral("init %1x%1").arg(size), board);
+    }
+
+    // the same board replayed must not grow
+    board.freed = -1;
+    board.game = heapDelta(&scene, [&scene, cycles]() {
+        for(int i=0; i<cycles; ++i)
+        {
+            scene.reset();
+            settle();
+            clickCentre(&scene);
+            settle();
+        }
+    });
+    report.measure(QStringLiteral("resetMines x%1").arg(cycles), board);
+
+    // memory of big boards has to come back once they are left
+    for(int i=0; i<cycles; ++i)
+    {
+        board = newGame(&scene, sizes.first(), borderCost);
+        report.measure(QStringLiteral("shrink %1x%1").arg(sizes.first()), board);
+        board = newGame(&scene, sizes.last(), borderCost);
+        report.measure(QStringLiteral("grow %1x%1").arg(sizes.last()), board);
+    }
+
+    // themes only change pixmaps
+    board.freed = -1;
+    board.game = -1;
+    KgThemeProvider* provider = scene.renderer().themeProvider();
+    const QList<const KgTheme*> themes = provider->themes();
+    const KgTheme* initialTheme = provider->currentTheme();
+    for(int i=0; i<cycles; ++i)
+    {
+        for(const KgTheme* theme : themes)
+        {
+            provider->setCurrentTheme(theme);
+            settle();
+            report.measure(QStringLiteral("theme %1").arg(QString::fromUtf8(theme->identifier())), board);
+        }
+    }
+    provider->setCurrentTheme(initialTheme);
+    settle();
+    report.measure(QStringLiteral("theme %1").arg(QString::fromUtf8(initialTheme->identifier())), board);
+    return 0;
+}
@@ -0,0 +1,313 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Measures how long themes take to render: every cell and border sprite,
+// first and cached, at a range of cell sizes and device pixel ratios,
+// and a paint of a whole expert board the way MineFieldItem draws it.
+
+// own
+#include "fieldgenerator.h"
+#include "spriteatlas.h"
+// KDEGames
+#include <KGameRenderer>
+#include <KgTheme>
+// Qt
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QTextStream>
+// Std
+#include <algorithm>
+
+// keep in sync with CellItem::fillNameHashes() and BorderItem::fillNameHash()
+static const char* const CELL_KEYS[] = {
+    "cell_up", "cell_down", "flag", "question", "mine", "error", "explosion", "hint"
+};
+static const char* const DIGIT_KEYS[] = {
+    "arabicOne", "arabicTwo", "arabicThree", "arabicFour",
+    "arabicFive", "arabicSix", "arabicSeven", "arabicEight"
+};
+static const char* const BORDER_KEYS[] = {
+    "border.edge.north", "border.edge.south", "border.edge.east", "border.edge.west",
+    "border.outsideCorner.ne", "border.outsideCorner.nw",
+    "border.outsideCorner.sw", "border.outsideCorner.se",
+    "border.insideCorner.ne", "border.insideCorner.nw",
+    "border.insideCorner.sw", "border.insideCorner.se",
+    "border.bay.north", "border.bay.south", "border.bay.east", "border.bay.west"
+};
+
+// the expert level
+static const int BOARD_ROWS = 16;
+static const int BOARD_COLS = 30;
+static const int BOARD_MINES = 99;
+
+namespace
+{
+
+struct Options
+{
+    QList<int> sizes;
+    QList<qreal> ratios;
+    int repeat = 0;
+};
+
+/**
+ * Sprites of one square of the board, bottom layer first
+ */
+struct Square
+{
+    int row;
+    int col;
+    QStringList keys;
+};
+
+qint64 median(QVector<qint64> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.at(values.size()/2);
+}
+
+/**
+ * Expert board shortly before it is won: digits revealed and mines
+ * flagged, so that every square draws two layers, with its border
+ */
+QVector<Square> boardSquares()
+{
+    const QVector<qint8> field = FieldGenerator::generate(BOARD_ROWS, BOARD_COLS, BOARD_MINES,
+                                                          BOARD_ROWS/2*BOARD_COLS + BOARD_COLS/2, 1);
+    QVector<Square> squares;
+    for(int row=0; row<BOARD_ROWS; ++row)
+        for(int col=0; col<BOARD_COLS; ++col)
+        {
+            const qint8 value = field.at(row*BOARD_COLS + col);
+            QStringList keys;
+            if(value == FieldGenerator::Mine)
+                keys = QStringList{QStringLiteral("cell_up"), QStringLiteral("flag")};
+            else
+            {
+                keys.append(QStringLiteral("cell_down"));
+                if(value > 0)
+                    keys.append(QLatin1String(DIGIT_KEYS[value - 1]));
+            }
+            squares.append(Square{row + 1, col + 1, keys});
+        }
+
+    for(int col=1; col<=BOARD_COLS; ++col)
+    {
+        squares.append(Square{0, col, QStringList(QStringLiteral("border.edge.north"))});
+        squares.append(Square{BOARD_ROWS + 1, col, QStringList(QStringLiteral("border.edge.south"))});
+    }
+    for(int row=1; row<=BOARD_ROWS; ++row)
+    {
+        squares.append(Square{row, 0, QStringList(QStringLiteral("border.edge.west"))});
+        squares.append(Square{row, BOARD_COLS + 1, QStringList(QStringLiteral("border.edge.east"))});
+    }
+    squares.append(Square{0, 0, QStringList(QStringLiteral("border.outsideCorner.nw"))});
+    squares.append(Square{0, BOARD_COLS + 1, QStringList(QStringLiteral("border.outsideCorner.ne"))});
+    squares.append(Square{BOARD_ROWS + 1, 0, QStringList(QStringLiteral("border.outsideCorner.sw"))});
+    squares.append(Square{BOARD_ROWS + 1, BOARD_COLS + 1, QStringList(QStringLiteral("border.outsideCorner.se"))});
+    return squares;
+}
+
+/**
+ * @return nanoseconds taken to paint the board with cells of given size in pixels
+ */
+qint64 paintBoard(SpriteAtlas* atlas, const QVector<Square>& squares, int cellSize, QImage* image)
+{
+    const QSize size(cellSize, cellSize);
+    QElapsedTimer timer;
+    timer.start();
+    QPainter painter(image);
+    for(const Square& square : squares)
+    {
+        const QPoint topLeft(square.col*cellSize, square.row*cellSize);
+        for(const QString& key : square.keys)
+            painter.drawPixmap(topLeft, atlas->spritePixmap(key, size));
+    }
+    painter.end();
+    return timer.nsecsElapsed();
+}
+
+KgTheme* loadTheme(const QString& desktopFile)
+{
+    KgTheme* theme = new KgTheme(QFileInfo(desktopFile).completeBaseName().toUtf8());
+    if(!theme->readFromDesktopFile(desktopFile))
+    {
+        delete theme;
+        return nullptr;
+    }
+    return theme;
+}
+
+/**
+ * Renderer of a single theme which really renders on a cache miss,
+ * instead of reading pixmaps left by an earlier run from disk
+ */
+KGameRenderer* createRenderer(KgTheme* theme)
+{
+    KGameRenderer* renderer = new KGameRenderer(theme);
+    renderer->setStrategyEnabled(KGameRenderer::UseDiskCache, false);
+    return renderer;
+}
+
+bool benchmarkTheme(const QString& desktopFile, const Options& options, QTextStream& out)
+{
+    const QString name = QFileInfo(desktopFile).completeBaseName();
+    const QVector<Square> squares = boardSquares();
+
+    // pixel sizes are rendered once per renderer, so every ratio gets fresh ones
+    for(qreal ratio : options.ratios)
+    {
+        KgTheme* theme = loadTheme(desktopFile);
+        KgTheme* boardTheme = loadTheme(desktopFile);
+        if(!theme || !boardTheme)
+        {
+            delete theme;
+            delete boardTheme;
+            QTextStream(stderr) << "Unable to load " << desktopFile << Qt::endl;
+            return false;
+        }
+        QScopedPointer<KGameRenderer> renderer(createRenderer(theme));
+        QScopedPointer<KGameRenderer> boardRenderer(createRenderer(boardTheme));
+        SpriteAtlas atlas(boardRenderer.data());
+
+        QElapsedTimer timer;
+        timer.start();
+        const bool loaded = renderer->spriteExists(QStringLiteral("cell_up"));
+        const qint64 loadTime = timer.nsecsElapsed();
+        if(!loaded)
+        {
+            QTextStream(stderr) << "No KMines sprites in " << desktopFile << Qt::endl;
+            return false;
+        }
+        out << name << '\t' << ratio << "\t-\tload\t" << loadTime/1000 << "\t-" << Qt::endl;
+
+        QStringList keys;
+        for(const char* key : CELL_KEYS)
+            keys.append(QLatin1String(key));
+        for(const char* key : DIGIT_KEYS)
+            keys.append(QLatin1String(key));
+        // themes may leave out the elements of shaped boards
+        for(const char* key : BORDER_KEYS)
+            if(renderer->spriteExists(QLatin1String(key)))
+                keys.append(QLatin1String(key));
+
+        for(int size : options.sizes)
+        {
+            const int pixels = qRound(size*ratio);
+            const QSize pixelSize(pixels, pixels);
+            for(const QString& key : std::as_const(keys))
+            {
+                timer.restart();
+                renderer->spritePixmap(key, pixelSize);
+                const qint64 first = timer.nsecsElapsed();
+                QVector<qint64> cached;
+                for(int i=0; i<options.repeat; ++i)
+                {
+                    timer.restart();
+                    renderer->spritePixmap(key, pixelSize);
+                    cached.append(timer.nsecsElapsed());
+                }
+                out << name << '\t' << ratio << '\t' << size << '\t' << key << '\t'
+                    << first/1000 << '\t' << median(cached)/1000.0 << Qt::endl;
+            }
+
+            QImage image((BOARD_COLS + 2)*pixels, (BOARD_ROWS + 2)*pixels, QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+            const qint64 first = paintBoard(&atlas, squares, pixels, &image);
+            QVector<qint64> cached;
+            for(int i=0; i<options.repeat; ++i)
+                cached.append(paintBoard(&atlas, squares, pixels, &image));
+            out << name << '\t' << ratio << '\t' << size << "\tboard\t"
+                << first/1000 << '\t' << median(cached)/1000.0 << Qt::endl;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    // pixmaps need a GUI application, but no display
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    // lets SpriteAtlas find the installed atlases, as in the game
+    QCoreApplication::setApplicationName(QStringLiteral("kmines"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures rendering times of KMines themes"));
+    parser.addHelpOption();
+    QCommandLineOption sizesOption(QStringLiteral("sizes"),
+                                   QStringLiteral("Comma separated list of cell sizes."),
+                                   QStringLiteral("sizes"), QStringLiteral("16,24,32,48,64,96,128,192,256"));
+    QCommandLineOption ratiosOption(QStringLiteral("ratios"),
+                                    QStringLiteral("Comma separated list of device pixel ratios."),
+                                    QStringLiteral("ratios"), QStringLiteral("1,1.5,2"));
+    QCommandLineOption repeatOption(QStringLiteral("repeat"),
+                                    QStringLiteral("Number of cached renders, the median is reported."),
+                                    QStringLiteral("count"), QStringLiteral("21"));
+    parser.addOption(sizesOption);
+    parser.addOption(ratiosOption);
+    parser.addOption(repeatOption);
+    parser.addPositionalArgument(QStringLiteral("themes"),
+                                 QStringLiteral("Theme .desktop files, or folders holding them."),
+                                 QStringLiteral("themes..."));
+    parser.process(app);
+
+    Options options;
+    const QStringList sizeArgs = parser.value(sizesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for(const QString& size : sizeArgs)
+    {
+        bool ok = false;
+        const int value = size.toInt(&ok);
+        if(!ok || value <= 0)
+            parser.showHelp(1);
+        options.sizes.append(value);
+    }
+    const QStringList ratioArgs = parser.value(ratiosOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for(const QString& ratio : ratioArgs)
+    {
+        bool ok = false;
+        const qreal value = ratio.toDouble(&ok);
+        if(!ok || value <= 0)
+            parser.showHelp(1);
+        options.ratios.append(value);
+    }
+    options.repeat = parser.value(repeatOption).toInt();
+    if(options.sizes.isEmpty() || options.ratios.isEmpty() || options.repeat <= 0
+       || parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    QStringList desktopFiles;
+    for(const QString& argument : parser.positionalArguments())
+    {
+        const QFileInfo info(argument);
+        if(!info.isDir())
+        {
+            desktopFiles.append(argument);
+            continue;
+        }
+        const QDir dir(argument);
+        const QStringList entries = dir.entryList(QStringList(QStringLiteral("*.desktop")), QDir::Files, QDir::Name);
+        for(const QString& entry : entries)
+            desktopFiles.append(dir.filePath(entry));
+    }
+
+    // times in microseconds, cached ones are medians
+    QTextStream out(stdout);
+    out << "theme\tratio\tsize\titem\tfirst\tcached" << Qt::endl;
+    for(const QString& desktopFile : std::as_const(desktopFiles))
+    {
+        if(!benchmarkTheme(desktopFile, options, out))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,621 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Replays recorded games on all cores and grades every move against
+// the solver, then sums up the grades and the efficiency of each player.
+
+// own
+#include "boardmetrics.h"
+#include "boardtopology.h"
+#include "fieldgenerator.h"
+#include "gamerecord.h"
+#include "solver.h"
+// Qt
+#include <QCache>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QThreadStorage>
+
+// games replayed by one task
+static const int BATCH_SIZE = 16;
+// positions cached by each thread, openings of shared boards repeat a lot
+static const int CACHE_SIZE = 4096;
+// guesses this close to the best odds are as good as the best one
+static const float GUESS_TOLERANCE = 0.01f;
+
+namespace
+{
+
+enum Grade { Safe, ForcedGuess, OptimalGuess, Blunder, Wasted, Flag, WrongFlag, GradeCount };
+
+const char* const GRADE_NAMES[GradeCount] = {
+    "safe", "forced guess", "optimal guess", "blunder", "wasted", "flag", "wrong flag"
+};
+const char* const MOVE_NAMES[] = { "reveal", "chord", "mark" };
+
+struct GradedMove
+{
+    Grade grade = Safe;
+    /**
+     * Probability of the clicked cell to hold a mine and lowest one of
+     * all covered cells, -1 if not analysed
+     */
+    float probability = -1;
+    float bestProbability = -1;
+    /**
+     * Set if the game revealed or flagged other cells than the replay
+     */
+    bool mismatch = false;
+};
+
+struct GradedGame
+{
+    QString fileName;
+    GameRecord record;
+    QVector<GradedMove> moves;
+    int bbbv = 0;
+    bool won = false;
+    int mismatches = 0;
+    int inexact = 0;
+};
+
+/**
+ * Board played by the rules of MineFieldItem, including cascades
+ * and the automatic reveals and flags of updateTrivials()
+ */
+class Replay
+{
+public:
+    explicit Replay(const GameRecord& record);
+
+    /**
+     * @return board as the player saw it, as analysed by Solver
+     */
+    QVector<qint8> view() const;
+    const QVector<qint8>& field() const { return m_field; }
+    const BoardTopology& topology() const { return m_topology; }
+    bool isCovered(int idx) const { return m_state.at(idx) == Released; }
+    /**
+     * @return false for cells whose mark can't change
+     */
+    bool isMarkable(int idx) const { return !isRevealed(idx) && !m_trivial.at(idx); }
+    bool isOver() const { return m_lost || m_won; }
+    bool isWon() const { return m_won; }
+    bool isOpened() const { return m_numUnrevealed < m_field.size(); }
+    /**
+     * @return cells a chord on idx reveals, empty if it does nothing
+     */
+    QVector<int> chordCells(int idx) const;
+
+    /**
+     * Plays a move, revealed() and flagged() tell what it changed
+     */
+    void play(const GameRecord::Move& move);
+    int revealed() const { return m_revealed; }
+    int flagged() const { return m_flagged; }
+
+private:
+    enum State : quint8 { Released, Revealed, Flagged, Questioned, Error };
+
+    bool isRevealed(int idx) const { return m_state.at(idx) == Revealed || m_state.at(idx) == Error; }
+    bool isMine(int idx) const { return m_field.at(idx) == FieldGenerator::Mine; }
+    void reveal(int idx);
+    void onRevealed(int idx);
+    void revealEmptySpace(int idx);
+    void queueTrivials(int idx);
+    void updateTrivials(int idx);
+    void flag(int idx, bool trivial);
+
+    BoardTopology m_topology;
+    QVector<qint8> m_field;
+    QVector<State> m_state;
+    QVector<char> m_trivial;
+    QVector<int> m_trivialQueue;
+    bool m_questionMarks;
+    int m_numMines;
+    int m_numUnrevealed;
+    int m_numFlagged = 0;
+    bool m_lost = false;
+    bool m_won = false;
+    int m_revealed = 0;
+    int m_flagged = 0;
+};
+
+Replay::Replay(const GameRecord& record)
+    : m_topology(BoardTopology::Square, record.board.numRows(), record.board.numCols()),
+      m_field(record.board.field()), m_state(m_field.size(), Released), m_trivial(m_field.size(), 0),
+      m_questionMarks(record.questionMarks), m_numMines(record.board.numMines()),
+      m_numUnrevealed(m_field.size())
+{
+}
+
+QVector<qint8> Replay::view() const
+{
+    QVector<qint8> cells(m_field.size());
+    for(int idx=0; idx<cells.size(); ++idx)
+    {
+        if(m_state.at(idx) == Flagged)
+            cells[idx] = Solver::Flagged;
+        else if(isRevealed(idx) && !isMine(idx))
+            cells[idx] = m_field.at(idx);
+        else
+            cells[idx] = Solver::Covered;
+    }
+    return cells;
+}
+
+QVector<int> Replay::chordCells(int idx) const
+{
+    QVector<int> cells;
+    if(!isRevealed(idx))
+        return cells;
+    int numFlags = 0;
+    int numMines = 0;
+    m_topology.forNeighbours(idx, [&](int other) {
+        numFlags += m_state.at(other) == Flagged;
+        numMines += isMine(other);
+    });
+    if(numFlags != numMines || numFlags == 0)
+        return cells;
+    m_topology.forNeighbours(idx, [&](int other) {
+        if(m_state.at(other) == Released)
+            cells.append(other);
+    });
+    return cells;
+}
+
+void Replay::play(const GameRecord::Move& move)
+{
+    const int unrevealedBefore = m_numUnrevealed;
+    const int flaggedBefore = m_numFlagged;
+    switch(move.kind)
+    {
+        case GameRecord::Reveal:
+            if(m_state.at(move.cell) == Released)
+                onRevealed(move.cell);
+            break;
+        case GameRecord::Chord:
+            for(int idx : chordCells(move.cell))
+            {
+                // an earlier cell of the chord may have opened it
+                if(isRevealed(idx))
+                    continue;
+                onRevealed(idx);
+                if(isOver())
+                    break;
+            }
+            break;
+        case GameRecord::Mark:
+            if(m_trivial.at(move.cell))
+                break;
+            switch(m_state.at(move.cell))
+            {
+                case Released:
+                    flag(move.cell, false);
+                    break;
+                case Flagged:
+                    m_state[move.cell] = m_questionMarks ? Questioned : Released;
+                    m_numFlagged--;
+                    break;
+                case Questioned:
+                    m_state[move.cell] = Released;
+                    break;
+                default:
+                    break;
+            }
+            break;
+    }
+    m_revealed = unrevealedBefore - m_numUnrevealed;
+    m_flagged = m_numFlagged - flaggedBefore;
+}
+
+void Replay::reveal(int idx)
+{
+    m_state[idx] = m_state.at(idx) == Flagged && !isMine(idx) ? Error : Revealed;
+    m_numUnrevealed--;
+}
+
+void Replay::onRevealed(int idx)
+{
+    reveal(idx);
+    if(isMine(idx))
+    {
+        m_lost = true;
+        return;
+    }
+    if(m_field.at(idx) == 0)
+        revealEmptySpace(idx);
+    queueTrivials(idx);
+    while(!m_trivialQueue.isEmpty())
+        updateTrivials(m_trivialQueue.takeLast());
+    m_won = m_numUnrevealed == m_numMines;
+}
+
+void Replay::revealEmptySpace(int start)
+{
+    QVector<int> queue;
+    queue.append(start);
+    for(int head=0; head<queue.size(); ++head)
+    {
+        m_topology.forNeighbours(queue.at(head), [&](int idx) {
+            if(isRevealed(idx) || m_state.at(idx) == Flagged || m_state.at(idx) == Questioned)
+                return;
+            reveal(idx);
+            if(m_field.at(idx) == 0)
+                queue.append(idx);
+            else
+                queueTrivials(idx);
+        });
+    }
+}
+
+void Replay::queueTrivials(int center)
+{
+    auto queueCell = [this](int idx) {
+        if(isRevealed(idx) && !isMine(idx) && m_field.at(idx) != 0)
+            m_trivialQueue.append(idx);
+    };
+    queueCell(center);
+    m_topology.forNeighbours(center, queueCell);
+}
+
+void Replay::updateTrivials(int center)
+{
+    const int digit = m_field.at(center);
+    if(digit == 0)
+        return;
+
+    QVector<int> undecided;
+    int flagged = 0;
+    m_topology.forNeighbours(center, [&](int idx) {
+        if(isRevealed(idx))
+            return;
+        if(m_trivial.at(idx))
+            flagged++;
+        else
+            undecided.append(idx);
+    });
+
+    if(flagged == digit)
+    {
+        for(int idx : std::as_const(undecided))
+        {
+            if(isRevealed(idx))
+                continue;
+            reveal(idx);
+            if(m_field.at(idx) == 0)
+                revealEmptySpace(idx);
+            queueTrivials(idx);
+        }
+    }
+    if(flagged + undecided.size() == digit)
+    {
+        for(int idx : std::as_const(undecided))
+        {
+            flag(idx, true);
+            queueTrivials(idx);
+        }
+    }
+}
+
+void Replay::flag(int idx, bool trivial)
+{
+    if(m_state.at(idx) != Flagged)
+        m_numFlagged++;
+    m_state[idx] = Flagged;
+    if(trivial)
+        m_trivial[idx] = 1;
+}
+
+/**
+ * Analysis of the position, cached per thread. Flags don't
+ * change the analysis, so they are left out of the key
+ */
+const BoardAnalysis& analyse(const Replay& replay, int numMines)
+{
+    static QThreadStorage<QCache<QByteArray, BoardAnalysis>*> caches;
+    if(!caches.hasLocalData())
+        caches.setLocalData(new QCache<QByteArray, BoardAnalysis>(CACHE_SIZE));
+    QCache<QByteArray, BoardAnalysis>* cache = caches.localData();
+
+    QVector<qint8> cells = replay.view();
+    for(qint8& cell : cells)
+    {
+        if(cell == Solver::Flagged)
+            cell = Solver::Covered;
+    }
+    QByteArray key(reinterpret_cast<const char*>(cells.constData()), cells.size());
+    key += QByteArray::number(replay.topology().numCols()) + ':' + QByteArray::number(numMines);
+
+    BoardAnalysis* analysis = cache->object(key);
+    if(!analysis)
+    {
+        analysis = new BoardAnalysis(Solver::analyse(replay.topology(), numMines, cells));
+        cache->insert(key, analysis);
+    }
+    return *analysis;
+}
+
+GradedGame grade(const QString& fileName)
+{
+    GradedGame game;
+    game.fileName = fileName;
+    game.record = GameRecord::load(fileName);
+    if(!game.record.isValid())
+        return game;
+
+    const int numMines = game.record.board.numMines();
+    Replay replay(game.record);
+    game.bbbv = BoardMetrics::compute(replay.topology(), replay.field()).bbbv;
+
+    // boards loaded from a code start with the first click opened by the game,
+    // generated ones with marks made before the first click, if any
+    const QVector<GameRecord::Move>& moves = game.record.moves;
+    if(game.record.opened && game.record.board.clickedIdx() >= 0)
+    {
+        GameRecord::Move opening;
+        opening.cell = game.record.board.clickedIdx();
+        replay.play(opening);
+    }
+
+    for(const GameRecord::Move& move : moves)
+    {
+        if(replay.isOver())
+            break;
+
+        GradedMove graded;
+        QVector<int> cells;
+        if(move.kind == GameRecord::Reveal && replay.isCovered(move.cell))
+            cells.append(move.cell);
+        else if(move.kind == GameRecord::Chord)
+            cells = replay.chordCells(move.cell);
+        else if(move.kind == GameRecord::Mark)
+            graded.grade = replay.isMarkable(move.cell) ? Flag : Wasted;
+
+        if(move.kind != GameRecord::Mark && cells.isEmpty())
+            graded.grade = Wasted;
+        else if(replay.isOpened() && graded.grade != Wasted)
+        {
+            // the first reveal is always safe, the board is made around it
+            const BoardAnalysis& analysis = analyse(replay, numMines);
+            if(!analysis.exact)
+                game.inexact++;
+            const QVector<qint8> view = replay.view();
+
+            // flagged cells can't be opened, so they are no alternative
+            float best = 1;
+            for(int idx=0; idx<view.size(); ++idx)
+            {
+                if(view.at(idx) == Solver::Covered)
+                    best = qMin(best, analysis.mineProbability.at(idx));
+            }
+            const bool safeLeft = best == 0;
+            bool equal = true;
+            for(int idx=0; idx<view.size() && equal; ++idx)
+            {
+                if(view.at(idx) == Solver::Covered && analysis.mineProbability.at(idx) > best + GUESS_TOLERANCE)
+                    equal = false;
+            }
+            float worst = 0;
+            for(int idx : std::as_const(cells))
+                worst = qMax(worst, analysis.mineProbability.at(idx));
+            if(move.kind == GameRecord::Mark)
+                worst = analysis.mineProbability.at(move.cell);
+            graded.probability = worst;
+            graded.bestProbability = best;
+
+            if(move.kind == GameRecord::Mark)
+                graded.grade = worst == 0 && replay.isCovered(move.cell) ? WrongFlag : Flag;
+            else if(worst == 0)
+                graded.grade = Safe;
+            else if(safeLeft || move.kind == GameRecord::Chord || worst > best + GUESS_TOLERANCE)
+                graded.grade = Blunder;
+            else
+                graded.grade = equal ? ForcedGuess : OptimalGuess;
+        }
+
+        replay.play(move);
+        // losing moves also show the mines, the game counts those
+        if(!(replay.isOver() && !replay.isWon())
+           && (replay.revealed() != move.revealed || replay.flagged() != move.flagged))
+        {
+            graded.mismatch = true;
+            game.mismatches++;
+        }
+        game.moves.append(graded);
+    }
+    game.won = replay.isWon();
+    return game;
+}
+
+struct PlayerStats
+{
+    int games = 0;
+    int won = 0;
+    int clicks = 0;
+    int grades[GradeCount] = {};
+    int mismatches = 0;
+    // won games only, a lost game has no final time
+    qint64 wonBbbv = 0;
+    qint64 wonClicks = 0;
+    qint64 wonTime = 0;
+};
+
+QJsonObject toJson(const QString& player, const PlayerStats& stats)
+{
+    QJsonObject object;
+    object[QStringLiteral("player")] = player;
+    object[QStringLiteral("games")] = stats.games;
+    object[QStringLiteral("won")] = stats.won;
+    object[QStringLiteral("clicks")] = stats.clicks;
+    QJsonObject grades;
+    for(int grade=0; grade<GradeCount; ++grade)
+        grades[QLatin1String(GRADE_NAMES[grade])] = stats.grades[grade];
+    object[QStringLiteral("grades")] = grades;
+    // 3BV per click and per second of won games
+    object[QStringLiteral("efficiency")] = stats.wonClicks > 0 ? double(stats.wonBbbv) / stats.wonClicks : 0.0;
+    object[QStringLiteral("bbbvPerSecond")] = stats.wonTime > 0 ? stats.wonBbbv * 1000.0 / stats.wonTime : 0.0;
+    object[QStringLiteral("mismatches")] = stats.mismatches;
+    return object;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Grades the moves of recorded KMines games"));
+    parser.addHelpOption();
+    QCommandLineOption csvOption(QStringLiteral("csv"), QStringLiteral("Write the grade of every move to file."),
+                                 QStringLiteral("file"));
+    QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("Write statistics of players and games to file."),
+                                  QStringLiteral("file"));
+    QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("Number of worker threads, all cores by default."),
+                                     QStringLiteral("threads"));
+    parser.addOption(csvOption);
+    parser.addOption(jsonOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument(QStringLiteral("directory"), QStringLiteral("Folder with recorded games, searched recursively."));
+    parser.process(app);
+    if(parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    QStringList fileNames;
+    QDirIterator it(parser.positionalArguments().first(),
+                    QStringList{QLatin1String("*.") + GameRecord::fileSuffix()},
+                    QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext())
+        fileNames.append(it.next());
+    fileNames.sort();
+
+    QThreadPool pool;
+    if(parser.isSet(threadsOption))
+        pool.setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+
+    QElapsedTimer timer;
+    timer.start();
+    // every task writes its own games, no locking needed
+    QVector<GradedGame> games(fileNames.size());
+    GradedGame* results = games.data();
+    for(int first=0; first<fileNames.size(); first+=BATCH_SIZE)
+    {
+        const int last = qMin(first + BATCH_SIZE, int(fileNames.size()));
+        pool.start([&fileNames, results, first, last]() {
+            for(int i=first; i<last; ++i)
+                results[i] = grade(fileNames.at(i));
+        });
+    }
+    pool.waitForDone();
+
+    QMap<QString, PlayerStats> players;
+    int invalid = 0;
+    for(const GradedGame& game : std::as_const(games))
+    {
+        if(!game.record.isValid())
+        {
+            QTextStream(stderr) << "Skipping malformed record " << game.fileName << Qt::endl;
+            invalid++;
+            continue;
+        }
+        PlayerStats& stats = players[game.record.player];
+        stats.games++;
+        stats.clicks += game.moves.size();
+        stats.mismatches += game.mismatches;
+        for(const GradedMove& move : game.moves)
+            stats.grades[move.grade]++;
+        if(game.won)
+        {
+            stats.won++;
+            stats.wonBbbv += game.bbbv;
+            stats.wonClicks += game.moves.size();
+            stats.wonTime += game.record.moves.isEmpty() ? 0 : game.record.moves.last().time;
+        }
+    }
+
+    if(parser.isSet(csvOption))
+    {
+        QFile file(parser.value(csvOption));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            QTextStream(stderr) << "Unable to write " << file.fileName() << Qt::endl;
+            return 1;
+        }
+        QTextStream csv(&file);
+        csv << "file,player,move,time,kind,row,col,grade,probability,best_probability,mismatch\n";
+        for(const GradedGame& game : std::as_const(games))
+        {
+            const int numCols = game.record.board.numCols();
+            for(int i=0; i<game.moves.size(); ++i)
+            {
+                const GameRecord::Move& move = game.record.moves.at(i);
+                const GradedMove& graded = game.moves.at(i);
+                csv << '"' << QString(game.fileName).replace(QLatin1Char('"'), QLatin1String("\"\"")) << "\","
+                    << '"' << QString(game.record.player).replace(QLatin1Char('"'), QLatin1String("\"\"")) << "\","
+                    << i << ',' << move.time << ',' << MOVE_NAMES[move.kind] << ','
+                    << move.cell / numCols << ',' << move.cell % numCols << ','
+                    << GRADE_NAMES[graded.grade] << ',' << graded.probability << ','
+                    << graded.bestProbability << ',' << int(graded.mismatch) << '\n';
+            }
+        }
+    }
+
+    if(parser.isSet(jsonOption))
+    {
+        QJsonArray playerArray;
+        for(auto it = players.cbegin(); it != players.cend(); ++it)
+            playerArray.append(toJson(it.key(), it.value()));
+        QJsonArray gameArray;
+        for(const GradedGame& game : std::as_const(games))
+        {
+            if(!game.record.isValid())
+                continue;
+            QJsonObject object;
+            object[QStringLiteral("file")] = game.fileName;
+            object[QStringLiteral("player")] = game.record.player;
+            object[QStringLiteral("board")] = game.record.board.toString();
+            object[QStringLiteral("won")] = game.won;
+            object[QStringLiteral("bbbv")] = game.bbbv;
+            object[QStringLiteral("clicks")] = game.moves.size();
+            object[QStringLiteral("mismatches")] = game.mismatches;
+            object[QStringLiteral("inexactPositions")] = game.inexact;
+            gameArray.append(object);
+        }
+        QJsonObject root;
+        root[QStringLiteral("players")] = playerArray;
+        root[QStringLiteral("games")] = gameArray;
+
+        QFile file(parser.value(jsonOption));
+        if(!file.open(QIODevice::WriteOnly))
+        {
+            QTextStream(stderr) << "Unable to write " << file.fileName() << Qt::endl;
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    QTextStream out(stdout);
+    for(auto it = players.cbegin(); it != players.cend(); ++it)
+    {
+        const PlayerStats& stats = it.value();
+        out << it.key() << ": " << stats.won << "/" << stats.games << " won, "
+            << stats.grades[Blunder] << " blunders in " << stats.clicks << " clicks, "
+            << stats.mismatches << " mismatches" << Qt::endl;
+    }
+    out << "Graded " << games.size() - invalid << " games in " << timer.elapsed() << " ms using "
+        << pool.maxThreadCount() << " threads" << Qt::endl;
+    return 0;
+}
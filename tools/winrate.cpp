@@ -0,0 +1,301 @@
+/*
+    SPDX-FileCopyrightText: 2026 KMines contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Estimates the chance to win boards of given sizes and mine counts by
+// letting the solver play games on all cores, until the estimate is
+// precise enough.
+
+// own
+#include "boardtopology.h"
+#include "fieldgenerator.h"
+#include "solver.h"
+// Qt
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThreadPool>
+// Std
+#include <cmath>
+
+// games played by one task between two looks at the estimate
+static const int BATCH_SIZE = 32;
+// the interval is not trusted before that many games
+static const int MINIMAL_GAMES = 400;
+
+namespace
+{
+
+enum Strategy
+{
+    /**
+     * Opens every cell proven safe, otherwise the one least likely to hold a mine
+     */
+    Safest,
+    /**
+     * Opens every cell proven safe, otherwise any cell not proven to be a mine
+     */
+    RandomGuess
+};
+
+struct Config
+{
+    int numRows = 0;
+    int numCols = 0;
+    int numMines = 0;
+};
+
+/**
+ * Parses "ROWSxCOLS:MINES", or "ROWSxCOLS:DENSITY" with a density below 1
+ */
+Config parseConfig(const QString& text)
+{
+    static const QRegularExpression pattern(QStringLiteral("^(\\d+)x(\\d+):(\\d+(?:\\.\\d*)?)$"));
+    const QRegularExpressionMatch match = pattern.match(text);
+    Config config;
+    if(!match.hasMatch())
+        return config;
+    config.numRows = match.captured(1).toInt();
+    config.numCols = match.captured(2).toInt();
+    const double mines = match.captured(3).toDouble();
+    config.numMines = mines < 1 ? qRound(mines * config.numRows * config.numCols) : qRound(mines);
+    // same limits as MineFieldItem::initField()
+    if(config.numRows <= 0 || config.numCols <= 0 || config.numMines <= 0
+       || config.numMines > config.numRows*config.numCols - FieldGenerator::MINIMAL_FREE)
+        return Config();
+    return config;
+}
+
+/**
+ * Plays one game the way MineFieldItem generates it: the board is
+ * made around the first click, which opens an empty area
+ *
+ * @param firstClick cell clicked first, random if -1
+ * @return true if the game was won
+ */
+bool play(const Config& config, const BoardTopology& topology, Strategy strategy,
+          int firstClick, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    const int numCells = config.numRows*config.numCols;
+    const int clickedIdx = firstClick >= 0 ? firstClick : random.bounded(numCells);
+    const QVector<qint8> field = FieldGenerator::generate(config.numRows, config.numCols, config.numMines,
+                                                          clickedIdx, random.generate());
+
+    QVector<qint8> view(numCells, Solver::Covered);
+    int covered = numCells;
+    QVector<int> queue;
+    auto open = [&](int start) {
+        queue.clear();
+        queue.append(start);
+        view[start] = field.at(start);
+        covered--;
+        for(int head=0; head<queue.size(); ++head)
+        {
+            if(view.at(queue.at(head)) != 0)
+                continue;
+            topology.forNeighbours(queue.at(head), [&](int idx) {
+                if(view.at(idx) != Solver::Covered)
+                    return;
+                view[idx] = field.at(idx);
+                covered--;
+                queue.append(idx);
+            });
+        }
+    };
+
+    open(clickedIdx);
+    while(covered > config.numMines)
+    {
+        const BoardAnalysis analysis = Solver::analyse(config.numRows, config.numCols, config.numMines, view);
+
+        bool opened = false;
+        for(int idx : analysis.safeCells)
+        {
+            if(view.at(idx) == Solver::Covered)
+            {
+                open(idx);
+                opened = true;
+            }
+        }
+        if(opened)
+            continue;
+
+        // a guess, ties are broken at random so that no corner of the board is favoured
+        int guess = -1;
+        int candidates = 0;
+        float best = 1;
+        for(int idx=0; idx<numCells; ++idx)
+        {
+            const float p = analysis.mineProbability.at(idx);
+            if(view.at(idx) != Solver::Covered || p >= 1)
+                continue;
+            if(strategy == Safest && p < best)
+            {
+                best = p;
+                candidates = 0;
+            }
+            if(strategy == RandomGuess || p == best)
+            {
+                if(random.bounded(++candidates) == 0)
+                    guess = idx;
+            }
+        }
+        if(guess == -1 || field.at(guess) == FieldGenerator::Mine)
+            return false;
+        open(guess);
+    }
+    return true;
+}
+
+/**
+ * Wilson score interval of a win rate
+ */
+void interval(int wins, int games, double z, double* low, double* high)
+{
+    const double n = games;
+    const double p = wins / n;
+    const double z2 = z*z;
+    const double centre = (p + z2/(2*n)) / (1 + z2/n);
+    const double half = z * std::sqrt(p*(1 - p)/n + z2/(4*n*n)) / (1 + z2/n);
+    *low = qMax(0.0, centre - half);
+    *high = qMin(1.0, centre + half);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Estimates the win rate of KMines boards played by the solver"));
+    parser.addHelpOption();
+    QCommandLineOption gamesOption(QStringLiteral("games"), QStringLiteral("Maximal number of games per board."),
+                                   QStringLiteral("games"), QStringLiteral("100000"));
+    QCommandLineOption precisionOption(QStringLiteral("precision"),
+                                       QStringLiteral("Stop once the interval is at most this far from the estimate."),
+                                       QStringLiteral("precision"), QStringLiteral("0.005"));
+    QCommandLineOption confidenceOption(QStringLiteral("confidence"),
+                                        QStringLiteral("Confidence of the interval in percent, 90, 95 or 99."),
+                                        QStringLiteral("percent"), QStringLiteral("95"));
+    QCommandLineOption strategyOption(QStringLiteral("strategy"),
+                                      QStringLiteral("How to guess, \"safest\" or \"random\"."),
+                                      QStringLiteral("strategy"), QStringLiteral("safest"));
+    QCommandLineOption firstClickOption(QStringLiteral("first-click"),
+                                        QStringLiteral("Cell clicked first, \"random\", \"centre\" or \"corner\"."),
+                                        QStringLiteral("cell"), QStringLiteral("random"));
+    QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Seed of the first game, random by default."),
+                                  QStringLiteral("seed"));
+    QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("Number of worker threads, all cores by default."),
+                                     QStringLiteral("threads"));
+    parser.addOption(gamesOption);
+    parser.addOption(precisionOption);
+    parser.addOption(confidenceOption);
+    parser.addOption(strategyOption);
+    parser.addOption(firstClickOption);
+    parser.addOption(seedOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument(QStringLiteral("boards"),
+                                 QStringLiteral("Boards as ROWSxCOLS:MINES or ROWSxCOLS:DENSITY, e.g. 16x30:99 or 16x30:0.2."),
+                                 QStringLiteral("boards..."));
+    parser.process(app);
+
+    QVector<Config> configs;
+    for(const QString& argument : parser.positionalArguments())
+    {
+        const Config config = parseConfig(argument);
+        if(config.numMines == 0)
+        {
+            QTextStream(stderr) << "Invalid board " << argument << Qt::endl;
+            return 1;
+        }
+        configs.append(config);
+    }
+
+    const int maxGames = parser.value(gamesOption).toInt();
+    const double precision = parser.value(precisionOption).toDouble();
+    const int confidence = parser.value(confidenceOption).toInt();
+    const double z = confidence == 90 ? 1.645 : confidence == 95 ? 1.960 : confidence == 99 ? 2.576 : 0;
+    const QString strategyName = parser.value(strategyOption);
+    const QString firstClickName = parser.value(firstClickOption);
+    if(configs.isEmpty() || maxGames <= 0 || precision <= 0 || z == 0
+       || (strategyName != QLatin1String("safest") && strategyName != QLatin1String("random"))
+       || (firstClickName != QLatin1String("random") && firstClickName != QLatin1String("centre")
+           && firstClickName != QLatin1String("corner")))
+        parser.showHelp(1);
+    const Strategy strategy = strategyName == QLatin1String("safest") ? Safest : RandomGuess;
+    const quint32 seed = parser.isSet(seedOption) ? parser.value(seedOption).toUInt()
+                                                  : QRandomGenerator::global()->generate();
+
+    QThreadPool pool;
+    if(parser.isSet(threadsOption))
+        pool.setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+
+    QTextStream out(stdout);
+    out << "board\tmines\tgames\twon\trate\tlow\thigh\tms" << Qt::endl;
+    for(const Config& config : std::as_const(configs))
+    {
+        const BoardTopology topology(BoardTopology::Square, config.numRows, config.numCols);
+        const int firstClick = firstClickName == QLatin1String("centre") ? config.numRows/2*config.numCols + config.numCols/2
+                             : firstClickName == QLatin1String("corner") ? 0 : -1;
+
+        QElapsedTimer timer;
+        timer.start();
+        QAtomicInt next(0);
+        QAtomicInt stop(0);
+        QMutex mutex;
+        // batches are folded in in the order of their games, whichever thread
+        // finishes first, so that the stop rule sees the same games every run
+        QHash<int, int> finishedWins;
+        int folded = 0;
+        int games = 0;
+        int wins = 0;
+        for(int i=0; i<pool.maxThreadCount(); ++i)
+        {
+            pool.start([&]() {
+                while(!stop.loadAcquire())
+                {
+                    const int first = next.fetchAndAddOrdered(BATCH_SIZE);
+                    if(first >= maxGames)
+                        return;
+                    const int last = qMin(first + BATCH_SIZE, maxGames);
+                    int batchWins = 0;
+                    // every game has its own seed, so results don't depend on the threads
+                    for(int game=first; game<last; ++game)
+                        batchWins += play(config, topology, strategy, firstClick, seed + quint32(game));
+
+                    QMutexLocker locker(&mutex);
+                    finishedWins.insert(first / BATCH_SIZE, batchWins);
+                    while(!stop.loadRelaxed() && finishedWins.contains(folded))
+                    {
+                        const int foldedFirst = folded*BATCH_SIZE;
+                        games += qMin(foldedFirst + BATCH_SIZE, maxGames) - foldedFirst;
+                        wins += finishedWins.take(folded);
+                        folded++;
+                        double low, high;
+                        interval(wins, games, z, &low, &high);
+                        if(games >= MINIMAL_GAMES && (high - low)/2 <= precision)
+                            stop.storeRelease(1);
+                    }
+                }
+            });
+        }
+        pool.waitForDone();
+
+        double low, high;
+        interval(wins, games, z, &low, &high);
+        out << config.numRows << 'x' << config.numCols << '\t' << config.numMines << '\t'
+            << games << '\t' << wins << '\t' << double(wins)/games << '\t' << low << '\t' << high << '\t'
+            << timer.elapsed() << Qt::endl;
+    }
+    return 0;
+}